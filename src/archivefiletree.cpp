@@ -20,6 +20,9 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 // For QObject::tr:
 #include <QObject>
 
+#include <QHash>
+#include <QStringView>
+
 #include "archivefiletree.h"
 
 #include "log.h"
@@ -52,21 +55,143 @@ public:
   const int m_Index;
 };
 
+/**
+ * Flat description of the content of an archive, built once by makeTree() and shared
+ * by all the trees created from it.
+ *
+ * Each entry of the archive is a node with the index of its parent; intermediate
+ * directories that are not listed by the archive get a node with index -1. Children
+ * of each directory are sorted the same way IFileTree sorts its entries, so trees can
+ * be populated without any parsing or sorting.
+ */
+struct ArchiveLayout
+{
+  struct Node
+  {
+    QString name;
+    int parent;
+
+    // index of the entry in the archive, -1 if the archive doesn't list it
+    int index;
+
+    bool isDir;
+    std::vector<int> children;
+  };
+
+  // the root is the first node
+  std::vector<Node> nodes;
+
+  /**
+   * @brief Build the layout of the given archive entries in a single pass.
+   */
+  static std::shared_ptr<const ArchiveLayout>
+  build(std::vector<FileData*> const& data)
+  {
+    auto layout = std::make_shared<ArchiveLayout>();
+    auto& nodes = layout->nodes;
+
+    nodes.reserve(data.size() + 1);
+    nodes.push_back({"", -1, -1, true, {}});
+
+    // lowercase paths, the keys of the lookup below point into these strings:
+    std::vector<QString> lowered;
+    lowered.reserve(data.size());
+
+    // (parent, lowercase name) -> node
+    QHash<QPair<int, QStringView>, int> lookup;
+    lookup.reserve(static_cast<int>(data.size()));
+
+    for (size_t i = 0; i < data.size(); ++i) {
+      const auto& archivePath = data[i]->getArchiveFilePath();
+
+      // Ignore "." and ".." as they're useless and muck things up
+      if (archivePath.compare(L".") == 0 || archivePath.compare(L"..") == 0) {
+        continue;
+      }
+
+      const QString path = QString::fromStdWString(archivePath);
+      lowered.push_back(path.toLower());
+      const QStringView lower(lowered.back());
+
+      int node  = 0;
+      int start = 0;
+
+      while (start < path.size()) {
+        int end = start;
+        while (end < path.size() && path[end] != '/' && path[end] != '\\') {
+          ++end;
+        }
+
+        // empty components are skipped
+        if (end > start) {
+          const QPair<int, QStringView> key(node, lower.mid(start, end - start));
+          auto itor = lookup.constFind(key);
+
+          int child;
+
+          if (itor == lookup.constEnd()) {
+            child = static_cast<int>(nodes.size());
+            nodes.push_back({path.mid(start, end - start), node, -1, true, {}});
+            lookup.insert(key, child);
+
+            auto& parent = nodes[node];
+            if (!parent.isDir) {
+              // a file that's also used as a directory, keep the directory
+              parent.isDir = true;
+              parent.index = -1;
+            }
+
+            parent.children.push_back(child);
+          } else {
+            child = *itor;
+          }
+
+          node = child;
+        }
+
+        start = end + 1;
+      }
+
+      if (node != 0) {
+        auto& n = nodes[node];
+
+        // some archives list intermediate non-empty folders, some don't, so
+        // directories may or may not get an index
+        n.index = static_cast<int>(i);
+        n.isDir = data[i]->isDirectory() || !n.children.empty();
+      }
+    }
+
+    // same order as IFileTree: directories first, then by name
+    for (auto& n : nodes) {
+      std::sort(n.children.begin(), n.children.end(), [&nodes](int a, int b) {
+        const auto& na = nodes[a];
+        const auto& nb = nodes[b];
+
+        if (na.isDir != nb.isDir) {
+          return na.isDir;
+        }
+
+        return na.name.compare(nb.name, Qt::CaseInsensitive) < 0;
+      });
+    }
+
+    return layout;
+  }
+};
+
 /**
  *
  */
 class ArchiveFileTreeImpl : public virtual ArchiveFileTree,
                             public virtual ArchiveFileEntry
 {
-public:
-  using File = std::tuple<QStringList, bool, int>;
-
 public
     :  // Public for make_shared (but not accessible by other since not exposed in .h):
   ArchiveFileTreeImpl(std::shared_ptr<const IFileTree> parent, QString name, int index,
-                      std::vector<File> files)
+                      std::shared_ptr<const ArchiveLayout> layout, int node)
       : FileTreeEntry(parent, name), ArchiveFileEntry(parent, name, index), IFileTree(),
-        m_Files(std::move(files))
+        m_Layout(std::move(layout)), m_Node(node)
   {}
 
 public:  // Override to avoid VS warnings:
@@ -138,7 +263,7 @@ protected:
   virtual std::shared_ptr<IFileTree>
   makeDirectory(std::shared_ptr<const IFileTree> parent, QString name) const override
   {
-    return std::make_shared<ArchiveFileTreeImpl>(parent, name, -1, std::vector<File>{});
+    return std::make_shared<ArchiveFileTreeImpl>(parent, name, -1, nullptr, -1);
   }
 
   virtual std::shared_ptr<FileTreeEntry>
@@ -151,102 +276,47 @@ protected:
   doPopulate(std::shared_ptr<const IFileTree> parent,
              std::vector<std::shared_ptr<FileTreeEntry>>& entries) const override
   {
+    // Directories created after the tree have no node:
+    if (!m_Layout || m_Node < 0) {
+      return true;
+    }
 
-    // Sort by name:
-    std::sort(std::begin(m_Files), std::end(m_Files), [](const auto& a, const auto& b) {
-      return std::get<0>(a)[0].compare(std::get<0>(b)[0], Qt::CaseInsensitive) < 0;
-    });
-
-    // We know that the files are sorted:
-    QString currentName = "";
-    int currentIndex    = -1;
-    std::vector<File> currentFiles;
-    for (auto& p : m_Files) {
-
-      // At the start or if we have reset, just retrieve the current name:
-      if (currentName == "") {
-        currentName = std::get<0>(p)[0];
-      }
+    const auto& node = m_Layout->nodes[m_Node];
+    entries.reserve(node.children.size());
 
-      // If the name is different, we need to create a directory from what we have
-      // accumulated:
-      if (currentName != std::get<0>(p)[0]) {
+    for (const int c : node.children) {
+      const auto& child = m_Layout->nodes[c];
 
-        // We may or may not have an index here, it depends on the type of archive (some
-        // archives list intermediate non-empty folders, some don't):
+      if (child.isDir) {
         entries.push_back(std::make_shared<ArchiveFileTreeImpl>(
-            parent, currentName, currentIndex, std::move(currentFiles)));
-
-        currentFiles.clear();  // Back to a valid state.
-
-        // Reset the index:
-        currentIndex = -1;
-      }
-
-      // We can always override the current name:
-      currentName = std::get<0>(p)[0];
-
-      // If the current path contains only one components:
-      if (std::get<0>(p).size() == 1) {
-
-        // If it is not a directory, then it is a file in directly under this tree:
-        if (!std::get<1>(p)) {
-          entries.push_back(
-              std::make_shared<ArchiveFileEntry>(parent, currentName, std::get<2>(p)));
-          currentName = "";
-        } else {
-          // Otherwize, it is the actual "file" corresponding to the directory we are
-          // listing, so we can retrieve the index here:
-          currentIndex = std::get<2>(p);
-        }
+            parent, child.name, child.index, m_Layout, c));
       } else {
-        currentFiles.push_back(
-            {QStringList(std::get<0>(p).begin() + 1, std::get<0>(p).end()),
-             std::get<1>(p), std::get<2>(p)});
+        entries.push_back(
+            std::make_shared<ArchiveFileEntry>(parent, child.name, child.index));
       }
     }
 
-    if (currentName != "") {
-      entries.push_back(std::make_shared<ArchiveFileTreeImpl>(
-          parent, currentName, currentIndex, std::move(currentFiles)));
-    }
-
-    // Let the parent class sort the entries:
-    return false;
+    // Children are sorted when the layout is built:
+    return true;
   }
 
   virtual std::shared_ptr<IFileTree> doClone() const override
   {
-    return std::make_shared<ArchiveFileTreeImpl>(nullptr, name(), m_Index, m_Files);
+    return std::make_shared<ArchiveFileTreeImpl>(nullptr, name(), m_Index, m_Layout,
+                                                 m_Node);
   }
 
 private:
-  mutable std::vector<File> m_Files;
+  std::shared_ptr<const ArchiveLayout> m_Layout;
+
+  // node of this directory in the layout, -1 if it was not in the archive
+  int m_Node;
 };
 
 std::shared_ptr<ArchiveFileTree> ArchiveFileTree::makeTree(Archive const& archive)
 {
-  auto const& data = archive.getFileList();
-
-  std::vector<ArchiveFileTreeImpl::File> files;
-  files.reserve(data.size());
-
-  for (size_t i = 0; i < data.size(); ++i) {
-    // Ignore "." and ".." as they're useless and muck things up
-    if (data[i]->getArchiveFilePath().compare(L".") == 0 ||
-        data[i]->getArchiveFilePath().compare(L"..") == 0) {
-      continue;
-    }
-
-    files.push_back(
-        std::make_tuple(QString::fromStdWString(data[i]->getArchiveFilePath())
-                            .replace("\\", "/")
-                            .split("/", Qt::SkipEmptyParts),
-                        data[i]->isDirectory(), (int)i));
-  }
-
-  auto tree = std::make_shared<ArchiveFileTreeImpl>(nullptr, "", -1, std::move(files));
-  return tree;
+  auto layout = ArchiveLayout::build(archive.getFileList());
+  return std::make_shared<ArchiveFileTreeImpl>(nullptr, "", -1, std::move(layout), 0);
 }
 
 /**
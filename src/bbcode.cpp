@@ -18,19 +18,57 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "bbcode.h"
-#include <QRegularExpression>
-#include <log.h>
+#include <QCache>
+#include <QStringView>
+#include <functional>
 #include <map>
+#include <mutex>
+#include <vector>
 
 namespace BBCode
 {
 
-namespace log = MOBase::log;
+// converted descriptions are kept in a cache keyed by the bb code, its cost is
+// the number of characters of both strings
+constexpr int MaxCacheCost = 8 * 1024 * 1024;
 
 class BBCodeMap
 {
+  struct Tag
+  {
+    // html written when the tag is opened, given the argument of the tag
+    std::function<QString(const QString&)> open;
+
+    // html written when the tag is closed
+    QString close;
+
+    // for tags that need their content to build the html, such as [url]; the
+    // content is not written as it's converted but given to this when the tag
+    // is closed, along with the argument
+    std::function<QString(const QString&, const QString&)> wrap;
+
+    // whether the tag has no content and no closing tag, like [line]
+    bool single = false;
+
+    // whether the tag can have attributes after its name, like [img width=1]
+    bool attributes = false;
+  };
+
+  // a tag that has been opened but not closed yet
+  struct Frame
+  {
+    const Tag* tag;
+
+    // name without the '='
+    QString name;
 
-  typedef std::map<QString, std::pair<QRegularExpression, QString>> TagMap;
+    QString arg;
+
+    // position of the content in the output
+    int contentStart;
+  };
+
+  typedef std::map<QString, Tag> TagMap;
 
 public:
   static BBCodeMap& instance()
@@ -39,203 +77,295 @@ public:
     return s_Instance;
   }
 
-  QString convertTag(QString input, int& length)
+  // goes over the input once, tags are written as they're opened and closed,
+  // unclosed tags are closed at the end and stray closing tags are dropped
+  //
+  QString convert(const QString& input) const
   {
-    // extract the tag name
-    auto match      = m_TagNameExp.match(input, 1, QRegularExpression::NormalMatch,
-                                         QRegularExpression::AnchoredMatchOption);
-    QString tagName = match.captured(0).toLower();
-    TagMap::iterator tagIter = m_TagMap.find(tagName);
-    if (tagIter != m_TagMap.end()) {
-      // recognized tag
-      if (tagName.endsWith('=')) {
-        tagName.chop(1);
+    const QStringView in(input);
+
+    QString out;
+    out.reserve(input.size() + input.size() / 4);
+
+    std::vector<Frame> stack;
+    int lastBlock = 0;
+    int pos       = 0;
+
+    while ((pos = input.indexOf('[', lastBlock)) != -1) {
+      // append everything between the previous tag and the current one
+      out.append(input.constData() + lastBlock, pos - lastBlock);
+
+      // end of the tag, tags can't contain another '[' so this never looks
+      // further than the next one
+      int end = pos + 1;
+      while (end < input.size() && input[end] != ']' && input[end] != '[') {
+        ++end;
       }
 
-      int closeTagPos        = 0;
-      int nextTagPos         = 0;
-      int nextTagSearchIndex = input.indexOf("]");
-      int closeTagLength     = 0;
-      if (tagName == "*") {
-        // ends at the next bullet point
-        closeTagPos =
-            input.indexOf(QRegularExpression("(\\[\\*\\]|</ul>)",
-                                             QRegularExpression::CaseInsensitiveOption),
-                          3);
-        // leave closeTagLength at 0 because we don't want to "eat" the next bullet
-        // point
-      } else if (tagName == "line") {
-        // ends immediately after the tag
-        closeTagPos = 6;
-        // leave closeTagLength at 0 because there is no close tag to skip over
-      } else {
-        QRegularExpression nextTag(QString("\\[%1[=\\]]?").arg(tagName),
-                                   QRegularExpression::CaseInsensitiveOption);
-        QString closeTag = QString("[/%1]").arg(tagName);
-        closeTagPos      = input.indexOf(closeTag, 0, Qt::CaseInsensitive);
-        nextTagPos       = nextTag.match(input, nextTagSearchIndex).capturedStart(0);
-        while (nextTagPos != -1 && closeTagPos != -1 && nextTagPos < closeTagPos) {
-          closeTagPos        = input.indexOf(closeTag, closeTagPos + closeTag.size(),
-                                             Qt::CaseInsensitive);
-          nextTagSearchIndex = input.indexOf("]", nextTagPos);
-          nextTagPos = nextTag.match(input, nextTagSearchIndex).capturedStart(0);
-        }
-        if (closeTagPos == -1) {
-          // workaround to improve compatibility: add fake closing tag
-          input.append(closeTag);
-          closeTagPos = input.size() - closeTag.size();
-        }
-        closeTagLength = closeTag.size();
+      if (end >= input.size() || input[end] != ']') {
+        // not a tag
+        out.append('[');
+        lastBlock = pos + 1;
+        continue;
       }
 
-      if (closeTagPos > -1) {
-        length       = closeTagPos + closeTagLength;
-        QString temp = input.mid(0, length);
-        tagIter->second.first.setPatternOptions(
-            QRegularExpression::PatternOption::DotMatchesEverythingOption);
-        auto match = tagIter->second.first.match(temp);
-        if (match.hasMatch()) {
-          if (tagIter->second.second.isEmpty()) {
-            if (tagName == "color") {
-              QString color   = match.captured(1);
-              QString content = match.captured(2);
-              if (color.at(0) == '#') {
-                return temp.replace(tagIter->second.first,
-                                    QString("<font style=\"color: %1;\">%2</font>")
-                                        .arg(color, content));
-              } else {
-                auto colIter = m_ColorMap.find(color.toLower());
-                if (colIter != m_ColorMap.end()) {
-                  color = colIter->second;
-                }
-                return temp.replace(tagIter->second.first,
-                                    QString("<font style=\"color: #%1;\">%2</font>")
-                                        .arg(color, content));
-              }
-            } else {
-              log::warn("don't know how to deal with tag {}", tagName);
-            }
-          } else {
-            if (tagName == "*") {
-              temp.remove(QRegularExpression("(\\[/\\*\\])?(<br/>)?$"));
-            }
-            return temp.replace(tagIter->second.first, tagIter->second.second);
-          }
-        } else {
-          // expression doesn't match. either the input string is invalid
-          // or the expression is
-          log::warn("{} doesn't match the expression for {}", temp, tagName);
-          length = 0;
-          return QString();
-        }
+      if (input[pos + 1] == '/') {
+        closeTag(in.mid(pos + 2, end - pos - 2).trimmed().toString().toLower(), stack,
+                 out);
+      } else if (!openTag(in.mid(pos + 1, end - pos - 1), stack, out)) {
+        // nothing replaced
+        out.append('[');
+        lastBlock = pos + 1;
+        continue;
       }
+
+      lastBlock = end + 1;
     }
 
-    // not a recognized tag or tag invalid
-    length = 0;
-    return QString();
+    // append the remainder (everything after the last tag)
+    out.append(input.constData() + lastBlock, input.size() - lastBlock);
+
+    // workaround to improve compatibility: close everything that's still open
+    while (!stack.empty()) {
+      closeFrame(stack.back(), out);
+      stack.pop_back();
+    }
+
+    return out;
   }
 
 private:
-  BBCodeMap() : m_TagNameExp("[a-zA-Z*]*=?")
+  TagMap m_TagMap;
+  std::map<QString, QString> m_ColorMap;
+
+  // `text` is everything between the brackets; returns false if this is not a
+  // recognized tag
+  //
+  bool openTag(QStringView text, std::vector<Frame>& stack, QString& out) const
+  {
+    // extract the tag name
+    auto isNameChar = [](QChar c) {
+      return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '*';
+    };
+
+    int nameEnd = 0;
+    while (nameEnd < text.size() && isNameChar(text[nameEnd])) {
+      ++nameEnd;
+    }
+
+    QString name = text.left(nameEnd).toString().toLower();
+    QString arg;
+
+    const bool hasArg = (nameEnd < text.size() && text[nameEnd] == '=');
+
+    auto tagIter = m_TagMap.find(hasArg ? name + "=" : name);
+    if (tagIter == m_TagMap.end()) {
+      return false;
+    }
+
+    const Tag& tag = tagIter->second;
+
+    if (hasArg) {
+      arg = text.mid(nameEnd + 1).toString();
+    } else if (nameEnd < text.size()) {
+      // something else after the name
+      if (!tag.attributes || !text[nameEnd].isSpace()) {
+        return false;
+      }
+    }
+
+    if (tag.single) {
+      out.append(tag.open(arg));
+      return true;
+    }
+
+    if (name == "*") {
+      // a bullet point ends the previous one in the same list
+      closeItem(stack, out);
+    }
+
+    if (!tag.wrap) {
+      out.append(tag.open(arg));
+    }
+
+    stack.push_back(
+        {&tag, std::move(name), std::move(arg), static_cast<int>(out.size())});
+
+    return true;
+  }
+
+  // closes the innermost open tag with the given name and the ones opened after
+  // it, stray closing tags are dropped
+  //
+  void closeTag(const QString& name, std::vector<Frame>& stack, QString& out) const
+  {
+    for (std::size_t i = stack.size(); i > 0; --i) {
+      if (stack[i - 1].name == name) {
+        popTo(stack, i - 1, out);
+        return;
+      }
+    }
+  }
+
+  // closes the bullet point of the current list, if any
+  //
+  void closeItem(std::vector<Frame>& stack, QString& out) const
+  {
+    for (std::size_t i = stack.size(); i > 0; --i) {
+      const auto& name = stack[i - 1].name;
+
+      if (name == "*") {
+        popTo(stack, i - 1, out);
+        return;
+      }
+
+      if (name == "list" || name == "ul" || name == "ol") {
+        return;
+      }
+    }
+  }
+
+  // closes all the frames from the top of the stack down to the given index
+  //
+  void popTo(std::vector<Frame>& stack, std::size_t i, QString& out) const
   {
-    m_TagMap["b"] =
-        std::make_pair(QRegularExpression("\\[b\\](.*)\\[/b\\]"), "<b>\\1</b>");
-    m_TagMap["i"] =
-        std::make_pair(QRegularExpression("\\[i\\](.*)\\[/i\\]"), "<i>\\1</i>");
-    m_TagMap["u"] =
-        std::make_pair(QRegularExpression("\\[u\\](.*)\\[/u\\]"), "<u>\\1</u>");
-    m_TagMap["s"] =
-        std::make_pair(QRegularExpression("\\[s\\](.*)\\[/s\\]"), "<s>\\1</s>");
-    m_TagMap["sub"] =
-        std::make_pair(QRegularExpression("\\[sub\\](.*)\\[/sub\\]"), "<sub>\\1</sub>");
-    m_TagMap["sup"] =
-        std::make_pair(QRegularExpression("\\[sup\\](.*)\\[/sup\\]"), "<sup>\\1</sup>");
-    m_TagMap["size="] =
-        std::make_pair(QRegularExpression("\\[size=([^\\]]*)\\](.*)\\[/size\\]"),
-                       "<font size=\"\\1\">\\2</font>");
-    m_TagMap["color="] =
-        std::make_pair(QRegularExpression("\\[color=([^\\]]*)\\](.*)\\[/color\\]"), "");
-    m_TagMap["font="] =
-        std::make_pair(QRegularExpression("\\[font=([^\\]]*)\\](.*)\\[/font\\]"),
-                       "<font style=\"font-family: \\1;\">\\2</font>");
-    m_TagMap["center"] =
-        std::make_pair(QRegularExpression("\\[center\\](.*)\\[/center\\]"),
-                       "<div align=\"center\">\\1</div>");
-    m_TagMap["right"] =
-        std::make_pair(QRegularExpression("\\[right\\](.*)\\[/right\\]"),
-                       "<div align=\"right\">\\1</div>");
-    m_TagMap["quote"] =
-        std::make_pair(QRegularExpression("\\[quote\\](.*)\\[/quote\\]"),
-                       "<figure class=\"quote\"><blockquote>\\1</blockquote></figure>");
-    m_TagMap["quote="] =
-        std::make_pair(QRegularExpression("\\[quote=([^\\]]*)\\](.*)\\[/quote\\]"),
-                       "<figure class=\"quote\"><blockquote>\\2</blockquote></figure>");
-    m_TagMap["spoiler"] =
-        std::make_pair(QRegularExpression("\\[spoiler\\](.*)\\[/spoiler\\]"),
-                       "<details><summary>Spoiler:  <div "
-                       "class=\"bbc_spoiler_show\">Show</div></summary><div "
-                       "class=\"spoiler_content\">\\1</div></details>");
-    m_TagMap["code"] = std::make_pair(QRegularExpression("\\[code\\](.*)\\[/code\\]"),
-                                      "<code>\\1</code>");
-    m_TagMap["heading"] =
-        std::make_pair(QRegularExpression("\\[heading\\](.*)\\[/heading\\]"),
-                       "<h2><strong>\\1</strong></h2>");
-    m_TagMap["line"] = std::make_pair(QRegularExpression("\\[line\\]"), "<hr>");
+    while (stack.size() > i) {
+      closeFrame(stack.back(), out);
+      stack.pop_back();
+    }
+  }
+
+  void closeFrame(const Frame& f, QString& out) const
+  {
+    if (f.name == "*") {
+      // don't keep the line break before the next bullet point
+      if (out.endsWith("<br/>") && out.size() - 5 >= f.contentStart) {
+        out.chop(5);
+      }
+    }
+
+    if (f.tag->wrap) {
+      const QString content = out.mid(f.contentStart);
+      out.truncate(f.contentStart);
+      out.append(f.tag->wrap(f.arg, content));
+    } else {
+      out.append(f.tag->close);
+    }
+  }
+
+  static std::function<QString(const QString&)> literal(QString html)
+  {
+    return [html](const QString&) {
+      return html;
+    };
+  }
+
+  void add(const QString& name, QString open, QString close)
+  {
+    m_TagMap[name] = {literal(std::move(open)), std::move(close)};
+  }
+
+  BBCodeMap()
+  {
+    add("b", "<b>", "</b>");
+    add("i", "<i>", "</i>");
+    add("u", "<u>", "</u>");
+    add("s", "<s>", "</s>");
+    add("sub", "<sub>", "</sub>");
+    add("sup", "<sup>", "</sup>");
+
+    m_TagMap["size="] = {[](const QString& arg) {
+                           return QString("<font size=\"%1\">").arg(arg);
+                         },
+                         "</font>"};
+
+    m_TagMap["color="] = {[this](const QString& arg) {
+                            QString color = arg.trimmed();
+
+                            if (!color.startsWith('#')) {
+                              auto colIter = m_ColorMap.find(color.toLower());
+                              if (colIter != m_ColorMap.end()) {
+                                color = colIter->second;
+                              }
+
+                              color = "#" + color;
+                            }
+
+                            return QString("<font style=\"color: %1;\">").arg(color);
+                          },
+                          "</font>"};
+
+    m_TagMap["font="] = {[](const QString& arg) {
+                           return QString("<font style=\"font-family: %1;\">").arg(arg);
+                         },
+                         "</font>"};
+
+    add("center", "<div align=\"center\">", "</div>");
+    add("right", "<div align=\"right\">", "</div>");
+    add("quote", "<figure class=\"quote\"><blockquote>", "</blockquote></figure>");
+    add("quote=", "<figure class=\"quote\"><blockquote>", "</blockquote></figure>");
+    add("spoiler",
+        "<details><summary>Spoiler:  <div "
+        "class=\"bbc_spoiler_show\">Show</div></summary><div "
+        "class=\"spoiler_content\">",
+        "</div></details>");
+    add("code", "<code>", "</code>");
+    add("heading", "<h2><strong>", "</strong></h2>");
+
+    m_TagMap["line"]        = {literal("<hr>")};
+    m_TagMap["line"].single = true;
 
     // lists
-    m_TagMap["list"] =
-        std::make_pair(QRegularExpression("\\[list\\](.*)\\[/list\\]"), "<ul>\\1</ul>");
-    m_TagMap["list="] = std::make_pair(
-        QRegularExpression("\\[list.*\\](.*)\\[/list\\]"), "<ol>\\1</ol>");
-    m_TagMap["ul"] =
-        std::make_pair(QRegularExpression("\\[ul\\](.*)\\[/ul\\]"), "<ul>\\1</ul>");
-    m_TagMap["ol"] =
-        std::make_pair(QRegularExpression("\\[ol\\](.*)\\[/ol\\]"), "<ol>\\1</ol>");
-    m_TagMap["li"] =
-        std::make_pair(QRegularExpression("\\[li\\](.*)\\[/li\\]"), "<li>\\1</li>");
+    add("list", "<ul>", "</ul>");
+    add("list=", "<ol>", "</ol>");
+    add("ul", "<ul>", "</ul>");
+    add("ol", "<ol>", "</ol>");
+    add("li", "<li>", "</li>");
+
+    // ends at the next bullet point or at the end of the list
+    add("*", "<li>", "</li>");
 
     // tables
-    m_TagMap["table"] = std::make_pair(
-        QRegularExpression("\\[table\\](.*)\\[/table\\]"), "<table>\\1</table>");
-    m_TagMap["tr"] =
-        std::make_pair(QRegularExpression("\\[tr\\](.*)\\[/tr\\]"), "<tr>\\1</tr>");
-    m_TagMap["th"] =
-        std::make_pair(QRegularExpression("\\[th\\](.*)\\[/th\\]"), "<th>\\1</th>");
-    m_TagMap["td"] =
-        std::make_pair(QRegularExpression("\\[td\\](.*)\\[/td\\]"), "<td>\\1</td>");
+    add("table", "<table>", "</table>");
+    add("tr", "<tr>", "</tr>");
+    add("th", "<th>", "</th>");
+    add("td", "<td>", "</td>");
 
     // web content
-    m_TagMap["url"] = std::make_pair(QRegularExpression("\\[url\\](.*)\\[/url\\]"),
-                                     "<a href=\"\\1\">\\1</a>");
-    m_TagMap["url="] =
-        std::make_pair(QRegularExpression("\\[url=([^\\]]*)\\](.*)\\[/url\\]"),
-                       "<a href=\"\\1\">\\2</a>");
-    m_TagMap["img"] = std::make_pair(
-        QRegularExpression(
-            "\\[img(?:\\s*width=\\d+\\s*,?\\s*height=\\d+)?\\](.*)\\[/img\\]"),
-        "<img src=\"\\1\">");
-    m_TagMap["img="] =
-        std::make_pair(QRegularExpression("\\[img=([^\\]]*)\\](.*)\\[/img\\]"),
-                       "<img src=\"\\2\" alt=\"\\1\">");
-    m_TagMap["email="] = std::make_pair(
-        QRegularExpression("\\[email=\"?([^\\]]*)\"?\\](.*)\\[/email\\]"),
-        "<a href=\"mailto:\\1\">\\2</a>");
-    m_TagMap["youtube"] =
-        std::make_pair(QRegularExpression("\\[youtube\\](.*)\\[/youtube\\]"),
-                       "<a "
-                       "href=\"https://www.youtube.com/watch?v=\\1\">https://"
-                       "www.youtube.com/watch?v=\\1</a>");
-
-    // make all patterns non-greedy and case-insensitive
-    for (TagMap::iterator iter = m_TagMap.begin(); iter != m_TagMap.end(); ++iter) {
-      iter->second.first.setPatternOptions(
-          QRegularExpression::CaseInsensitiveOption |
-          QRegularExpression::InvertedGreedinessOption);
-    }
+    m_TagMap["url"].wrap = [](const QString&, const QString& content) {
+      return QString("<a href=\"%1\">%1</a>").arg(content);
+    };
+
+    m_TagMap["url="] = {[](const QString& arg) {
+                          return QString("<a href=\"%1\">").arg(arg);
+                        },
+                        "</a>"};
+
+    m_TagMap["img"].wrap = [](const QString&, const QString& content) {
+      return QString("<img src=\"%1\">").arg(content);
+    };
 
-    // this tag is in fact greedy
-    m_TagMap["*"] = std::make_pair(QRegularExpression("\\[\\*\\](.*)"), "<li>\\1</li>");
+    // [img width=1 height=2]
+    m_TagMap["img"].attributes = true;
+
+    m_TagMap["img="].wrap = [](const QString& arg, const QString& content) {
+      return QString("<img src=\"%1\" alt=\"%2\">").arg(content, arg);
+    };
+
+    m_TagMap["email="] = {[](const QString& arg) {
+                            QString address = arg;
+                            address.remove('"');
+
+                            return QString("<a href=\"mailto:%1\">").arg(address);
+                          },
+                          "</a>"};
+
+    m_TagMap["youtube"].wrap = [](const QString&, const QString& content) {
+      return QString("<a "
+                     "href=\"https://www.youtube.com/watch?v=%1\">https://"
+                     "www.youtube.com/watch?v=%1</a>")
+          .arg(content);
+    };
 
     m_ColorMap.insert(std::make_pair<QString, QString>("red", "FF0000"));
     m_ColorMap.insert(std::make_pair<QString, QString>("green", "00FF00"));
@@ -256,63 +386,33 @@ private:
     m_ColorMap.insert(std::make_pair<QString, QString>("peru", "CD853F"));
   }
 
-private:
-  QRegularExpression m_TagNameExp;
-  TagMap m_TagMap;
-  std::map<QString, QString> m_ColorMap;
 };
 
 QString convertToHTML(const QString& inputParam)
 {
-  // this code goes over the input string once and replaces all bbtags
-  // it encounters. This function is called recursively for every replaced
-  // string to convert nested tags.
-  //
-  // This could be implemented simpler by applying a set of regular expressions
-  // for each recognized bb-tag one after the other but that would probably be
-  // very inefficient (O(n^2)).
+  static std::mutex s_CacheMutex;
+  static QCache<QString, QString> s_Cache(MaxCacheCost);
 
-  QString input = inputParam.mid(0).replace("\r\n", "<br/>");
-  input.replace("\\\"", "\"").replace("\\'", "'");
-  QString result;
-  int lastBlock = 0;
-  int pos       = 0;
-
-  // iterate over the input buffer
-  while ((pos = input.indexOf('[', lastBlock)) != -1) {
-    // append everything between the previous tag-block and the current one
-    result.append(input.mid(lastBlock, pos - lastBlock));
-
-    if ((pos < (input.size() - 1)) && (input.at(pos + 1) == '/')) {
-      // skip invalid end tag
-      int tagEnd = input.indexOf(']', pos) + 1;
-      if (tagEnd == 0) {
-        // no closing tag found
-        // move the pos up one so that the opening bracket is ignored next iteration
-        pos++;
-      } else {
-        pos = tagEnd;
-      }
-    } else {
-      // convert the tag and content if necessary
-      int length          = -1;
-      QString replacement = BBCodeMap::instance().convertTag(input.mid(pos), length);
-      if (length != 0) {
-        result.append(convertToHTML(replacement));
-        // length contains the number of characters in the original tag
-        pos += length;
-      } else {
-        // nothing replaced
-        result.append('[');
-        ++pos;
-      }
+  {
+    std::scoped_lock lock(s_CacheMutex);
+
+    if (const auto* html = s_Cache.object(inputParam)) {
+      return *html;
     }
-    lastBlock = pos;
   }
 
-  // append the remainder (everything after the last tag)
-  result.append(input.mid(lastBlock));
-  return result;
+  QString input = inputParam;
+  input.replace("\r\n", "<br/>");
+  input.replace("\\\"", "\"").replace("\\'", "'");
+
+  const QString html = BBCodeMap::instance().convert(input);
+
+  {
+    std::scoped_lock lock(s_CacheMutex);
+    s_Cache.insert(inputParam, new QString(html), inputParam.size() + html.size());
+  }
+
+  return html;
 }
 
 }  // namespace BBCode
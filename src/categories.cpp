@@ -100,6 +100,7 @@ CategoryFactory& CategoryFactory::instance()
 
 void CategoryFactory::reset()
 {
+  ++m_Generation;
   m_Categories.clear();
   m_IDMap.clear();
   // 28 =
@@ -191,6 +192,7 @@ int CategoryFactory::addCategory(const QString& name, const std::vector<int>& ne
 void CategoryFactory::addCategory(int id, const QString& name,
                                   const std::vector<int>& nexusIDs, int parentID)
 {
+  ++m_Generation;
   int index = static_cast<int>(m_Categories.size());
   m_Categories.push_back(Category(index, id, name, nexusIDs, parentID));
   for (int nexusID : nexusIDs) {
@@ -177,6 +177,12 @@ public:
    **/
   unsigned int resolveNexusID(int nexusID) const;
 
+  /**
+   * @brief incremented every time categories are added or reset, used to
+   *        invalidate values derived from category names
+   **/
+  std::size_t generation() const { return m_Generation; }
+
 public:
   /**
    * @brief retrieve a reference to the singleton instance
@@ -208,6 +214,7 @@ private:
   std::vector<Category> m_Categories;
   std::map<int, unsigned int> m_IDMap;
   std::map<int, unsigned int> m_NexusMap;
+  std::size_t m_Generation = 0;
 
 private:
   // called by isDescendantOf()
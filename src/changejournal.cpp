@@ -0,0 +1,142 @@
+#include "changejournal.h"
+#include <QDir>
+#include <log.h>
+#include <utility.h>
+
+using namespace MOBase;
+
+ChangeJournal::ChangeJournal(QObject* parent)
+    : QObject(parent), m_watcher([this](auto&& changes) {
+        onChanges(std::move(changes));
+      })
+{
+  m_timer.setSingleShot(true);
+  m_timer.setInterval(Delay);
+
+  connect(&m_timer, &QTimer::timeout, this, &ChangeJournal::changed);
+}
+
+ChangeJournal::~ChangeJournal()
+{
+  // the watcher thread uses the other members
+  m_watcher.stop();
+}
+
+void ChangeJournal::start(const QString& modsPath, const QString& overwritePath,
+                          const QString& overwriteName)
+{
+  const auto mods      = ToWString(QDir::toNativeSeparators(modsPath));
+  const auto overwrite = ToWString(QDir::toNativeSeparators(overwritePath));
+
+  if (m_watcher.watching() && mods == m_modsPath && overwrite == m_overwritePath &&
+      overwriteName == m_overwriteName) {
+    // already watching, restarting could miss changes
+    return;
+  }
+
+  m_watcher.stop();
+
+  m_modsPath      = mods;
+  m_overwritePath = overwrite;
+  m_overwriteName = overwriteName;
+
+  log::debug("watching '{}' and '{}' for changes", m_modsPath, m_overwritePath);
+
+  m_watcher.watch({m_modsPath, m_overwritePath});
+}
+
+void ChangeJournal::stop()
+{
+  m_watcher.stop();
+}
+
+bool ChangeJournal::complete() const
+{
+  return m_watcher.watching(m_modsPath) && m_watcher.watching(m_overwritePath);
+}
+
+ChangeJournal::Changes ChangeJournal::takeChanges()
+{
+  std::scoped_lock lock(m_mutex);
+  return std::exchange(m_changes, {});
+}
+
+// whether the given path, relative to a mod, is the meta.ini file of the mod,
+// or one of the temporary and lock files used while writing it; MO writes it
+// itself and it's not part of the directory structure
+//
+static bool isMetaFile(std::wstring_view path)
+{
+  static constexpr std::wstring_view meta = L"meta.ini";
+
+  if (path.find_first_of(L"\\/") != std::wstring_view::npos) {
+    return false;
+  }
+
+  if (path.size() < meta.size()) {
+    return false;
+  }
+
+  return (_wcsnicmp(path.data(), meta.data(), meta.size()) == 0);
+}
+
+void ChangeJournal::onChanges(std::vector<env::FileChange> changes)
+{
+  {
+    std::scoped_lock lock(m_mutex);
+
+    for (auto&& c : changes) {
+      if (c.root == m_overwritePath) {
+        if (c.type != env::FileChange::Overflow && isMetaFile(c.path)) {
+          continue;
+        }
+
+        auto& mc = m_changes.mods[m_overwriteName];
+
+        if (c.type == env::FileChange::Overflow) {
+          mc.rescan = true;
+        } else {
+          mc.paths.insert(std::move(c.path));
+        }
+      } else if (c.root == m_modsPath) {
+        if (c.type == env::FileChange::Overflow) {
+          m_changes.rescanAll = true;
+          continue;
+        }
+
+        // the first component is the mod directory
+        const auto sep = c.path.find_first_of(L"\\/");
+
+        if (sep == std::wstring::npos) {
+          if (c.type == env::FileChange::Modified) {
+            // the time of the mod directory changes with every file added or
+            // removed in it, including meta.ini, these files are reported
+            // separately
+            continue;
+          }
+
+          // the mod directory itself was added, removed or renamed
+          m_changes.mods[ToQString(c.path)].rescan = true;
+          continue;
+        }
+
+        const auto path = c.path.substr(sep + 1);
+        if (isMetaFile(path)) {
+          continue;
+        }
+
+        m_changes.mods[ToQString(c.path.substr(0, sep))].paths.insert(path);
+      }
+    }
+  }
+
+  // the timer lives on the main thread
+  QMetaObject::invokeMethod(
+      this,
+      [this] {
+        if (!m_timer.isActive()) {
+          m_timer.start();
+        }
+      },
+      Qt::QueuedConnection);
+}
@@ -0,0 +1,96 @@
+#ifndef MODORGANIZER_CHANGEJOURNAL_INCLUDED
+#define MODORGANIZER_CHANGEJOURNAL_INCLUDED
+
+#include "envwatcher.h"
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <map>
+#include <mutex>
+#include <set>
+
+// collects changes made to the mods and overwrite directories while MO is
+// running, such as a tool writing into overwrite or files copied manually into
+// a mod, so they can be applied to the directory structure without a full
+// refresh
+//
+// changes come from an env::DirectoryWatcher thread and are grouped by mod;
+// changed() is emitted on the main thread a short while after the first
+// change, so a burst of changes is applied at once
+//
+class ChangeJournal : public QObject
+{
+  Q_OBJECT
+
+public:
+  // how long changes are collected before changed() is emitted
+  static constexpr int Delay = 500;
+
+  // changes to the loose files of one mod
+  //
+  struct ModChanges
+  {
+    // paths relative to the mod directory that were added, removed or
+    // modified
+    std::set<std::wstring> paths;
+
+    // changes were lost, all the files of the mod must be walked again
+    bool rescan = false;
+  };
+
+  // everything that changed since the last takeChanges()
+  //
+  struct Changes
+  {
+    // keyed by mod name
+    std::map<QString, ModChanges> mods;
+
+    // changes were lost in the mods directory and it's not known which mods
+    // were affected
+    bool rescanAll = false;
+
+    bool empty() const { return mods.empty() && !rescanAll; }
+  };
+
+  ChangeJournal(QObject* parent = nullptr);
+  ~ChangeJournal();
+
+  // starts watching the given directories, replacing the previous ones; the
+  // first component of a path under `modsPath` is the name of a mod and
+  // everything under `overwritePath` belongs to the mod `overwriteName`
+  //
+  void start(const QString& modsPath, const QString& overwritePath,
+             const QString& overwriteName);
+
+  // stops watching, changes that were collected but not taken are kept
+  //
+  void stop();
+
+  // returns and forgets the changes collected so far
+  //
+  Changes takeChanges();
+
+  // whether every change to the mods and overwrite directories is reported,
+  // which is not the case before start(), after stop() or once one of them
+  // has failed; changes that were collected but not taken are still pending
+  //
+  bool complete() const;
+
+signals:
+  void changed();
+
+private:
+  env::DirectoryWatcher m_watcher;
+  std::wstring m_modsPath;
+  std::wstring m_overwritePath;
+  QString m_overwriteName;
+
+  std::mutex m_mutex;
+  Changes m_changes;
+  QTimer m_timer;
+
+  // called on the watcher thread
+  void onChanges(std::vector<env::FileChange> changes);
+};
+
+#endif  // MODORGANIZER_CHANGEJOURNAL_INCLUDED
@@ -0,0 +1,301 @@
+#include "conflictindex.h"
+#include "modinfo.h"
+#include "shared/directoryentry.h"
+#include "shared/fileentry.h"
+#include "shared/filesorigin.h"
+#include "thread_utils.h"
+#include <filesystem>
+#include <log.h>
+#include <utility.h>
+
+using namespace MOBase;
+using namespace MOShared;
+namespace fs = std::filesystem;
+
+namespace
+{
+
+// conflicts of an origin while the files are being processed
+//
+struct Accumulator
+{
+  bool hasFiles         = false;
+  bool providesAnything = false;
+  ConflictIndex::Conflicts conflicts;
+
+  void merge(Accumulator&& o)
+  {
+    hasFiles         = hasFiles || o.hasFiles;
+    providesAnything = providesAnything || o.providesAnything;
+
+    auto& c  = conflicts;
+    auto& oc = o.conflicts;
+
+    c.hasHiddenFiles = c.hasHiddenFiles || oc.hasHiddenFiles;
+    c.overwrite.merge(oc.overwrite);
+    c.overwritten.merge(oc.overwritten);
+    c.archiveOverwrite.merge(oc.archiveOverwrite);
+    c.archiveOverwritten.merge(oc.archiveOverwritten);
+    c.archiveLooseOverwrite.merge(oc.archiveLooseOverwrite);
+    c.archiveLooseOverwritten.merge(oc.archiveLooseOverwritten);
+  }
+};
+
+// part of the register processed by one thread
+//
+struct Chunk
+{
+  FileIndex begin = 0;
+  FileIndex end   = 0;
+
+  std::unordered_map<OriginID, Accumulator> origins;
+
+  // whether a directory or any of its parents is hidden
+  std::unordered_map<const DirectoryEntry*, bool> hiddenDirs;
+};
+
+struct Context
+{
+  OriginID dataID = 0;
+  std::vector<int> priorities;
+  std::wstring hideExt;
+};
+
+bool isHiddenName(const std::wstring& name, const Context& cx)
+{
+  return (fs::path(name).extension().wstring().compare(cx.hideExt) == 0);
+}
+
+bool isHiddenDirectory(const DirectoryEntry* d, Chunk& chunk, const Context& cx)
+{
+  if (!d) {
+    return false;
+  }
+
+  auto itor = chunk.hiddenDirs.find(d);
+  if (itor != chunk.hiddenDirs.end()) {
+    return itor->second;
+  }
+
+  const bool hidden =
+      isHiddenName(d->getName(), cx) || isHiddenDirectory(d->getParent(), chunk, cx);
+
+  chunk.hiddenDirs.emplace(d, hidden);
+  return hidden;
+}
+
+int priority(OriginID id, const Context& cx)
+{
+  if (id < 0 || static_cast<std::size_t>(id) >= cx.priorities.size()) {
+    return -1;
+  }
+
+  return cx.priorities[id];
+}
+
+// adds the conflicts of the given file to every origin providing it; this is
+// the same logic ModInfoWithConflictInfo::doConflictCheck() applies to the
+// files of a single origin
+//
+void processFile(const FileEntryPtr& file, Chunk& chunk, const Context& cx)
+{
+  const OriginID primary = file->getOrigin();
+  if (primary == InvalidOriginID) {
+    return;
+  }
+
+  const auto alternatives       = file->getAlternatives();
+  const bool primaryFromArchive = file->getArchive().isValid();
+
+  const bool hidden = isHiddenName(file->getName(), cx) ||
+                      isHiddenDirectory(file->getParent(), chunk, cx);
+
+  auto process = [&](OriginID id, const DataArchiveOrigin& archiveData) {
+    Accumulator& a = chunk.origins[id];
+    auto& c        = a.conflicts;
+
+    a.hasFiles = true;
+
+    if (hidden) {
+      c.hasHiddenFiles = true;
+    }
+
+    if (alternatives.empty() || alternatives.back().originID() == cx.dataID) {
+      // no alternatives -> no conflict
+      a.providesAnything = true;
+      return;
+    }
+
+    if (primary != id) {
+      if (!primaryFromArchive) {
+        if (!archiveData.isValid()) {
+          c.overwritten.insert(primary);
+        } else {
+          c.archiveLooseOverwritten.insert(primary);
+        }
+      } else {
+        c.archiveOverwritten.insert(primary);
+      }
+    } else {
+      a.providesAnything = true;
+    }
+
+    for (const auto& alt : alternatives) {
+      const auto altID = alt.originID();
+
+      if (altID == cx.dataID || altID == id) {
+        continue;
+      }
+
+      if (!alt.isFromArchive()) {
+        if (!archiveData.isValid()) {
+          if (priority(id, cx) > priority(altID, cx)) {
+            c.overwrite.insert(altID);
+          } else {
+            c.overwritten.insert(altID);
+          }
+        } else {
+          c.archiveLooseOverwritten.insert(altID);
+        }
+      } else {
+        if (!archiveData.isValid()) {
+          c.archiveLooseOverwrite.insert(altID);
+        } else if (archiveData.order() > alt.archive().order()) {
+          c.archiveOverwrite.insert(altID);
+        } else if (archiveData.order() < alt.archive().order()) {
+          c.archiveOverwritten.insert(altID);
+        }
+      }
+    }
+  };
+
+  process(primary, file->getArchive());
+
+  for (const auto& alt : alternatives) {
+    process(alt.originID(), alt.archive());
+  }
+}
+
+template <class T>
+ConflictIndex::EConflictType stateOf(const std::set<T>& overwrite,
+                                     const std::set<T>& overwritten)
+{
+  if (!overwrite.empty() && !overwritten.empty()) {
+    return ConflictIndex::CONFLICT_MIXED;
+  } else if (!overwrite.empty()) {
+    return ConflictIndex::CONFLICT_OVERWRITE;
+  } else if (!overwritten.empty()) {
+    return ConflictIndex::CONFLICT_OVERWRITTEN;
+  }
+
+  return ConflictIndex::CONFLICT_NONE;
+}
+
+}  // namespace
+
+std::unique_ptr<ConflictIndex> ConflictIndex::create(DirectoryEntry& root,
+                                                     std::size_t threadCount)
+{
+  TimeThis tt("ConflictIndex::create()");
+
+  Context cx;
+  cx.hideExt = ToWString(ModInfo::s_HiddenExt);
+
+  if (root.originExists(L"data")) {
+    cx.dataID = root.getOriginByName(L"data").getID();
+  }
+
+  // origin IDs are sequential
+  for (OriginID id = 0;; ++id) {
+    const auto* o = root.findOriginByID(id);
+    if (!o) {
+      break;
+    }
+
+    cx.priorities.push_back(o->getPriority());
+  }
+
+  threadCount = std::max<std::size_t>(threadCount, 1);
+
+  // a few chunks per thread so threads finishing early can pick up more
+  auto reg         = root.getFileRegister();
+  const auto total = static_cast<FileIndex>(reg->highestCount());
+  const auto size  = total / static_cast<FileIndex>(threadCount * 4) + 1;
+
+  std::vector<Chunk> chunks;
+  for (FileIndex begin = 0; begin < total; begin += size) {
+    Chunk c;
+    c.begin = begin;
+    c.end   = std::min(total, begin + size);
+
+    chunks.push_back(std::move(c));
+  }
+
+  parallelMap(
+      chunks.begin(), chunks.end(),
+      [&](Chunk& chunk) {
+        for (auto&& file : reg->getFiles(chunk.begin, chunk.end)) {
+          processFile(file, chunk, cx);
+        }
+      },
+      threadCount);
+
+  std::vector<Accumulator> origins(cx.priorities.size());
+
+  for (auto& chunk : chunks) {
+    for (auto& [id, a] : chunk.origins) {
+      if (id >= 0 && static_cast<std::size_t>(id) < origins.size()) {
+        origins[id].merge(std::move(a));
+      }
+    }
+  }
+
+  auto index = std::make_unique<ConflictIndex>();
+  index->m_Conflicts.reserve(origins.size());
+
+  for (auto& a : origins) {
+    Conflicts c = std::move(a.conflicts);
+
+    if (a.hasFiles) {
+      if (!a.providesAnything) {
+        c.currentState = CONFLICT_REDUNDANT;
+      } else {
+        c.currentState = stateOf(c.overwrite, c.overwritten);
+      }
+
+      c.archiveState = stateOf(c.archiveOverwrite, c.archiveOverwritten);
+      c.archiveLooseState =
+          stateOf(c.archiveLooseOverwrite, c.archiveLooseOverwritten);
+    } else {
+      c.hasHiddenFiles = false;
+    }
+
+    index->m_Conflicts.push_back(std::move(c));
+  }
+
+  log::debug("conflict index computed for {} origins", index->m_Conflicts.size());
+
+  return index;
+}
+
+std::optional<ConflictIndex::Conflicts> ConflictIndex::find(OriginID id) const
+{
+  std::scoped_lock lock(m_Mutex);
+
+  if (id < 0 || static_cast<std::size_t>(id) >= m_Conflicts.size()) {
+    return {};
+  }
+
+  return m_Conflicts[id];
+}
+
+void ConflictIndex::invalidate(const std::set<OriginID>& ids)
+{
+  std::scoped_lock lock(m_Mutex);
+
+  for (const auto id : ids) {
+    if (id >= 0 && static_cast<std::size_t>(id) < m_Conflicts.size()) {
+      m_Conflicts[id].reset();
+    }
+  }
+}
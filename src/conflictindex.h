@@ -0,0 +1,72 @@
+#ifndef MODORGANIZER_CONFLICTINDEX_INCLUDED
+#define MODORGANIZER_CONFLICTINDEX_INCLUDED
+
+#include "shared/fileregisterfwd.h"
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <vector>
+
+// conflicts between all the origins of a directory structure, computed in a
+// single parallel pass over the file register at the end of a refresh
+//
+// mods used to compute their conflicts lazily by walking all the files of their
+// own origin, which happened for every visible mod after each refresh; they
+// now look up their entry here and only fall back to the slow path when the
+// entry is missing or has been invalidated
+//
+class ConflictIndex
+{
+public:
+  enum EConflictType
+  {
+    CONFLICT_NONE,
+    CONFLICT_OVERWRITE,
+    CONFLICT_OVERWRITTEN,
+    CONFLICT_MIXED,
+    CONFLICT_REDUNDANT,
+    CONFLICT_CROSS
+  };
+
+  // conflicts of one origin, other origins are given by ID
+  //
+  struct Conflicts
+  {
+    EConflictType currentState      = CONFLICT_NONE;
+    EConflictType archiveState      = CONFLICT_NONE;
+    EConflictType archiveLooseState = CONFLICT_NONE;
+    bool hasHiddenFiles             = false;
+
+    std::set<MOShared::OriginID> overwrite;
+    std::set<MOShared::OriginID> overwritten;
+    std::set<MOShared::OriginID> archiveOverwrite;
+    std::set<MOShared::OriginID> archiveOverwritten;
+    std::set<MOShared::OriginID> archiveLooseOverwrite;
+    std::set<MOShared::OriginID> archiveLooseOverwritten;
+  };
+
+  // computes the conflicts of all the origins in the given structure with the
+  // given number of threads
+  //
+  static std::unique_ptr<ConflictIndex> create(MOShared::DirectoryEntry& root,
+                                               std::size_t threadCount);
+
+  // conflicts of the given origin, empty if the origin didn't exist when the
+  // index was created or if it was invalidated since
+  //
+  std::optional<Conflicts> find(MOShared::OriginID id) const;
+
+  // forgets the given origins, used when their files have changed without a
+  // full refresh
+  //
+  void invalidate(const std::set<MOShared::OriginID>& ids);
+
+private:
+  mutable std::mutex m_Mutex;
+
+  // indexed by origin ID, empty for invalidated origins
+  std::vector<std::optional<Conflicts>> m_Conflicts;
+};
+
+#endif  // MODORGANIZER_CONFLICTINDEX_INCLUDED
@@ -18,6 +18,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "directoryrefresher.h"
+#include "directorysnapshot.h"
 #include "shared/fileentry.h"
 #include "shared/filesorigin.h"
 
@@ -25,6 +26,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "iplugingame.h"
 #include "modinfo.h"
 #include "modinfodialogfwd.h"
+#include "refreshprofiler.h"
 #include "report.h"
 #include "settings.h"
 #include "shared/util.h"
@@ -36,8 +38,6 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDir>
 #include <QString>
 
-#include <fstream>
-
 using namespace MOBase;
 using namespace MOShared;
 
@@ -131,44 +131,26 @@ std::string DirectoryStats::toCsv() const
   return oss.join(",").toStdString();
 }
 
-void dumpStats(std::vector<DirectoryStats>& stats)
+DirectoryRefresher::DirectoryRefresher(std::size_t threadCount)
+    : m_threadCount(threadCount), m_lastFileCount(0), m_Pool(threadCount)
 {
-  static int run = 0;
-  static const std::string file("c:\\tmp\\data.csv");
-
-  if (run == 0) {
-    std::ofstream out(file, std::ios::out | std::ios::trunc);
-    out << fmt::format("what,run,{}", DirectoryStats::csvHeader()) << "\n";
-  }
-
-  std::sort(stats.begin(), stats.end(), [](auto&& a, auto&& b) {
-    return (naturalCompare(QString::fromStdString(a.mod),
-                           QString::fromStdString(b.mod)) < 0);
-  });
-
-  std::ofstream out(file, std::ios::app);
-
-  DirectoryStats total;
-  for (const auto& s : stats) {
-    out << fmt::format("{},{},{}", s.mod, run, s.toCsv()) << "\n";
-    total += s;
-  }
-
-  out << fmt::format("total,{},{}", run, total.toCsv()) << "\n";
-
-  ++run;
+  m_ArchiveIndexes.setDirectory(
+      QDir::toNativeSeparators(Settings::instance().paths().cache() + "/archives")
+          .toStdWString());
 }
 
-DirectoryRefresher::DirectoryRefresher(std::size_t threadCount)
-    : m_threadCount(threadCount), m_lastFileCount(0)
-{}
-
 DirectoryEntry* DirectoryRefresher::stealDirectoryStructure()
 {
   QMutexLocker locker(&m_RefreshLock);
   return m_Root.release();
 }
 
+std::unique_ptr<ConflictIndex> DirectoryRefresher::stealConflictIndex()
+{
+  QMutexLocker locker(&m_RefreshLock);
+  return std::move(m_ConflictIndex);
+}
+
 void DirectoryRefresher::setMods(
     const std::vector<std::tuple<QString, QString, int>>& mods,
     const std::set<QString>& managedArchives)
@@ -232,7 +214,7 @@ void DirectoryRefresher::addModBSAToStructure(DirectoryEntry* root,
 
   root->addFromAllBSAs(modName.toStdWString(),
                        QDir::toNativeSeparators(directory).toStdWString(), priority,
-                       archivesW, enabledArchives, lo, dummy);
+                       archivesW, enabledArchives, lo, dummy, &m_ArchiveIndexes);
 }
 
 void DirectoryRefresher::stealModFilesIntoStructure(DirectoryEntry* directoryStructure,
@@ -267,7 +249,7 @@ void DirectoryRefresher::stealModFilesIntoStructure(DirectoryEntry* directoryStr
         file->removeOrigin(0);
       }
       origin.addFile(file->getIndex());
-      file->addOrigin(origin.getID(), file->getFileTime(), L"", -1);
+      file->addOrigin(origin.getID(), file->getFileTime(), {});
     } else {
       QString warnStr = fileInfo.absolutePath();
       if (warnStr.isEmpty())
@@ -318,69 +300,233 @@ void DirectoryRefresher::addModToStructure(DirectoryEntry* directoryStructure,
   }
 }
 
-struct ModThread
+// directories up to this depth in an origin are listed by one task each, and
+// every subdirectory is handed to a new task; deeper directories are walked
+// entirely by the task that reaches them
+//
+// this spreads large origins (such as texture packs with a few huge folders)
+// over all the threads instead of keeping a single one busy
+//
+constexpr std::size_t SplitDepth = 2;
+
+// number of directories checked by one task when an origin is restored from
+// the snapshot, so large origins are checked by several threads too
+//
+constexpr std::size_t CheckBatchSize = 256;
+
+// state shared by all the tasks adding one origin to the structure
+//
+struct OriginWalk
 {
   DirectoryRefreshProgress* progress = nullptr;
+  DirectorySnapshot* snapshot        = nullptr;
   DirectoryEntry* ds                 = nullptr;
   std::wstring modName;
   std::wstring path;
   int prio = -1;
   std::vector<std::wstring> archives;
   std::set<std::wstring> enabledArchives;
-  DirectoryStats* stats = nullptr;
-  env::DirectoryWalker walker;
+  std::vector<std::wstring> loadOrder;
+  ArchiveIndexCache* indexes = nullptr;
+  DirectoryStats* stats      = nullptr;
 
-  std::condition_variable cv;
-  std::mutex mutex;
-  bool ready = false;
+  // if true, the files are only listed and added later together with other
+  // origins by DirectoryEntry::addFromLists(), along with the archives
+  bool merge = false;
 
-  void wakeup()
-  {
-    {
-      std::scoped_lock lock(mutex);
-      ready = true;
+  // filled by the tasks, each one owning a different directory
+  env::Directory root;
+
+  // directories of the origin in the snapshot, checked by several tasks; the
+  // origin is walked if any of them changed
+  std::vector<DirectorySnapshot::DirectoryTime> snapshotDirs;
+  std::atomic<bool> changed = false;
+
+  // number of directories not walked yet, the last task to finish adds the
+  // files to the structure
+  std::atomic<std::size_t> pending = 0;
+
+  // set when any of the tasks failed, the listing is incomplete and the origin
+  // is not added to the structure at all
+  std::atomic<bool> failed = false;
+
+  // whether the listing can be added to the structure
+  bool complete() const { return !failed && pending == 0; }
+};
+
+void finishOrigin(OriginWalk& w, bool walked)
+{
+  Guard g([&] {
+    if (w.progress) {
+      w.progress->addDone();
     }
+  });
+
+  if (w.failed) {
+    log::error("refresher: mod '{}' could not be read entirely, it is ignored",
+               w.modName);
 
-    cv.notify_one();
+    return;
   }
 
-  void run()
-  {
-    std::unique_lock lock(mutex);
-    cv.wait(lock, [&] {
-      return ready;
-    });
+  if (walked && w.snapshot) {
+    w.snapshot->capture(w.modName, w.path, w.root);
+  }
 
-    SetThisThreadName(QString::fromStdWString(modName + L" refresher"));
-    ds->addFromOrigin(walker, modName, path, prio, *stats);
+  if (w.merge) {
+    return;
+  }
 
-    if (Settings::instance().archiveParsing()) {
-      const IPluginGame* game = qApp->property("managed_game").value<IPluginGame*>();
+  w.ds->addFromList(w.modName, w.path, w.root, w.prio, *w.stats);
 
-      QStringList loadOrder;
-      GamePlugins* gamePlugins = game->feature<GamePlugins>();
-      if (gamePlugins) {
-        loadOrder = gamePlugins->getLoadOrder();
-      }
+  if (!w.archives.empty()) {
+    w.ds->addFromAllBSAs(w.modName, w.path, w.prio, w.archives, w.enabledArchives,
+                         w.loadOrder, *w.stats, w.indexes);
+  }
+}
 
-      std::vector<std::wstring> lo;
-      for (auto&& s : loadOrder) {
-        lo.push_back(s.toStdWString());
-      }
+// called by the last task of an origin, must not throw because it runs from a
+// guard
+//
+void finishOriginNoThrow(OriginWalk& w, bool walked)
+{
+  try {
+    finishOrigin(w, walked);
+  } catch (std::exception& e) {
+    log::error("refresher: failed to add mod '{}': {}", w.modName, e.what());
+  } catch (...) {
+    log::error("refresher: failed to add mod '{}'", w.modName);
+  }
+}
+
+void walkDirectory(TaskPool& pool, std::shared_ptr<OriginWalk> w, env::Directory& d,
+                   std::wstring path, std::size_t depth)
+{
+  // walker buffers are reused for all the tasks running on a thread
+  thread_local env::DirectoryWalker walker;
+
+  // the last task to finish adds the files, this one is counted down even if
+  // it fails so the origin is always finished
+  Guard g([&] {
+    if (--w->pending == 0) {
+      finishOriginNoThrow(*w, true);
+    }
+  });
+
+  RefreshProfiler::Scope scope(RefreshProfiler::Phases::Walk, w->modName);
+
+  try {
+    if (depth < SplitDepth) {
+      auto listing   = env::getFilesAndDirsWithFind(path, false);
+      d.lastModified = listing.lastModified;
+      d.files        = std::move(listing.files);
+      d.dirs         = std::move(listing.dirs);
+
+      // d.dirs must not change size after this, tasks keep references to its
+      // elements
+      for (auto& sd : d.dirs) {
+        ++w->pending;
 
-      ds->addFromAllBSAs(modName, path, prio, archives, enabledArchives, lo, *stats);
+        pool.submit([&pool, w, &sd, sdPath = path + L"\\" + sd.name, depth] {
+          walkDirectory(pool, w, sd, sdPath, depth + 1);
+        });
+      }
+    } else {
+      auto listing   = env::getFilesAndDirs(walker, path);
+      d.lastModified = listing.lastModified;
+      d.files        = std::move(listing.files);
+      d.dirs         = std::move(listing.dirs);
     }
+  } catch (std::exception& e) {
+    log::error("refresher: failed to walk '{}': {}", path, e.what());
+    w->failed = true;
+  } catch (...) {
+    log::error("refresher: failed to walk '{}'", path);
+    w->failed = true;
+  }
+}
 
-    if (progress) {
-      progress->addDone();
+// checks a batch of the directories of an origin read from the snapshot; the
+// last batch to finish either keeps the listing or walks the origin
+//
+void checkDirectories(TaskPool& pool, std::shared_ptr<OriginWalk> w,
+                      std::size_t begin, std::size_t end)
+{
+  if (!w->changed) {
+    RefreshProfiler::Scope scope(RefreshProfiler::Phases::Walk, w->modName);
+
+    const auto* dirs = w->snapshotDirs.data();
+    if (!DirectorySnapshot::unchanged(dirs + begin, dirs + end)) {
+      w->changed = true;
     }
+  }
 
-    SetThisThreadName(QString::fromStdWString(L"idle refresher"));
-    ready = false;
+  if (--w->pending != 0) {
+    return;
   }
-};
 
-env::ThreadPool<ModThread> g_threads;
+  w->snapshotDirs = {};
+
+  if (w->changed) {
+    w->root    = {};
+    w->pending = 1;
+    walkDirectory(pool, w, w->root, w->path, 0);
+    return;
+  }
+
+  w->snapshot->keep(w->modName);
+  finishOriginNoThrow(*w, false);
+}
+
+// reads the origin from the snapshot and checks its directories in batches,
+// or starts walking it if it's not in the snapshot
+//
+void startOrigin(TaskPool& pool, std::shared_ptr<OriginWalk> w)
+{
+  pool.submit([&pool, w] {
+    if (w->path.empty()) {
+      // nothing to walk, but the origin must still exist
+      finishOriginNoThrow(*w, false);
+      return;
+    }
+
+    bool read = false;
+
+    try {
+      read = (w->snapshot &&
+              w->snapshot->read(w->modName, w->path, w->root, w->snapshotDirs));
+    } catch (std::exception& e) {
+      // the snapshot is only a cache, walk the directory instead
+      log::error("refresher: failed to restore '{}' from snapshot: {}", w->modName,
+                 e.what());
+
+      w->root         = {};
+      w->snapshotDirs = {};
+    }
+
+    if (!read) {
+      w->pending = 1;
+      walkDirectory(pool, w, w->root, w->path, 0);
+      return;
+    }
+
+    const auto count   = w->snapshotDirs.size();
+    const auto batches = (count + CheckBatchSize - 1) / CheckBatchSize;
+
+    // all the batches are counted before any of them runs
+    w->pending = batches;
+
+    for (std::size_t b = 1; b < batches; ++b) {
+      pool.submit([&pool, w, b, count] {
+        checkDirectories(pool, w, b * CheckBatchSize,
+                         std::min(count, (b + 1) * CheckBatchSize));
+      });
+    }
+
+    // the first batch runs on this task
+    checkDirectories(pool, w, 0, std::min(count, CheckBatchSize));
+  });
+}
 
 void DirectoryRefresher::updateProgress(const DirectoryRefreshProgress* p)
 {
@@ -390,7 +536,7 @@ void DirectoryRefresher::updateProgress(const DirectoryRefreshProgress* p)
 
 void DirectoryRefresher::addMultipleModsFilesToStructure(
     MOShared::DirectoryEntry* directoryStructure, const std::vector<EntryInfo>& entries,
-    DirectoryRefreshProgress* progress)
+    DirectoryRefreshProgress* progress, DirectorySnapshot* snapshot)
 {
   std::vector<DirectoryStats> stats(entries.size());
 
@@ -399,13 +545,34 @@ void DirectoryRefresher::addMultipleModsFilesToStructure(
   }
 
   log::debug("refresher: using {} threads", m_threadCount);
-  g_threads.setMax(m_threadCount);
+
+  std::vector<std::wstring> loadOrder;
+  std::set<std::wstring> enabledArchives;
+
+  if (Settings::instance().archiveParsing()) {
+    const IPluginGame* game = qApp->property("managed_game").value<IPluginGame*>();
+
+    GamePlugins* gamePlugins = game->feature<GamePlugins>();
+    if (gamePlugins) {
+      for (auto&& s : gamePlugins->getLoadOrder()) {
+        loadOrder.push_back(s.toStdWString());
+      }
+    }
+
+    for (auto&& a : m_EnabledArchives) {
+      enabledArchives.insert(a.toStdWString());
+    }
+  }
+
+  // first phase: walk all the mods in parallel, or restore them from the
+  // snapshot, without touching the structure
+  std::vector<std::shared_ptr<OriginWalk>> walks;
 
   for (std::size_t i = 0; i < entries.size(); ++i) {
     const auto& e  = entries[i];
     const int prio = e.priority + 1;
 
-    if constexpr (DirectoryStats::EnableInstrumentation) {
+    if (RefreshProfiler::instance().recording()) {
       stats[i].mod = entries[i].modName.toStdString();
     }
 
@@ -418,38 +585,77 @@ void DirectoryRefresher::addMultipleModsFilesToStructure(
           progress->addDone();
         }
       } else {
-        auto& mt = g_threads.request();
+        auto w = std::make_shared<OriginWalk>();
+
+        w->progress = progress;
+        w->snapshot = snapshot;
+        w->ds       = directoryStructure;
+        w->modName  = e.modName.toStdWString();
+        w->path     = QDir::toNativeSeparators(e.absolutePath).toStdWString();
+        w->prio     = prio;
+        w->stats    = &stats[i];
+        w->merge    = true;
+
+        if (Settings::instance().archiveParsing()) {
+          for (auto&& a : e.archives) {
+            w->archives.push_back(a.toStdWString());
+          }
+
+          w->enabledArchives = enabledArchives;
+          w->loadOrder       = loadOrder;
+          w->indexes         = &m_ArchiveIndexes;
+        }
 
-        mt.progress = progress;
-        mt.ds       = directoryStructure;
-        mt.modName  = e.modName.toStdWString();
-        mt.path     = QDir::toNativeSeparators(e.absolutePath).toStdWString();
-        mt.prio     = prio;
+        startOrigin(m_Pool, w);
+        walks.push_back(w);
+      }
+    } catch (const std::exception& ex) {
+      emit error(tr("failed to read mod (%1): %2").arg(e.modName, ex.what()));
+    }
+  }
 
-        mt.archives.clear();
-        for (auto&& a : e.archives) {
-          mt.archives.push_back(a.toStdWString());
-        }
+  m_Pool.waitForAll();
 
-        mt.enabledArchives.clear();
-        for (auto&& a : m_EnabledArchives) {
-          mt.enabledArchives.insert(a.toStdWString());
-        }
+  // second phase: merge the listings of all the mods into the structure,
+  // origins are created in priority order
+  DirectoryStats mergeStats;
 
-        mt.stats = &stats[i];
+  {
+    std::vector<DirectoryEntry::OriginList> lists;
+    lists.reserve(walks.size());
 
-        mt.wakeup();
+    for (auto&& w : walks) {
+      // already logged by finishOrigin()
+      if (!w->complete()) {
+        continue;
       }
-    } catch (const std::exception& ex) {
-      emit error(tr("failed to read mod (%1): %2").arg(e.modName, ex.what()));
+
+      lists.push_back({w->modName, w->path, w->prio, &w->root});
     }
+
+    RefreshProfiler::Scope scope(RefreshProfiler::Phases::Merge);
+    directoryStructure->addFromLists(lists, m_threadCount, mergeStats);
   }
 
-  g_threads.waitForAll();
+  // archives are added last, they go through the regular locked insertion
+  for (auto&& w : walks) {
+    if (w->archives.empty() || !w->complete()) {
+      continue;
+    }
+
+    m_Pool.submit([w] {
+      RefreshProfiler::Scope scope(RefreshProfiler::Phases::Archives, w->modName);
 
-  if constexpr (DirectoryStats::EnableInstrumentation) {
-    dumpStats(stats);
+      w->ds->addFromAllBSAs(w->modName, w->path, w->prio, w->archives,
+                            w->enabledArchives, w->loadOrder, *w->stats, w->indexes);
+    });
   }
+
+  m_Pool.waitForAll();
+
+  // merging is not done per mod, its counters are reported for all mods
+  stats.push_back(mergeStats);
+  RefreshProfiler::instance().addStats(stats);
 }
 
 void DirectoryRefresher::refresh()
@@ -458,33 +664,87 @@ void DirectoryRefresher::refresh()
   TimeThis tt("DirectoryRefresher::refresh()");
   auto* p = new DirectoryRefreshProgress(this);
 
+  // finished by OrganizerCore once the plugin list has been refreshed
+  if (Settings::instance().diagnostics().refreshProfiling()) {
+    RefreshProfiler::instance().start();
+  }
+
   {
     QMutexLocker locker(&m_RefreshLock);
 
     m_Root.reset(new DirectoryEntry(L"data", nullptr, 0));
 
+    const QString snapshotPath = DirectorySnapshot::defaultPath();
+    DirectorySnapshot snapshotStorage;
+    DirectorySnapshot* snapshot = nullptr;
+
+    if (Settings::instance().directorySnapshot()) {
+      snapshot = &snapshotStorage;
+      snapshot->load(snapshotPath);
+    }
+
     IPluginGame* game = qApp->property("managed_game").value<IPluginGame*>();
 
     std::wstring dataDirectory =
         QDir::toNativeSeparators(game->dataDirectory().absolutePath()).toStdWString();
 
     {
+      // the data origin must be complete before mods are added, files of mods
+      // with stolen files are looked up in it
       DirectoryStats dummy;
-      m_Root->addFromOrigin(L"data", dataDirectory, 0, dummy);
+
+      auto w      = std::make_shared<OriginWalk>();
+      w->snapshot = snapshot;
+      w->ds       = m_Root.get();
+      w->modName  = L"data";
+      w->path     = dataDirectory;
+      w->prio     = 0;
+      w->stats    = &dummy;
+
+      startOrigin(m_Pool, w);
+      m_Pool.waitForAll();
     }
 
     std::sort(m_Mods.begin(), m_Mods.end(), [](auto lhs, auto rhs) {
       return lhs.priority < rhs.priority;
     });
 
-    addMultipleModsFilesToStructure(m_Root.get(), m_Mods, p);
+    addMultipleModsFilesToStructure(m_Root.get(), m_Mods, p, snapshot);
+
+    if (snapshot) {
+      log::debug("refresher restored {} origins from snapshot, walked {}",
+                 snapshot->restoredCount(), snapshot->capturedCount());
+
+      snapshot->save(snapshotPath);
+    }
+
+    const auto [mapped, built] = m_ArchiveIndexes.takeCounts();
+    log::debug("refresher mapped {} archive indices, read {} archives", mapped, built);
+
+    // stale indices are harmless, they're only looked for when archives have
+    // changed to avoid opening every index on each refresh
+    if (built > 0) {
+      m_ArchiveIndexes.prune();
+    }
+
+    {
+      RefreshProfiler::Scope scope(RefreshProfiler::Phases::Sort);
+
+      m_Root->getFileRegister()->sortOrigins();
+      cleanStructure(m_Root.get());
+    }
 
-    m_Root->getFileRegister()->sortOrigins();
+    const auto reg  = m_Root->getFileRegister();
+    m_lastFileCount = reg->highestCount();
 
-    cleanStructure(m_Root.get());
+    log::debug("refresher saw {} files, {} distinct names, {} MB in arena",
+               m_lastFileCount, reg->nameCount(),
+               reg->arena()->capacity() / (1024 * 1024));
 
-    m_lastFileCount = m_Root->getFileRegister()->highestCount();
-    log::debug("refresher saw {} files", m_lastFileCount);
+    // conflicts are computed here once for all mods instead of lazily by
+    // each mod on the ui thread
+    RefreshProfiler::Scope scope(RefreshProfiler::Phases::Conflicts);
+    m_ConflictIndex = ConflictIndex::create(*m_Root, m_threadCount);
   }
 
   p->finish();
@@ -20,9 +20,12 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DIRECTORYREFRESHER_H
 #define DIRECTORYREFRESHER_H
 
+#include "conflictindex.h"
 #include "profile.h"
+#include "shared/archiveindex.h"
 #include "shared/directoryentry.h"
 #include "shared/fileregisterfwd.h"
+#include "taskpool.h"
 #include <QMutex>
 #include <QObject>
 #include <QStringList>
@@ -30,6 +33,8 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <tuple>
 #include <vector>
 
+class DirectorySnapshot;
+
 /**
  * @brief used to asynchronously generate the virtual view of the combined data
  *directory
@@ -66,6 +71,15 @@ public:
    **/
   MOShared::DirectoryEntry* stealDirectoryStructure();
 
+  /**
+   * @brief retrieve the conflict index computed for the updated structure
+   *
+   * like stealDirectoryStructure(), the caller takes custody of the index
+   *
+   * @return conflict index, or null if no refresh finished since the last call
+   **/
+  std::unique_ptr<ConflictIndex> stealConflictIndex();
+
   /**
    * @brief sets up the mods to be included in the directory structure
    *
@@ -126,9 +140,22 @@ public:
                               const QString& modName, int priority,
                               const QString& directory, const QStringList& stealFiles);
 
+  /**
+   * @brief add the regular files and bsas of multiple mods in parallel
+   *
+   * mods are first walked into private listings, which are then merged into
+   * the structure in one parallel pass, see DirectoryEntry::addFromLists()
+   *
+   * @param directoryStructure
+   * @param entries
+   * @param progress
+   * @param snapshot if not null, unchanged mods are restored from it instead of
+   *  being walked, and walked mods are captured into it
+   */
   void addMultipleModsFilesToStructure(MOShared::DirectoryEntry* directoryStructure,
                                        const std::vector<EntryInfo>& entries,
-                                       DirectoryRefreshProgress* progress = nullptr);
+                                       DirectoryRefreshProgress* progress = nullptr,
+                                       DirectorySnapshot* snapshot        = nullptr);
 
   void updateProgress(const DirectoryRefreshProgress* p);
 
@@ -149,9 +176,12 @@ private:
   std::vector<EntryInfo> m_Mods;
   std::set<QString> m_EnabledArchives;
   std::unique_ptr<MOShared::DirectoryEntry> m_Root;
+  std::unique_ptr<ConflictIndex> m_ConflictIndex;
   QMutex m_RefreshLock;
   std::size_t m_threadCount;
   std::size_t m_lastFileCount;
+  MOShared::TaskPool m_Pool;
+  MOShared::ArchiveIndexCache m_ArchiveIndexes;
 
   void stealModFilesIntoStructure(MOShared::DirectoryEntry* directoryStructure,
                                   const QString& modName, int priority,
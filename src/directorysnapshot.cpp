@@ -0,0 +1,540 @@
+#include "directorysnapshot.h"
+#include "settings.h"
+#include "shared/util.h"
+#include <QDir>
+#include <QSaveFile>
+#include <log.h>
+
+using namespace MOBase;
+
+namespace
+{
+
+constexpr std::uint32_t SnapshotMagic = 0x53324f4d;  // "MO2S"
+
+// magic and version
+constexpr std::uint64_t HeaderSize = 2 * sizeof(std::uint32_t);
+
+struct SnapshotError : public std::runtime_error
+{
+  using runtime_error::runtime_error;
+};
+
+std::uint64_t toUInt64(FILETIME ft)
+{
+  return (static_cast<std::uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+}
+
+FILETIME toFILETIME(std::uint64_t v)
+{
+  FILETIME ft;
+  ft.dwLowDateTime  = static_cast<DWORD>(v & 0xffffffff);
+  ft.dwHighDateTime = static_cast<DWORD>(v >> 32);
+  return ft;
+}
+
+// last write time of the given directory, 0 if it doesn't exist
+//
+std::uint64_t directoryTime(const std::wstring& path)
+{
+  WIN32_FILE_ATTRIBUTE_DATA data = {};
+
+  if (!::GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data)) {
+    return 0;
+  }
+
+  if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) == 0) {
+    return 0;
+  }
+
+  return toUInt64(data.ftLastWriteTime);
+}
+
+// appends plain values to a byte array, in native byte order
+//
+class Writer
+{
+public:
+  Writer(QByteArray& out) : m_out(out) {}
+
+  template <class T>
+  void write(T v)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    m_out.append(reinterpret_cast<const char*>(&v), sizeof(T));
+  }
+
+  void write(const std::wstring& s)
+  {
+    write(static_cast<std::uint32_t>(s.size()));
+    m_out.append(reinterpret_cast<const char*>(s.data()),
+                 static_cast<int>(s.size() * sizeof(wchar_t)));
+  }
+
+private:
+  QByteArray& m_out;
+};
+
+// reads values written by Writer from a memory range, throws SnapshotError
+// when going past the end
+//
+class Reader
+{
+public:
+  Reader(const uchar* begin, const uchar* end) : m_p(begin), m_end(end) {}
+
+  template <class T>
+  T read()
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    need(sizeof(T));
+
+    T v;
+    std::memcpy(&v, m_p, sizeof(T));
+    m_p += sizeof(T);
+
+    return v;
+  }
+
+  std::wstring readString()
+  {
+    const auto length = read<std::uint32_t>();
+    const auto bytes  = static_cast<std::size_t>(length) * sizeof(wchar_t);
+
+    need(bytes);
+
+    std::wstring s(length, L'\0');
+    std::memcpy(s.data(), m_p, bytes);
+    m_p += bytes;
+
+    return s;
+  }
+
+  const uchar* pos() const { return m_p; }
+
+  bool atEnd() const { return (m_p == m_end); }
+
+private:
+  const uchar* m_p;
+  const uchar* m_end;
+
+  void need(std::size_t n) const
+  {
+    if (static_cast<std::size_t>(m_end - m_p) < n) {
+      throw SnapshotError("unexpected end of snapshot");
+    }
+  }
+};
+
+// directory node:
+//   name, last write time taken before listing it,
+//   file count, then (name, last write time, size) for each file,
+//   directory count, then a node for each directory
+//
+std::size_t writeDirectory(Writer& w, const env::Directory& d)
+{
+  std::size_t files = d.files.size();
+
+  w.write(d.name);
+  w.write(toUInt64(d.lastModified));
+
+  w.write(static_cast<std::uint32_t>(d.files.size()));
+  for (auto&& f : d.files) {
+    w.write(f.name);
+    w.write(toUInt64(f.lastModified));
+    w.write(f.size);
+  }
+
+  w.write(static_cast<std::uint32_t>(d.dirs.size()));
+  for (auto&& sd : d.dirs) {
+    files += writeDirectory(w, sd);
+  }
+
+  return files;
+}
+
+// reads a directory node into `d` and adds it and its subdirectories to
+// `dirs`; returns false if the directory had no time when it was listed, in
+// which case it can't be checked
+//
+bool readDirectory(Reader& r, env::Directory& d, const std::wstring& path,
+                   std::vector<DirectorySnapshot::DirectoryTime>& dirs,
+                   std::size_t& files)
+{
+  d = env::Directory(r.readString());
+
+  const auto time = r.read<std::uint64_t>();
+  if (time == 0) {
+    return false;
+  }
+
+  d.lastModified = toFILETIME(time);
+  dirs.push_back({path, time});
+
+  const auto fileCount = r.read<std::uint32_t>();
+  d.files.reserve(fileCount);
+
+  for (std::uint32_t i = 0; i < fileCount; ++i) {
+    auto name       = r.readString();
+    const auto time = r.read<std::uint64_t>();
+    const auto size = r.read<std::uint64_t>();
+
+    d.files.emplace_back(name, toFILETIME(time), size);
+  }
+
+  files += fileCount;
+
+  const auto dirCount = r.read<std::uint32_t>();
+  d.dirs.resize(dirCount);
+
+  for (auto&& sd : d.dirs) {
+    // the name is only known once the node has been read, so the path is built
+    // from a peek at the name
+    Reader peek = r;
+    const auto name = peek.readString();
+
+    if (!readDirectory(r, sd, path + L"\\" + name, dirs, files)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+}  // namespace
+
+DirectorySnapshot::DirectorySnapshot()
+    : m_Map(nullptr), m_RecordBytes(0), m_Damaged(false)
+{}
+
+DirectorySnapshot::~DirectorySnapshot()
+{
+  close();
+}
+
+QString DirectorySnapshot::defaultPath()
+{
+  return Settings::instance().paths().cache() + "/directory.snapshot";
+}
+
+bool DirectorySnapshot::load(const QString& path)
+{
+  close();
+
+  {
+    std::scoped_lock lock(m_PendingMutex);
+    m_Restored.clear();
+    m_Captured.clear();
+  }
+
+  m_File.setFileName(path);
+
+  if (!m_File.exists()) {
+    log::debug("no directory snapshot at '{}'", path);
+    return false;
+  }
+
+  if (!m_File.open(QIODevice::ReadOnly)) {
+    log::warn("can't open directory snapshot '{}': {}", path, m_File.errorString());
+    return false;
+  }
+
+  m_Map = m_File.map(0, m_File.size());
+  if (!m_Map) {
+    log::warn("can't map directory snapshot '{}': {}", path, m_File.errorString());
+    close();
+    return false;
+  }
+
+  try {
+    Reader r(m_Map, m_Map + m_File.size());
+
+    if (r.read<std::uint32_t>() != SnapshotMagic) {
+      throw SnapshotError("bad magic");
+    }
+
+    const auto version = r.read<std::uint32_t>();
+    if (version != Version) {
+      log::debug("directory snapshot has version {}, expected {}, ignoring", version,
+                 Version);
+
+      close();
+      return false;
+    }
+
+    // records are appended by save(), a later record for the same origin
+    // replaces the earlier one
+    while (!r.atEnd()) {
+      const uchar* start = r.pos();
+
+      try {
+        const auto size   = r.read<std::uint64_t>();
+        const uchar* body = r.pos();
+
+        if (static_cast<std::uint64_t>(m_Map + m_File.size() - body) < size) {
+          throw SnapshotError("truncated record");
+        }
+
+        Reader header(body, body + size);
+        const auto originName = header.readString();
+
+        m_Records[originName] = {start, static_cast<std::size_t>(body + size - start)};
+
+        r = Reader(body + size, m_Map + m_File.size());
+      } catch (SnapshotError& e) {
+        // probably interrupted while appending, the records before are fine
+        // but the file will have to be rewritten
+        log::warn("directory snapshot '{}' has a damaged record: {}", path,
+                  e.what());
+
+        m_Damaged = true;
+        break;
+      }
+    }
+
+    m_RecordBytes = static_cast<std::uint64_t>(r.pos() - m_Map) - HeaderSize;
+  } catch (SnapshotError& e) {
+    log::warn("directory snapshot '{}' is corrupted, ignoring: {}", path, e.what());
+    close();
+    return false;
+  }
+
+  log::debug("loaded directory snapshot with {} origins", m_Records.size());
+  return true;
+}
+
+bool DirectorySnapshot::read(const std::wstring& originName, const std::wstring& path,
+                             env::Directory& root,
+                             std::vector<DirectoryTime>& dirs) const
+{
+  auto itor = m_Records.find(originName);
+  if (itor == m_Records.end()) {
+    return false;
+  }
+
+  const Record& rec = itor->second;
+
+  try {
+    // record:
+    //   size, origin name, path, total file count, root directory node
+    Reader r(rec.data, rec.data + rec.size);
+    r.read<std::uint64_t>();
+    r.readString();
+
+    if (!MOShared::CaseInsensitiveEqual(r.readString(), path)) {
+      return false;
+    }
+
+    const auto expectedFiles = r.read<std::uint64_t>();
+    std::size_t files        = 0;
+
+    if (!readDirectory(r, root, path, dirs, files)) {
+      root = {};
+      dirs.clear();
+      return false;
+    }
+
+    // only checks the record itself, changes on disk are caught by
+    // unchanged()
+    if (files != expectedFiles || !r.atEnd()) {
+      throw SnapshotError("inconsistent record");
+    }
+  } catch (SnapshotError& e) {
+    log::warn("directory snapshot record for '{}' is corrupted: {}", originName,
+              e.what());
+
+    root = {};
+    dirs.clear();
+    return false;
+  }
+
+  return true;
+}
+
+bool DirectorySnapshot::unchanged(const DirectoryTime* begin, const DirectoryTime* end)
+{
+  for (auto* d = begin; d != end; ++d) {
+    if (directoryTime(d->path) != d->time) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void DirectorySnapshot::keep(const std::wstring& originName)
+{
+  auto itor = m_Records.find(originName);
+  if (itor == m_Records.end()) {
+    return;
+  }
+
+  std::scoped_lock lock(m_PendingMutex);
+  m_Restored.push_back(itor->second);
+}
+
+void DirectorySnapshot::capture(const std::wstring& originName,
+                                const std::wstring& path, const env::Directory& root)
+{
+  QByteArray body;
+  Writer w(body);
+
+  w.write(originName);
+  w.write(path);
+
+  // the file count is only known after writing the tree, so it's written
+  // to a separate buffer
+  QByteArray tree;
+  Writer tw(tree);
+  const std::uint64_t files = writeDirectory(tw, root);
+
+  w.write(files);
+  body.append(tree);
+
+  QByteArray rec;
+  Writer rw(rec);
+  rw.write(static_cast<std::uint64_t>(body.size()));
+  rec.append(body);
+
+  std::scoped_lock lock(m_PendingMutex);
+  m_Captured.push_back(std::move(rec));
+}
+
+bool DirectorySnapshot::save(const QString& path)
+{
+  std::vector<Record> restored;
+  std::vector<QByteArray> captured;
+
+  {
+    std::scoped_lock lock(m_PendingMutex);
+    restored.swap(m_Restored);
+    captured.swap(m_Captured);
+  }
+
+  std::uint64_t liveBytes     = 0;
+  std::uint64_t capturedBytes = 0;
+
+  for (auto&& rec : restored) {
+    liveBytes += rec.size;
+  }
+
+  for (auto&& rec : captured) {
+    capturedBytes += static_cast<std::uint64_t>(rec.size());
+  }
+
+  liveBytes += capturedBytes;
+
+  // everything in the file that isn't live is a replaced record or an origin
+  // that wasn't part of this refresh
+  const std::uint64_t totalBytes = m_RecordBytes + capturedBytes;
+  const bool canAppend           = (m_Map != nullptr && !m_Damaged);
+
+  if (canAppend && totalBytes <= liveBytes * 2) {
+    // the loaded snapshot must be unmapped before it can be written to
+    close();
+
+    if (captured.empty()) {
+      return true;
+    }
+
+    return append(path, captured);
+  }
+
+  // restored records point into the mapped file, they're copied before it's
+  // unmapped
+  std::vector<QByteArray> records;
+  records.reserve(restored.size() + captured.size());
+
+  for (auto&& rec : restored) {
+    records.emplace_back(reinterpret_cast<const char*>(rec.data),
+                         static_cast<int>(rec.size));
+  }
+
+  for (auto&& rec : captured) {
+    records.push_back(std::move(rec));
+  }
+
+  close();
+
+  return rewrite(path, records);
+}
+
+bool DirectorySnapshot::append(const QString& path,
+                               const std::vector<QByteArray>& captured)
+{
+  QFile f(path);
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Append)) {
+    log::warn("can't write directory snapshot '{}': {}", path, f.errorString());
+    return false;
+  }
+
+  for (auto&& rec : captured) {
+    if (f.write(rec) != rec.size()) {
+      // load() ignores a truncated record at the end and rewrites the file
+      // next time
+      log::warn("can't write directory snapshot '{}': {}", path, f.errorString());
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool DirectorySnapshot::rewrite(const QString& path,
+                                const std::vector<QByteArray>& records)
+{
+  QDir().mkpath(QFileInfo(path).absolutePath());
+
+  QSaveFile f(path);
+  if (!f.open(QIODevice::WriteOnly)) {
+    log::warn("can't write directory snapshot '{}': {}", path, f.errorString());
+    return false;
+  }
+
+  QByteArray header;
+  Writer w(header);
+  w.write(SnapshotMagic);
+  w.write(Version);
+
+  f.write(header);
+
+  for (auto&& rec : records) {
+    f.write(rec);
+  }
+
+  if (!f.commit()) {
+    log::warn("can't write directory snapshot '{}': {}", path, f.errorString());
+    return false;
+  }
+
+  return true;
+}
+
+std::size_t DirectorySnapshot::restoredCount() const
+{
+  std::scoped_lock lock(m_PendingMutex);
+  return m_Restored.size();
+}
+
+std::size_t DirectorySnapshot::capturedCount() const
+{
+  std::scoped_lock lock(m_PendingMutex);
+  return m_Captured.size();
+}
+
+void DirectorySnapshot::close()
+{
+  m_Records.clear();
+  m_RecordBytes = 0;
+  m_Damaged     = false;
+
+  if (m_Map) {
+    m_File.unmap(m_Map);
+    m_Map = nullptr;
+  }
+
+  if (m_File.isOpen()) {
+    m_File.close();
+  }
+}
@@ -0,0 +1,132 @@
+#ifndef MO_REGISTER_DIRECTORYSNAPSHOT_INCLUDED
+#define MO_REGISTER_DIRECTORYSNAPSHOT_INCLUDED
+
+#include "envfs.h"
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <mutex>
+#include <unordered_map>
+
+// persistent listing of the loose files of every origin, written after a
+// refresh and memory-mapped on the next one
+//
+// each origin is stored as a self-contained record with the last write time
+// every directory had right before it was listed; an origin is only restored
+// if all of its directories still have the same time on disk, otherwise it is
+// walked again
+//
+// a directory's time changes when entries are added, removed or renamed in it,
+// but not when a file is modified in place; the time and size of such a file
+// stay the ones from the snapshot until the file is changed again while MO is
+// running, in which case ChangeJournal updates it; this is the trade-off for
+// not looking up every file, see Settings::directorySnapshot()
+//
+// a refresh uses this as follows:
+//   1) load() maps the snapshot from the previous refresh, if any
+//   2) worker threads call read() for each origin, check the directories with
+//      unchanged(), split over several tasks for large origins, and call keep()
+//      if none changed; otherwise they walk the directory themselves and call
+//      capture() with the result
+//   3) save() appends the captured origins to the snapshot; a later record
+//      for an origin replaces the earlier ones, and the file is only rewritten
+//      from scratch when most of it is made of replaced records or origins
+//      that are not part of the refresh anymore
+//
+// read(), unchanged(), keep() and capture() are thread-safe, load() and save()
+// are not
+//
+class DirectorySnapshot
+{
+public:
+  // bumped every time the on-disk format changes, snapshots with a different
+  // version are ignored
+  static constexpr std::uint32_t Version = 3;
+
+  // a directory of an origin and the last write time it had when it was
+  // listed
+  //
+  struct DirectoryTime
+  {
+    std::wstring path;
+    std::uint64_t time;
+  };
+
+  DirectorySnapshot();
+  ~DirectorySnapshot();
+
+  // noncopyable
+  DirectorySnapshot(const DirectorySnapshot&)            = delete;
+  DirectorySnapshot& operator=(const DirectorySnapshot&) = delete;
+
+  // default location of the snapshot for the current instance
+  //
+  static QString defaultPath();
+
+  // maps the given snapshot file and indexes its origins; returns false if the
+  // file doesn't exist, can't be mapped or is from a different version, in
+  // which case all origins will have to be walked
+  //
+  bool load(const QString& path);
+
+  // fills `root` with the files of the given origin if it is in the snapshot
+  // and adds all of its directories to `dirs`, without looking at the disk;
+  // the listing can only be used if unchanged() is true for all of them
+  //
+  bool read(const std::wstring& originName, const std::wstring& path,
+            env::Directory& root, std::vector<DirectoryTime>& dirs) const;
+
+  // whether all the given directories still have the same last write time on
+  // disk
+  //
+  static bool unchanged(const DirectoryTime* begin, const DirectoryTime* end);
+
+  // keeps the record of an origin that was read and is unchanged for the next
+  // save()
+  //
+  void keep(const std::wstring& originName);
+
+  // remembers the files of the given origin that were just walked from disk
+  //
+  void capture(const std::wstring& originName, const std::wstring& path,
+               const env::Directory& root);
+
+  // unmaps the loaded snapshot and adds the origins that were captured since
+  // load(); origins that were neither restored nor captured are dropped the
+  // next time the file is rewritten
+  //
+  bool save(const QString& path);
+
+  // number of origins restored and captured since load(), for logging
+  //
+  std::size_t restoredCount() const;
+  std::size_t capturedCount() const;
+
+private:
+  struct Record
+  {
+    const uchar* data = nullptr;
+    std::size_t size  = 0;
+  };
+
+  QFile m_File;
+  uchar* m_Map;
+  std::unordered_map<std::wstring, Record> m_Records;
+
+  // bytes of records in the loaded file, including the ones that were replaced
+  // by a later record
+  std::uint64_t m_RecordBytes;
+
+  // the end of the loaded file couldn't be read, records can't be appended
+  bool m_Damaged;
+
+  mutable std::mutex m_PendingMutex;
+  std::vector<Record> m_Restored;
+  std::vector<QByteArray> m_Captured;
+
+  void close();
+  bool append(const QString& path, const std::vector<QByteArray>& captured);
+  bool rewrite(const QString& path, const std::vector<QByteArray>& records);
+};
+
+#endif  // MO_REGISTER_DIRECTORYSNAPSHOT_INCLUDED
@@ -28,6 +28,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "nxmurl.h"
 #include "organizercore.h"
 #include "selectiondialog.h"
+#include "settings.h"
 #include "shared/util.h"
 #include "utility.h"
 #include <nxmurl.h>
@@ -55,6 +56,17 @@ using namespace MOBase;
 
 static const char UNFINISHED[] = ".unfinished";
 
+// FILETIME as milliseconds since the epoch, like QDateTime::toMSecsSinceEpoch()
+static qint64 fileTimeToMSecs(FILETIME ft)
+{
+  ULARGE_INTEGER i;
+  i.LowPart  = ft.dwLowDateTime;
+  i.HighPart = ft.dwHighDateTime;
+
+  // FILETIME is in 100ns intervals since 1601
+  return static_cast<qint64>((i.QuadPart - 116444736000000000ULL) / 10000);
+}
+
 unsigned int DownloadManager::DownloadInfo::s_NextDownloadID = 1U;
 int DownloadManager::m_DirWatcherDisabler                    = 0;
 
@@ -82,7 +94,8 @@ DownloadManager::DownloadInfo::createNew(const ModRepositoryFileInfo* fileInfo,
 DownloadManager::DownloadInfo*
 DownloadManager::DownloadInfo::createFromMeta(const QString& filePath, bool showHidden,
                                               const QString outputDirectory,
-                                              std::optional<uint64_t> fileSize)
+                                              std::optional<uint64_t> fileSize,
+                                              const ModMeta* meta)
 {
   DownloadInfo* info = new DownloadInfo;
 
@@ -92,7 +105,7 @@ DownloadManager::DownloadInfo::createFromMeta(const QString& filePath, bool show
           .compare(QDir::fromNativeSeparators(outputDirectory), Qt::CaseInsensitive) !=
       0)
     return nullptr;
-  QSettings metaFile(metaFileName, QSettings::IniFormat);
+  const ModMeta metaFile = meta ? *meta : ModMeta::read(metaFileName);
   if (!showHidden && metaFile.value("removed", false).toBool()) {
     return nullptr;
   } else {
@@ -150,6 +163,10 @@ DownloadManager::DownloadInfo::createFromMeta(const QString& filePath, bool show
   info->m_FileInfo->userData     = metaFile.value("userData").toMap();
   info->m_Reply                  = nullptr;
 
+  info->m_Hash     = QByteArray::fromHex(metaFile.value("md5").toString().toLatin1());
+  info->m_HashSize = metaFile.value("md5Size", 0).toLongLong();
+  info->m_HashTime = metaFile.value("md5Time").toDateTime();
+
   return info;
 }
 
@@ -217,12 +234,24 @@ DownloadManager::DownloadManager(NexusInterface* nexusInterface, QObject* parent
   m_TimeoutTimer.setSingleShot(false);
   // connect(&m_TimeoutTimer, SIGNAL(timeout()), this, SLOT(checkDownloadTimeout()));
   m_TimeoutTimer.start(5 * 1000);
+
+  connect(&m_HashService, &HashService::progress, this, &DownloadManager::hashProgress);
+  connect(&m_HashService, &HashService::finished, this, &DownloadManager::hashFinished);
+  connect(&m_HashService, &HashService::failed, this, &DownloadManager::hashFailed);
+
+  connect(&m_Writer, &DownloadWriter::drained, this, &DownloadManager::writerDrained);
+  connect(&m_Writer, &DownloadWriter::failed, this, &DownloadManager::writerFailed);
+
+  connect(&m_ProgressTimer, &QTimer::timeout, this, &DownloadManager::reportProgress);
+  m_ProgressTimer.start(250);
 }
 
 DownloadManager::~DownloadManager()
 {
   for (QVector<DownloadInfo*>::iterator iter = m_ActiveDownloads.begin();
        iter != m_ActiveDownloads.end(); ++iter) {
+    // the writer thread may still be using the file
+    flushData(*iter);
     delete *iter;
   }
   m_ActiveDownloads.clear();
@@ -323,16 +352,9 @@ void DownloadManager::refreshList()
 
     int downloadsBefore = m_ActiveDownloads.size();
 
-    // remove finished downloads
-    for (QVector<DownloadInfo*>::iterator iter = m_ActiveDownloads.begin();
-         iter != m_ActiveDownloads.end();) {
-      if (((*iter)->m_State == STATE_READY) || ((*iter)->m_State == STATE_INSTALLED) ||
-          ((*iter)->m_State == STATE_UNINSTALLED)) {
-        delete *iter;
-        iter = m_ActiveDownloads.erase(iter);
-      } else {
-        ++iter;
-      }
+    const auto indexPath = Settings::instance().paths().cache() + "/downloads.cache";
+    if (m_MetaIndex.path() != indexPath) {
+      m_MetaIndex.load(indexPath);
     }
 
     const QStringList supportedExtensions =
@@ -346,14 +368,38 @@ void DownloadManager::refreshList()
 
     QDir dir(QDir::fromNativeSeparators(m_OutputDirectory));
 
+    // everything in the folder by lowercase name, including the meta files;
+    // the sizes are the ones on disk, they're only compared with each other
+    struct Entry
+    {
+      std::wstring name;
+      qint64 size;
+      qint64 time;
+    };
+
+    std::map<std::wstring, Entry> files;
+
+    env::forEachEntry(
+        QDir::toNativeSeparators(m_OutputDirectory).toStdWString(), &files, nullptr,
+        nullptr, [](void* data, std::wstring_view f, FILETIME ft, uint64_t size) {
+          auto& files = *static_cast<std::map<std::wstring, Entry>*>(data);
+
+          files.emplace(MOShared::ToLowerCopy(f),
+                        Entry{std::wstring(f), static_cast<qint64>(size),
+                              fileTimeToMSecs(ft)});
+        });
+
+    auto findMeta = [&](const std::wstring& lc) -> const Entry* {
+      auto itor = files.find(lc + L".meta");
+      return (itor == files.end() ? nullptr : &itor->second);
+    };
+
     // find orphaned meta files and delete them (sounds cruel but it's better for
     // everyone)
     QStringList orphans;
-    QStringList metaFiles = dir.entryList(QStringList() << "*.meta");
-    foreach (const QString& metaFile, metaFiles) {
-      QString baseFile = metaFile.left(metaFile.length() - 5);
-      if (!QFile::exists(dir.absoluteFilePath(baseFile))) {
-        orphans.append(dir.absoluteFilePath(metaFile));
+    for (auto&& [lc, e] : files) {
+      if (lc.ends_with(L".meta") && !files.contains(lc.substr(0, lc.size() - 5))) {
+        orphans.append(dir.absoluteFilePath(QString::fromStdWString(e.name)));
       }
     }
     if (orphans.size() > 0) {
@@ -362,62 +408,89 @@ void DownloadManager::refreshList()
     }
 
     std::set<std::wstring> seen;
+    std::size_t kept = 0;
 
-    struct Context
-    {
-      DownloadManager& self;
-      std::set<std::wstring>& seen;
-      std::vector<std::wstring>& extensions;
-    };
+    // finished downloads are kept as long as neither the file nor its meta
+    // file have changed, everything else is read again below
+    for (QVector<DownloadInfo*>::iterator iter = m_ActiveDownloads.begin();
+         iter != m_ActiveDownloads.end();) {
+      DownloadInfo* d = *iter;
+      const auto lc =
+          QFileInfo(d->m_Output.fileName()).fileName().toLower().toStdWString();
+
+      if ((d->m_State == STATE_READY) || (d->m_State == STATE_INSTALLED) ||
+          (d->m_State == STATE_UNINSTALLED)) {
+        auto file        = files.find(lc);
+        const Entry* m   = findMeta(lc);
+        const bool valid = (file != files.end()) &&
+                           (file->second.size == d->m_ScanSize) &&
+                           (m ? (m->size == d->m_MetaSize && m->time == d->m_MetaTime)
+                              : (d->m_MetaTime == -1)) &&
+                           (m_ShowHidden || !d->m_Hidden);
+
+        if (!valid) {
+          m_HashService.cancel(d->m_DownloadID);
+          delete d;
+          iter = m_ActiveDownloads.erase(iter);
+          continue;
+        }
 
-    Context cx = {*this, seen, nameFilters};
+        ++kept;
+      }
 
-    for (auto&& d : m_ActiveDownloads) {
-      cx.seen.insert(d->m_FileName.toLower().toStdWString());
-      cx.seen.insert(
-          QFileInfo(d->m_Output.fileName()).fileName().toLower().toStdWString());
+      seen.insert(d->m_FileName.toLower().toStdWString());
+      seen.insert(lc);
+      ++iter;
     }
 
-    env::forEachEntry(
-        QDir::toNativeSeparators(m_OutputDirectory).toStdWString(), &cx, nullptr,
-        nullptr, [](void* data, std::wstring_view f, FILETIME, uint64_t size) {
-          auto& cx = *static_cast<Context*>(data);
-
-          std::wstring lc = MOShared::ToLowerCopy(f);
-
-          bool interestingExt = false;
-          for (auto&& ext : cx.extensions) {
-            if (lc.ends_with(ext)) {
-              interestingExt = true;
-              break;
-            }
-          }
+    std::size_t added = 0;
 
-          if (!interestingExt) {
-            return;
-          }
+    for (auto&& [lc, e] : files) {
+      bool interestingExt = false;
+      for (auto&& ext : nameFilters) {
+        if (lc.ends_with(ext)) {
+          interestingExt = true;
+          break;
+        }
+      }
 
-          if (cx.seen.contains(lc)) {
-            return;
-          }
+      if (!interestingExt) {
+        continue;
+      }
 
-          QString fileName = QDir::fromNativeSeparators(cx.self.m_OutputDirectory) +
-                             "/" + QString::fromWCharArray(f.data(), f.size());
+      if (seen.contains(lc)) {
+        continue;
+      }
 
-          DownloadInfo* info = DownloadInfo::createFromMeta(
-              fileName, cx.self.m_ShowHidden, cx.self.m_OutputDirectory, size);
+      QString fileName = QDir::fromNativeSeparators(m_OutputDirectory) + "/" +
+                         QString::fromStdWString(e.name);
 
-          if (info == nullptr) {
-            return;
-          }
+      const Entry* m     = findMeta(lc);
+      const ModMeta meta = m ? m_MetaIndex.get(fileName + ".meta", m->size, m->time)
+                             : ModMeta();
 
-          cx.self.m_ActiveDownloads.push_front(info);
-          cx.seen.insert(std::move(lc));
-          cx.seen.insert(
-              QFileInfo(info->m_Output.fileName()).fileName().toLower().toStdWString());
-        });
+      DownloadInfo* info = DownloadInfo::createFromMeta(
+          fileName, m_ShowHidden, m_OutputDirectory, e.size, &meta);
+
+      if (info == nullptr) {
+        continue;
+      }
+
+      info->m_ScanSize = e.size;
+      info->m_MetaSize = m ? m->size : -1;
+      info->m_MetaTime = m ? m->time : -1;
 
-    log::debug("saw {} downloads", m_ActiveDownloads.size());
+      m_ActiveDownloads.push_front(info);
+      seen.insert(lc);
+      seen.insert(
+          QFileInfo(info->m_Output.fileName()).fileName().toLower().toStdWString());
+      ++added;
+    }
+
+    m_MetaIndex.save(indexPath);
+
+    log::debug("saw {} downloads, {} unchanged, {} read", m_ActiveDownloads.size(),
+               kept, added);
 
     emit update(-1);
 
@@ -547,6 +620,22 @@ void DownloadManager::startDownload(QNetworkReply* reply, DownloadInfo* newDownl
     return;
   }
 
+  if (!resume) {
+    newDownload->m_Hash.clear();
+    newDownload->m_Sink =
+        m_Writer.create(newDownload->m_DownloadID, newDownload->m_Output, true);
+  } else if (!newDownload->m_Sink) {
+    // resumed in a later session, the hash will be computed once the
+    // download finishes
+    newDownload->m_Sink =
+        m_Writer.create(newDownload->m_DownloadID, newDownload->m_Output, false);
+  } else if (newDownload->m_Sink->hashedBytes() != newDownload->m_Output.size()) {
+    // the file was changed while paused
+    newDownload->m_Sink->stopHashing();
+  }
+
+  newDownload->m_Preallocated = false;
+
   connect(newDownload->m_Reply, SIGNAL(downloadProgress(qint64, qint64)), this,
           SLOT(downloadProgress(qint64, qint64)));
   connect(newDownload->m_Reply, SIGNAL(errorOccurred(QNetworkReply::NetworkError)),
@@ -755,6 +844,9 @@ void DownloadManager::removeFile(int index, bool deleteFile)
     filePath = download->m_Output.fileName();
   }
 
+  // the file can't be deleted while it's being read
+  m_HashService.cancel(download->m_DownloadID);
+
   if (deleteFile) {
     if (!shellDelete(QStringList(filePath), true)) {
       reportError(tr("failed to delete %1").arg(filePath));
@@ -942,6 +1034,7 @@ void DownloadManager::resumeDownloadInt(int index)
     return;
   }
   DownloadInfo* info = m_ActiveDownloads[index];
+  flushData(info);
 
   // Check for finished download;
   if (info->m_TotalSize <= info->m_Output.size() && info->m_Reply != nullptr &&
@@ -955,7 +1048,7 @@ void DownloadManager::resumeDownloadInt(int index)
   if (info->isPausedState() || info->m_State == STATE_PAUSING) {
     if (info->m_State == STATE_PAUSING) {
       if (info->m_Output.isOpen()) {
-        writeData(info);
+        writeData(info, true);
         if (info->m_State == STATE_PAUSING) {
           setState(info, STATE_PAUSED);
         }
@@ -1081,6 +1174,11 @@ void DownloadManager::queryInfoMd5(int index)
     return;
   }
 
+  if (m_HashService.busy(info->m_DownloadID)) {
+    // already hashing, the query will start when it's done
+    return;
+  }
+
   info->m_GamesToQuery << m_ManagedGame->gameShortName();
   info->m_GamesToQuery << m_ManagedGame->validShortNames();
 
@@ -1093,38 +1191,80 @@ void DownloadManager::queryInfoMd5(int index)
     log::error("Can't find download file '{}'", info->m_FileName);
     return;
   }
-  if (!downloadFile.open(QIODevice::ReadOnly)) {
-    log::error("Can't open download file '{}'", info->m_FileName);
+
+  if (hashValid(info, downloadFile.fileName())) {
+    info->m_ReQueried = true;
+    setState(info, STATE_FETCHINGMODINFO_MD5);
     return;
   }
 
-  QCryptographicHash hash(QCryptographicHash::Md5);
-  const qint64 progressStep = 10 * 1024 * 1024;
-  QProgressDialog progress(tr("Hashing download file '%1'").arg(info->m_FileName),
-                           tr("Cancel"), 0, downloadFile.size() / progressStep);
-  progress.setWindowModality(Qt::WindowModal);
-  progress.setMinimumDuration(1000);
+  // hashing large archives takes a while, the query continues in
+  // hashFinished()
+  log::debug("hashing download file '{}'", downloadFile.fileName());
+  m_HashService.hash(info->m_DownloadID, downloadFile.fileName());
+}
 
-  for (qint64 i = 0; i < downloadFile.size(); i += progressStep) {
-    progress.setValue(progress.value() + 1);
-    if (progress.wasCanceled()) {
-      break;
-    }
-    hash.addData(downloadFile.read(progressStep));
+bool DownloadManager::hashValid(const DownloadInfo* info, const QString& path) const
+{
+  if (info->m_Hash.isEmpty()) {
+    return false;
+  }
+
+  const QFileInfo fi(path);
+
+  return (fi.size() == info->m_HashSize &&
+          fi.lastModified().toMSecsSinceEpoch() ==
+              info->m_HashTime.toMSecsSinceEpoch());
+}
+
+void DownloadManager::hashProgress(unsigned int id, qint64 done, qint64 total)
+{
+  DownloadInfo* info = downloadInfoByID(id);
+  if (info == nullptr) {
+    return;
   }
-  if (progress.wasCanceled()) {
-    downloadFile.close();
+
+  TaskProgressManager::instance().updateProgress(info->m_TaskProgressId, done, total);
+}
+
+void DownloadManager::hashFinished(unsigned int id, QByteArray md5, qint64 size,
+                                   QDateTime time)
+{
+  DownloadInfo* info = downloadInfoByID(id);
+  if (info == nullptr) {
     return;
   }
 
-  progress.close();
-  downloadFile.close();
+  TaskProgressManager::instance().forgetMe(info->m_TaskProgressId);
+
+  info->m_Hash     = md5;
+  info->m_HashSize = size;
+  info->m_HashTime = time;
+  createMetaFile(info);
+
+  if (info->m_State < STATE_READY || info->m_GamesToQuery.isEmpty()) {
+    // the download was resumed or the query was already answered
+    return;
+  }
 
-  info->m_Hash      = hash.result();
   info->m_ReQueried = true;
   setState(info, STATE_FETCHINGMODINFO_MD5);
 }
 
+void DownloadManager::hashFailed(unsigned int id, QString error)
+{
+  DownloadInfo* info = downloadInfoByID(id);
+  if (info == nullptr) {
+    return;
+  }
+
+  TaskProgressManager::instance().forgetMe(info->m_TaskProgressId);
+  info->m_GamesToQuery.clear();
+
+  emit showMessage(
+      tr("Failed to hash download file '%1': %2").arg(info->m_FileName).arg(error));
+}
+
 void DownloadManager::visitOnNexus(int index)
 {
   if ((index < 0) || (index >= m_ActiveDownloads.size())) {
@@ -1534,11 +1674,13 @@ void DownloadManager::setState(DownloadManager::DownloadInfo* info,
   switch (state) {
   case STATE_PAUSED: {
     info->m_Reply->abort();
+    flushData(info);
     info->m_Output.close();
     m_DownloadPaused(row);
   } break;
   case STATE_ERROR: {
     info->m_Reply->abort();
+    flushData(info);
     info->m_Output.close();
     m_DownloadFailed(row);
   } break;
@@ -1605,7 +1747,6 @@ void DownloadManager::downloadProgress(qint64 bytesReceived, qint64 bytesTotal)
         if (bytesTotal > info->m_TotalSize) {
           info->m_TotalSize = bytesTotal;
         }
-        int oldProgress        = info->m_Progress.first;
         info->m_Progress.first = ((info->m_ResumePos + bytesReceived) * 100) /
                                  (info->m_ResumePos + bytesTotal);
 
@@ -1615,21 +1756,16 @@ void DownloadManager::downloadProgress(qint64 bytesReceived, qint64 bytesTotal)
         info->m_DownloadTimeAcc(elapsed - info->m_DownloadTimeLast);
         info->m_DownloadTimeLast = elapsed;
 
-        // calculate the download speed
-        const double speed = rolling_mean(info->m_DownloadAcc) /
-                             (rolling_mean(info->m_DownloadTimeAcc) / 1000.0);
-        ;
+        // the text and the list are updated by reportProgress()
+        info->m_BytesReceived   = bytesReceived;
+        info->m_BytesTotal      = bytesTotal;
+        info->m_ProgressChanged = true;
 
-        const qint64 remaining = (bytesTotal - bytesReceived) / speed * 1000;
-
-        info->m_Progress.second = tr("%1% - %2 - ~%3")
-                                      .arg(info->m_Progress.first)
-                                      .arg(MOBase::localizedByteSpeed(speed))
-                                      .arg(MOBase::localizedTimeRemaining(remaining));
-
-        TaskProgressManager::instance().updateProgress(info->m_TaskProgressId,
-                                                       bytesReceived, bytesTotal);
-        emit update(index);
+        if (!info->m_Preallocated) {
+          info->m_Preallocated = true;
+          DownloadWriter::preallocate(info->m_Output.fileName(),
+                                      info->m_ResumePos + bytesTotal);
+        }
       }
     }
   } catch (const std::bad_alloc&) {
@@ -1673,6 +1809,16 @@ void DownloadManager::createMetaFile(DownloadInfo* info)
                                   (info->m_State == DownloadManager::STATE_ERROR));
   metaFile.setValue("removed", info->m_Hidden);
 
+  if (info->m_Hash.isEmpty()) {
+    metaFile.remove("md5");
+    metaFile.remove("md5Size");
+    metaFile.remove("md5Time");
+  } else {
+    metaFile.setValue("md5", QString(info->m_Hash.toHex()));
+    metaFile.setValue("md5Size", info->m_HashSize);
+    metaFile.setValue("md5Time", info->m_HashTime);
+  }
+
   endDisableDirWatcher();
   // slightly hackish...
   for (int i = 0; i < m_ActiveDownloads.size(); ++i) {
@@ -2149,10 +2295,12 @@ void DownloadManager::downloadFinished(int index)
 
   if (info != nullptr) {
     QNetworkReply* reply = info->m_Reply;
-    QByteArray data;
     if (reply->isOpen() && info->m_HasData) {
-      data = reply->readAll();
-      info->m_Output.write(data);
+      writeData(info, true);
+    }
+    if (!flushData(info) && (info->m_State == STATE_DOWNLOADING)) {
+      // writerFailed() reports the error
+      setState(info, STATE_CANCELING);
     }
     info->m_Output.close();
     TaskProgressManager::instance().forgetMe(info->m_TaskProgressId);
@@ -2188,7 +2336,7 @@ void DownloadManager::downloadFinished(int index)
       setState(info, STATE_CANCELED);
     } else if (info->m_State == STATE_PAUSING) {
       if (info->m_Output.isOpen() && info->m_HasData) {
-        info->m_Output.write(info->m_Reply->readAll());
+        writeData(info, true);
       }
       setState(info, STATE_PAUSED);
     }
@@ -2235,6 +2383,14 @@ void DownloadManager::downloadFinished(int index)
         setState(info, STATE_NOFETCH);
       }
 
+      // the data was hashed as it arrived, unless the download was resumed in
+      // another session
+      if (info->m_Sink && info->m_Sink->hashing() &&
+          info->m_Sink->hashedBytes() == info->m_Output.size()) {
+        info->m_Hash = info->m_Sink->hash();
+      }
+      info->m_Sink.reset();
+
       QString newName = getFileNameFromNetworkReply(reply);
       QString oldName = QFileInfo(info->m_Output).fileName();
 
@@ -2247,6 +2403,13 @@ void DownloadManager::downloadFinished(int index)
       }
       endDisableDirWatcher();
 
+      if (!info->m_Hash.isEmpty()) {
+        // renaming keeps the modification time
+        const QFileInfo fi(info->m_Output.fileName());
+        info->m_HashSize = fi.size();
+        info->m_HashTime = fi.lastModified();
+      }
+
       if (!isNexus) {
         setState(info, STATE_READY);
       }
@@ -2283,6 +2446,8 @@ void DownloadManager::metaDataChanged()
   if (info != nullptr) {
     QString newName = getFileNameFromNetworkReply(info->m_Reply);
     if (!newName.isEmpty() && (info->m_FileName.isEmpty())) {
+      // renaming closes the file
+      flushData(info);
       startDisableDirWatcher();
       info->setName(getDownloadFileName(newName), true);
       endDisableDirWatcher();
@@ -2325,23 +2490,80 @@ void DownloadManager::checkDownloadTimeout()
   }
 }
 
-void DownloadManager::writeData(DownloadInfo* info)
+void DownloadManager::writeData(DownloadInfo* info, bool all)
 {
-  if (info != nullptr) {
-    qint64 ret = info->m_Output.write(info->m_Reply->readAll());
-    if (ret < info->m_Reply->size()) {
-      QString fileName =
-          info->m_FileName;  // m_FileName may be destroyed after setState
-      setState(info, DownloadState::STATE_CANCELED);
+  if (info != nullptr && info->m_Sink) {
+    m_Writer.read(info->m_Sink, *info->m_Reply, all);
+  }
+}
+
+bool DownloadManager::flushData(DownloadInfo* info)
+{
+  if (!info->m_Sink) {
+    return true;
+  }
+
+  return m_Writer.flush(info->m_Sink);
+}
+
+void DownloadManager::writerDrained(unsigned int id)
+{
+  // the reply stops reading from the network while its data is waiting
+  DownloadInfo* info = downloadInfoByID(id);
+  if (info != nullptr && info->m_State == STATE_DOWNLOADING) {
+    writeData(info);
+  }
+}
 
-      log::error("Unable to write download \"{}\" to drive (return {})",
-                 info->m_FileName, ret);
+void DownloadManager::writerFailed(unsigned int id, QString path, QString error)
+{
+  DownloadInfo* info = downloadInfoByID(id);
+  if (info != nullptr && ((info->m_State == STATE_STARTED) ||
+                          (info->m_State == STATE_DOWNLOADING))) {
+    setState(info, DownloadState::STATE_CANCELED);
+  }
 
-      reportError(tr("Unable to write download to drive (return %1).\n"
-                     "Check the drive's available storage.\n\n"
-                     "Canceling download \"%2\"...")
-                      .arg(ret)
-                      .arg(fileName));
+  reportError(tr("Unable to write download to drive (%1).\n"
+                 "Check the drive's available storage.\n\n"
+                 "Canceling download \"%2\"...")
+                  .arg(error)
+                  .arg(QFileInfo(path).fileName()));
+}
+
+void DownloadManager::reportProgress()
+{
+  for (int i = 0; i < m_ActiveDownloads.size(); ++i) {
+    DownloadInfo* info = m_ActiveDownloads[i];
+    if (info->m_State != STATE_DOWNLOADING) {
+      continue;
     }
+
+    // slow downloads take a while to fill a buffer
+    if (info->m_Sink) {
+      m_Writer.submit(info->m_Sink);
+    }
+
+    if (!info->m_ProgressChanged) {
+      continue;
+    }
+
+    info->m_ProgressChanged = false;
+
+    // calculate the download speed
+    const double speed = rolling_mean(info->m_DownloadAcc) /
+                         (rolling_mean(info->m_DownloadTimeAcc) / 1000.0);
+
+    const qint64 remaining =
+        (info->m_BytesTotal - info->m_BytesReceived) / speed * 1000;
+
+    info->m_Progress.second = tr("%1% - %2 - ~%3")
+                                  .arg(info->m_Progress.first)
+                                  .arg(MOBase::localizedByteSpeed(speed))
+                                  .arg(MOBase::localizedTimeRemaining(remaining));
+
+    TaskProgressManager::instance().updateProgress(
+        info->m_TaskProgressId, info->m_BytesReceived, info->m_BytesTotal);
+
+    emit update(i);
   }
 }
@@ -20,6 +20,9 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DOWNLOADMANAGER_H
 #define DOWNLOADMANAGER_H
 
+#include "downloadwriter.h"
+#include "hashservice.h"
+#include "modmetaindex.h"
 #include "serverinfo.h"
 #include <QElapsedTimer>
 #include <QFile>
@@ -39,6 +42,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <boost/accumulators/statistics/rolling_mean.hpp>
 #include <boost/signals2.hpp>
 #include <idownloadmanager.h>
+#include <memory>
 #include <modrepositoryfileinfo.h>
 #include <set>
 using namespace boost::accumulators;
@@ -103,7 +107,32 @@ private:
     QDateTime m_Created;  // used as a cache in DownloadManager::getFileTime, may not be
                           // valid elsewhere
     QByteArray m_Hash;
+
+    // size and time of the file when m_Hash was computed, saved in the meta
+    // file so the hash is only computed once
+    qint64 m_HashSize = 0;
+    QDateTime m_HashTime;
+
+    // writes the data to m_Output on the writer thread and hashes it; kept
+    // while paused so the hash can continue when the download is resumed
+    DownloadWriter::SinkPtr m_Sink;
+
+    // whether space has been reserved for the file since it was opened
+    bool m_Preallocated = false;
+
+    // last values given by downloadProgress(), shown by reportProgress()
+    qint64 m_BytesReceived = 0;
+    qint64 m_BytesTotal    = 0;
+    bool m_ProgressChanged = false;
+
     QStringList m_GamesToQuery;
+
+    // size of the file and size and time of its meta file when they were
+    // read by refreshList(), -1 if unknown; finished downloads are only read
+    // again when they change
+    qint64 m_ScanSize = -1;
+    qint64 m_MetaSize = -1;
+    qint64 m_MetaTime = -1;
     QString m_RemoteFileName;
 
     int m_Tries;
@@ -117,9 +146,12 @@ private:
 
     static DownloadInfo* createNew(const MOBase::ModRepositoryFileInfo* fileInfo,
                                    const QStringList& URLs);
+    // `meta` is the content of the meta file if it's already known, it's read
+    // from disk otherwise
     static DownloadInfo* createFromMeta(const QString& filePath, bool showHidden,
                                         const QString outputDirectory,
-                                        std::optional<uint64_t> fileSize = {});
+                                        std::optional<uint64_t> fileSize = {},
+                                        const ModMeta* meta             = nullptr);
 
     /**
      * @brief rename the file
@@ -533,6 +565,14 @@ private slots:
   void directoryChanged(const QString& dirctory);
   void checkDownloadTimeout();
 
+  void hashProgress(unsigned int id, qint64 done, qint64 total);
+  void hashFinished(unsigned int id, QByteArray md5, qint64 size, QDateTime time);
+  void hashFailed(unsigned int id, QString error);
+
+  void writerDrained(unsigned int id);
+  void writerFailed(unsigned int id, QString path, QString error);
+  void reportProgress();
+
 private:
   void createMetaFile(DownloadInfo* info);
   DownloadManager::DownloadInfo* getDownloadInfo(QString fileName);
@@ -584,7 +624,19 @@ private:
 
   static QString getFileTypeString(int fileType);
 
-  void writeData(DownloadInfo* info);
+  // moves the data of the reply to the writer; if `all` is false, some may
+  // be left in the reply until the writer catches up
+  //
+  void writeData(DownloadInfo* info, bool all = false);
+
+  // waits until all the data read so far has been written, returns false if
+  // writing failed
+  //
+  bool flushData(DownloadInfo* info);
+
+  // whether the hash of the download is known and still matches the file
+  //
+  bool hashValid(const DownloadInfo* info, const QString& path) const;
 
 private:
   static const int AUTOMATIC_RETRIES = 3;
@@ -624,6 +676,19 @@ private:
   MOBase::IPluginGame const* m_ManagedGame;
 
   QTimer m_TimeoutTimer;
+
+  // progress is shown at a fixed rate instead of for every chunk of data
+  QTimer m_ProgressTimer;
+
+  DownloadWriter m_Writer;
+
+  // hashes finished downloads that weren't hashed while downloading, the id
+  // of the download is used as the tag
+  HashService m_HashService;
+
+  // contents of the meta files of all downloads, kept across sessions so
+  // refreshList() doesn't parse thousands of them every time
+  ModMetaIndex m_MetaIndex;
 };
 
 #endif  // DOWNLOADMANAGER_H
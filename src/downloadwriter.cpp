@@ -0,0 +1,274 @@
+#include "downloadwriter.h"
+#include "thread_utils.h"
+#include <log.h>
+#include <utility.h>
+
+using namespace MOBase;
+
+QByteArray DownloadWriter::Sink::hash() const
+{
+  if (!m_Hasher || m_Failed) {
+    return {};
+  }
+
+  return m_Hasher->result();
+}
+
+void DownloadWriter::Sink::stopHashing()
+{
+  m_Hasher.reset();
+}
+
+DownloadWriter::DownloadWriter(QObject* parent) : QObject(parent), m_Stop(false)
+{
+  m_Thread = MOShared::startSafeThread([&] {
+    threadFun();
+  });
+}
+
+DownloadWriter::~DownloadWriter()
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_Stop = true;
+  }
+
+  m_WorkAvailable.notify_all();
+  m_Thread.join();
+}
+
+DownloadWriter::SinkPtr DownloadWriter::create(unsigned int id, QFile& file, bool hash)
+{
+  auto s    = std::make_shared<Sink>();
+  s->m_ID   = id;
+  s->m_File = &file;
+
+  if (hash) {
+    s->m_Hasher = std::make_unique<QCryptographicHash>(QCryptographicHash::Md5);
+  }
+
+  return s;
+}
+
+qint64 DownloadWriter::read(const SinkPtr& s, QIODevice& from, bool all)
+{
+  qint64 total = 0;
+
+  while (from.bytesAvailable() > 0) {
+    if (s->m_Current.data.empty() && !takeBuffer(*s, all)) {
+      // everything is waiting to be written, the rest stays in the device
+      break;
+    }
+
+    auto& b        = s->m_Current;
+    const qint64 n = from.read(b.data.data() + b.used, BufferSize - b.used);
+
+    if (n <= 0) {
+      break;
+    }
+
+    b.used += n;
+    total += n;
+
+    if (b.used == BufferSize) {
+      submit(s);
+    }
+  }
+
+  return total;
+}
+
+void DownloadWriter::submit(const SinkPtr& s)
+{
+  if (s->m_Current.used == 0) {
+    return;
+  }
+
+  {
+    std::scoped_lock lock(s->m_Mutex);
+    s->m_Full.push_back(std::move(s->m_Current));
+  }
+
+  s->m_Current = {};
+
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_Queue.push_back(s);
+  }
+
+  m_WorkAvailable.notify_one();
+}
+
+bool DownloadWriter::flush(const SinkPtr& s)
+{
+  submit(s);
+
+  std::unique_lock lock(s->m_Mutex);
+
+  s->m_Done.wait(lock, [&] {
+    return (s->m_Full.empty() && !s->m_Writing);
+  });
+
+  return !s->m_Failed;
+}
+
+void DownloadWriter::preallocate(const QString& path, qint64 size)
+{
+  // QFile doesn't expose its handle, so a second one is opened; the space
+  // stays reserved as long as the file is open somewhere
+  HANDLE h = ::CreateFileW(path.toStdWString().c_str(), GENERIC_WRITE,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+  if (h == INVALID_HANDLE_VALUE) {
+    const auto e = ::GetLastError();
+    log::debug("can't open '{}' to preallocate it, {}", path, formatSystemMessage(e));
+    return;
+  }
+
+  FILE_ALLOCATION_INFO info     = {};
+  info.AllocationSize.QuadPart = size;
+
+  if (!::SetFileInformationByHandle(h, FileAllocationInfo, &info, sizeof(info))) {
+    const auto e = ::GetLastError();
+    log::debug("can't preallocate {} bytes for '{}', {}", size, path,
+               formatSystemMessage(e));
+  }
+
+  ::CloseHandle(h);
+}
+
+bool DownloadWriter::takeBuffer(Sink& s, bool wait)
+{
+  std::unique_lock lock(s.m_Mutex);
+
+  for (;;) {
+    if (!s.m_Free.empty()) {
+      s.m_Current = std::move(s.m_Free.back());
+      s.m_Free.pop_back();
+      s.m_Current.used = 0;
+      return true;
+    }
+
+    if (s.m_Allocated < MaxBuffers) {
+      ++s.m_Allocated;
+      lock.unlock();
+
+      s.m_Current.data.resize(BufferSize);
+      s.m_Current.used = 0;
+      return true;
+    }
+
+    if (!wait) {
+      s.m_Starved = true;
+      return false;
+    }
+
+    s.m_Done.wait(lock);
+  }
+}
+
+void DownloadWriter::threadFun()
+{
+  for (;;) {
+    SinkPtr s;
+
+    {
+      std::unique_lock lock(m_Mutex);
+
+      m_WorkAvailable.wait(lock, [&] {
+        return (m_Stop || !m_Queue.empty());
+      });
+
+      // everything is written before stopping
+      if (m_Queue.empty()) {
+        return;
+      }
+
+      s = std::move(m_Queue.front());
+      m_Queue.pop_front();
+    }
+
+    writeOne(s);
+  }
+}
+
+void DownloadWriter::writeOne(const SinkPtr& s)
+{
+  Sink::Buffer b;
+  bool failed = false;
+
+  {
+    std::scoped_lock lock(s->m_Mutex);
+
+    if (s->m_Full.empty()) {
+      return;
+    }
+
+    b = std::move(s->m_Full.front());
+    s->m_Full.pop_front();
+    s->m_Writing = true;
+    failed       = s->m_Failed;
+  }
+
+  QString error;
+
+  // data read after a failure is discarded
+  if (!failed) {
+    const qint64 written = s->m_File->write(b.data.data(), b.used);
+
+    if (written != b.used) {
+      error  = s->m_File->errorString();
+      failed = true;
+    } else if (s->m_Hasher) {
+      s->m_Hasher->addData(
+          QByteArray::fromRawData(b.data.data(), static_cast<int>(b.used)));
+      s->m_HashedBytes += b.used;
+    }
+  }
+
+  // the file may be gone once flush() returns
+  const auto path    = failed ? s->m_File->fileName() : QString();
+  bool reportFailure = false;
+  bool starved       = false;
+
+  {
+    std::scoped_lock lock(s->m_Mutex);
+
+    b.used = 0;
+    s->m_Free.push_back(std::move(b));
+    s->m_Writing = false;
+
+    if (failed && !s->m_Failed) {
+      s->m_Failed   = true;
+      reportFailure = true;
+    }
+
+    starved = std::exchange(s->m_Starved, false);
+  }
+
+  s->m_Done.notify_all();
+
+  // signals are emitted on the thread of the writer
+  const auto id = s->m_ID;
+
+  if (reportFailure) {
+    log::error("failed to write download to '{}': {}", path, error);
+
+    QMetaObject::invokeMethod(
+        this,
+        [this, id, path, error] {
+          emit failed(id, path, error);
+        },
+        Qt::QueuedConnection);
+  }
+
+  if (starved) {
+    QMetaObject::invokeMethod(
+        this,
+        [this, id] {
+          emit drained(id);
+        },
+        Qt::QueuedConnection);
+  }
+}
@@ -0,0 +1,164 @@
+#ifndef MODORGANIZER_DOWNLOADWRITER_INCLUDED
+#define MODORGANIZER_DOWNLOADWRITER_INCLUDED
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QFile>
+#include <QIODevice>
+#include <QObject>
+#include <QString>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// writes the data of downloads to disk on a dedicated thread
+//
+// the ui thread only moves data from the network reply into large buffers
+// that belong to the download, see read(); full buffers are written and
+// hashed by the writer thread and handed back to be filled again, so no
+// memory is allocated once a download is under way
+//
+// each download has a limited number of buffers: when they're all waiting to
+// be written, read() leaves the rest of the data in the reply, which stops
+// reading from the network until drained() is emitted
+//
+class DownloadWriter : public QObject
+{
+  Q_OBJECT
+
+public:
+  // size of each buffer
+  static constexpr qint64 BufferSize = 4 * 1024 * 1024;
+
+  // maximum number of buffers per download
+  static constexpr std::size_t MaxBuffers = 4;
+
+  // the data of one download; it's created by create() and owned by the
+  // download, the writer thread only uses it while it has buffers to write
+  //
+  class Sink
+  {
+  public:
+    // the following are only meaningful after flush()
+
+    // whether the data is being hashed
+    //
+    bool hashing() const { return (m_Hasher != nullptr); }
+
+    // number of bytes hashed so far
+    //
+    qint64 hashedBytes() const { return m_HashedBytes; }
+
+    // md5 of everything written since the sink was created, empty if the
+    // data is not hashed or if a write failed
+    //
+    QByteArray hash() const;
+
+    // stops hashing, used when the file has been modified by something else
+    //
+    void stopHashing();
+
+  private:
+    friend class DownloadWriter;
+
+    struct Buffer
+    {
+      std::vector<char> data;
+      qint64 used = 0;
+    };
+
+    unsigned int m_ID = 0;
+    QFile* m_File     = nullptr;
+
+    // only used by the ui thread
+    Buffer m_Current;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Done;
+
+    // buffers waiting to be written, and buffers that can be filled again
+    std::deque<Buffer> m_Full;
+    std::vector<Buffer> m_Free;
+    std::size_t m_Allocated = 0;
+
+    // whether the writer thread is currently writing one of the buffers
+    bool m_Writing = false;
+
+    // whether drained() should be emitted once a buffer is free
+    bool m_Starved = false;
+
+    bool m_Failed = false;
+
+    std::unique_ptr<QCryptographicHash> m_Hasher;
+    qint64 m_HashedBytes = 0;
+  };
+
+  using SinkPtr = std::shared_ptr<Sink>;
+
+  explicit DownloadWriter(QObject* parent = nullptr);
+
+  // writes what's left and stops the thread
+  ~DownloadWriter();
+
+  // creates a sink for the given file, which must stay open while data is
+  // being written; `id` is given back in signals
+  //
+  SinkPtr create(unsigned int id, QFile& file, bool hash);
+
+  // moves data from the device to the buffers of the sink, returns the number
+  // of bytes read
+  //
+  // if `all` is false, this stops when all the buffers of the sink are in use
+  // and drained() will be emitted when one is free; otherwise, this waits for
+  // the writer thread until all the data has been read
+  //
+  qint64 read(const SinkPtr& s, QIODevice& from, bool all = false);
+
+  // hands the partially filled buffer of the sink to the writer thread, so
+  // that slow downloads still reach the disk regularly
+  //
+  void submit(const SinkPtr& s);
+
+  // blocks until everything that was read so far has been written; returns
+  // false if a write failed
+  //
+  bool flush(const SinkPtr& s);
+
+  // reserves space on disk for the given file so it doesn't get fragmented
+  // while it grows, doesn't change its size
+  //
+  static void preallocate(const QString& path, qint64 size);
+
+signals:
+  // a buffer of the download has been written while read() was waiting for
+  // one
+  //
+  void drained(unsigned int id);
+
+  // writing to the given file failed, everything read afterwards is
+  // discarded
+  //
+  void failed(unsigned int id, QString path, QString error);
+
+private:
+  std::thread m_Thread;
+  std::mutex m_Mutex;
+  std::condition_variable m_WorkAvailable;
+
+  // one entry per full buffer
+  std::deque<SinkPtr> m_Queue;
+  bool m_Stop;
+
+  void threadFun();
+  void writeOne(const SinkPtr& s);
+
+  // gives the sink an empty buffer to fill; returns false if none is
+  // available and `wait` is false
+  //
+  bool takeBuffer(Sink& s, bool wait);
+};
+
+#endif  // MODORGANIZER_DOWNLOADWRITER_INCLUDED
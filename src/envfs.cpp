@@ -208,7 +208,7 @@ void setHandleCloserThreadCount(std::size_t n)
 void forEachEntryImpl(void* cx, HandleCloserThread& hc,
                       std::vector<std::unique_ptr<unsigned char[]>>& buffers,
                       POBJECT_ATTRIBUTES poa, std::size_t depth, DirStartF* dirStartF,
-                      DirEndF* dirEndF, FileF* fileF)
+                      DirEndF* dirEndF, FileF* fileF, DirTimeF* dirTimeF)
 {
   IO_STATUS_BLOCK iosb;
   UNICODE_STRING ObjectName;
@@ -227,6 +227,15 @@ void forEachEntryImpl(void* cx, HandleCloserThread& hc,
   }
 
   hc.add(oa.RootDirectory);
+
+  if (dirTimeF) {
+    // taken before listing, so a change made while listing makes the time
+    // outdated instead of being missed
+    FILETIME ft = {};
+    ::GetFileTime(oa.RootDirectory, nullptr, nullptr, &ft);
+    dirTimeF(cx, ft);
+  }
+
   unsigned char* buffer;
 
   if (depth >= buffers.size()) {
@@ -289,7 +298,7 @@ void forEachEntryImpl(void* cx, HandleCloserThread& hc,
           if (dirStartF && dirEndF) {
             dirStartF(cx, toStringView(&oa));
             forEachEntryImpl(cx, hc, buffers, &oa, depth + 1, dirStartF, dirEndF,
-                             fileF);
+                             fileF, dirTimeF);
             dirEndF(cx, toStringView(&oa));
           }
         } else {
@@ -329,7 +338,8 @@ std::wstring makeNtPath(const std::wstring& path)
 }
 
 void DirectoryWalker::forEachEntry(const std::wstring& path, void* cx,
-                                   DirStartF* dirStartF, DirEndF* dirEndF, FileF* fileF)
+                                   DirStartF* dirStartF, DirEndF* dirEndF, FileF* fileF,
+                                   DirTimeF* dirTimeF)
 {
   auto& hc = g_handleClosers.request();
 
@@ -352,7 +362,7 @@ void DirectoryWalker::forEachEntry(const std::wstring& path, void* cx,
   oa.Length            = sizeof(oa);
   oa.ObjectName        = &ObjectName;
 
-  forEachEntryImpl(cx, hc, m_buffers, &oa, 0, dirStartF, dirEndF, fileF);
+  forEachEntryImpl(cx, hc, m_buffers, &oa, 0, dirStartF, dirEndF, fileF, dirTimeF);
   hc.wakeup();
 }
 
@@ -363,6 +373,12 @@ void forEachEntry(const std::wstring& path, void* cx, DirStartF* dirStartF,
 }
 
 Directory getFilesAndDirs(const std::wstring& path)
+{
+  DirectoryWalker walker;
+  return getFilesAndDirs(walker, path);
+}
+
+Directory getFilesAndDirs(DirectoryWalker& walker, const std::wstring& path)
 {
   struct Context
   {
@@ -374,7 +390,7 @@ Directory getFilesAndDirs(const std::wstring& path)
   Context cx;
   cx.current.push(&root);
 
-  env::forEachEntry(
+  walker.forEachEntry(
       path, &cx,
       [](void* pcx, std::wstring_view path) {
         Context* cx = (Context*)pcx;
@@ -392,6 +408,12 @@ Directory getFilesAndDirs(const std::wstring& path)
         Context* cx = (Context*)pcx;
 
         cx->current.top()->files.push_back(File(path, ft, s));
+      },
+
+      [](void* pcx, FILETIME ft) {
+        Context* cx = (Context*)pcx;
+
+        cx->current.top()->lastModified = ft;
       });
 
   return root;
@@ -408,10 +430,17 @@ Directory::Directory(std::wstring_view n)
     : name(n.begin(), n.end()), lcname(MOShared::ToLowerCopy(name))
 {}
 
-void getFilesAndDirsWithFindImpl(const std::wstring& path, Directory& d)
+void getFilesAndDirsWithFindImpl(const std::wstring& path, Directory& d,
+                                 bool recursive)
 {
   const std::wstring searchString = path + L"\\*";
 
+  // taken before listing, see forEachEntryImpl()
+  WIN32_FILE_ATTRIBUTE_DATA data = {};
+  if (::GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data)) {
+    d.lastModified = data.ftLastWriteTime;
+  }
+
   WIN32_FIND_DATAW findData;
 
   HANDLE searchHandle =
@@ -425,9 +454,12 @@ void getFilesAndDirsWithFindImpl(const std::wstring& path, Directory& d)
       if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
         if ((wcscmp(findData.cFileName, L".") != 0) &&
             (wcscmp(findData.cFileName, L"..") != 0)) {
-          const std::wstring newPath = path + L"\\" + findData.cFileName;
           d.dirs.push_back(Directory(findData.cFileName));
-          getFilesAndDirsWithFindImpl(newPath, d.dirs.back());
+
+          if (recursive) {
+            const std::wstring newPath = path + L"\\" + findData.cFileName;
+            getFilesAndDirsWithFindImpl(newPath, d.dirs.back(), recursive);
+          }
         }
       } else {
         const auto size =
@@ -443,10 +475,10 @@ void getFilesAndDirsWithFindImpl(const std::wstring& path, Directory& d)
   ::FindClose(searchHandle);
 }
 
-Directory getFilesAndDirsWithFind(const std::wstring& path)
+Directory getFilesAndDirsWithFind(const std::wstring& path, bool recursive)
 {
   Directory d;
-  getFilesAndDirsWithFindImpl(path, d);
+  getFilesAndDirsWithFindImpl(path, d, recursive);
   return d;
 }
 
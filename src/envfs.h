@@ -22,6 +22,10 @@ struct Directory
   std::wstring name;
   std::wstring lcname;
 
+  // last write time of the directory itself, read right before it was listed;
+  // zero if it couldn't be read
+  FILETIME lastModified = {};
+
   std::vector<Directory> dirs;
   std::vector<File> files;
 
@@ -37,7 +41,14 @@ public:
 
   ~ThreadPool() { stopAndJoin(); }
 
-  void setMax(std::size_t n) { m_threads.resize(n); }
+  void setMax(std::size_t n)
+  {
+    m_threads.resize(n);
+
+    for (auto& ti : m_threads) {
+      ti.pool = this;
+    }
+  }
 
   void stopAndJoin()
   {
@@ -55,22 +66,17 @@ public:
 
   void waitForAll()
   {
-    for (;;) {
-      bool done = true;
+    std::unique_lock lock(m_mutex);
 
+    m_cv.wait(lock, [&] {
       for (auto& ti : m_threads) {
         if (ti.busy) {
-          done = false;
-          break;
+          return false;
         }
       }
 
-      if (done) {
-        break;
-      }
-
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
+      return true;
+    });
   }
 
   T& request()
@@ -79,17 +85,21 @@ public:
       std::terminate();
     }
 
+    std::unique_lock lock(m_mutex);
+
     for (;;) {
       for (auto& ti : m_threads) {
         bool expected = false;
 
         if (ti.busy.compare_exchange_strong(expected, true)) {
+          lock.unlock();
           ti.wakeup();
           return ti.o;
         }
       }
 
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      // woken up by a thread that finished its work
+      m_cv.wait(lock);
     }
   }
 
@@ -104,6 +114,7 @@ public:
 private:
   struct ThreadInfo
   {
+    ThreadPool* pool = nullptr;
     std::thread thread;
     std::atomic<bool> busy;
     T o;
@@ -114,7 +125,7 @@ private:
 
     std::atomic<bool> stop;
 
-    ThreadInfo() : busy(true), ready(false), stop(false)
+    ThreadInfo() : busy(false), ready(false), stop(false)
     {
       thread = MOShared::startSafeThread([&] {
         run();
@@ -142,8 +153,6 @@ private:
 
     void run()
     {
-      busy = false;
-
       while (!stop) {
         std::unique_lock lock(mutex);
         cv.wait(lock, [&] {
@@ -157,25 +166,39 @@ private:
         o.run();
 
         ready = false;
-        busy  = false;
+
+        {
+          std::scoped_lock poolLock(pool->m_mutex);
+          busy = false;
+        }
+
+        pool->m_cv.notify_all();
       }
     }
   };
 
   std::list<ThreadInfo> m_threads;
+
+  // signalled every time a thread becomes available
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
 };
 
 using DirStartF = void(void*, std::wstring_view);
 using DirEndF   = void(void*, std::wstring_view);
 using FileF     = void(void*, std::wstring_view, FILETIME, uint64_t);
 
+// called with the last write time of a directory after it has been opened and
+// before its entries are reported, for the root directory too
+using DirTimeF = void(void*, FILETIME);
+
 void setHandleCloserThreadCount(std::size_t n);
 
 class DirectoryWalker
 {
 public:
   void forEachEntry(const std::wstring& path, void* cx, DirStartF* dirStartF,
-                    DirEndF* dirEndF, FileF* fileF);
+                    DirEndF* dirEndF, FileF* fileF, DirTimeF* dirTimeF = nullptr);
 
 private:
   std::vector<std::unique_ptr<unsigned char[]>> m_buffers;
@@ -185,7 +208,11 @@ void forEachEntry(const std::wstring& path, void* cx, DirStartF* dirStartF,
                   DirEndF* dirEndF, FileF* fileF);
 
 Directory getFilesAndDirs(const std::wstring& path);
-Directory getFilesAndDirsWithFind(const std::wstring& path);
+Directory getFilesAndDirs(DirectoryWalker& walker, const std::wstring& path);
+
+// if `recursive` is false, only the direct children of the directory are
+// listed and subdirectories are left empty
+Directory getFilesAndDirsWithFind(const std::wstring& path, bool recursive = true);
 
 }  // namespace env
 
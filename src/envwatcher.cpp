@@ -0,0 +1,260 @@
+#include "envwatcher.h"
+#include "env.h"
+#include "thread_utils.h"
+#include <log.h>
+#include <utility.h>
+
+namespace env
+{
+
+using namespace MOBase;
+
+// size of the buffer given to ReadDirectoryChangesW(), changes are dropped
+// and an overflow is reported when it fills up between two reads; this is
+// also the maximum for network shares
+constexpr std::size_t BufferSize = 64 * 1024;
+
+constexpr DWORD NotifyFilter = FILE_NOTIFY_CHANGE_FILE_NAME |
+                               FILE_NOTIFY_CHANGE_DIR_NAME |
+                               FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+
+struct DirectoryWatcher::Root
+{
+  std::wstring path;
+  HandlePtr dir;
+  HandlePtr event;
+  OVERLAPPED ov = {};
+
+  // FILE_NOTIFY_INFORMATION must be DWORD-aligned
+  std::vector<DWORD> buffer;
+
+  // false once the root has failed, it is not read again; set on the watcher
+  // thread
+  std::atomic<bool> active = true;
+
+  // starts an asynchronous read, the event is signalled when it completes
+  //
+  bool read()
+  {
+    ov        = {};
+    ov.hEvent = event.get();
+
+    if (!::ReadDirectoryChangesW(dir.get(), buffer.data(),
+                                 static_cast<DWORD>(buffer.size() * sizeof(DWORD)),
+                                 TRUE, NotifyFilter, nullptr, &ov, nullptr)) {
+      const auto e = GetLastError();
+      log::error("can't watch '{}' for changes, {}", path, formatSystemMessage(e));
+      return false;
+    }
+
+    return true;
+  }
+
+  // parses the changes from a completed read
+  //
+  void parse(std::vector<FileChange>& changes) const
+  {
+    const auto* p = reinterpret_cast<const std::byte*>(buffer.data());
+
+    for (;;) {
+      const auto* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+
+      std::wstring name(info->FileName, info->FileNameLength / sizeof(wchar_t));
+
+      switch (info->Action) {
+      case FILE_ACTION_ADDED:
+      case FILE_ACTION_RENAMED_NEW_NAME:
+        changes.push_back({FileChange::Added, path, std::move(name)});
+        break;
+
+      case FILE_ACTION_REMOVED:
+      case FILE_ACTION_RENAMED_OLD_NAME:
+        changes.push_back({FileChange::Removed, path, std::move(name)});
+        break;
+
+      case FILE_ACTION_MODIFIED:
+        changes.push_back({FileChange::Modified, path, std::move(name)});
+        break;
+      }
+
+      if (info->NextEntryOffset == 0) {
+        break;
+      }
+
+      p += info->NextEntryOffset;
+    }
+  }
+};
+
+DirectoryWatcher::DirectoryWatcher(Callback callback)
+    : m_callback(std::move(callback)),
+      m_stop(::CreateEventW(nullptr, TRUE, FALSE, nullptr))
+{}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+  stop();
+}
+
+void DirectoryWatcher::watch(const std::vector<std::wstring>& roots)
+{
+  stop();
+
+  for (auto&& path : roots) {
+    auto r  = std::make_unique<Root>();
+    r->path = path;
+
+    r->dir.reset(::CreateFileW(
+        path.c_str(), FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr));
+
+    if (r->dir.get() == INVALID_HANDLE_VALUE) {
+      const auto e = GetLastError();
+      log::error("can't open '{}' for watching, {}", path, formatSystemMessage(e));
+      continue;
+    }
+
+    r->event.reset(::CreateEventW(nullptr, TRUE, FALSE, nullptr));
+    r->buffer.resize(BufferSize / sizeof(DWORD));
+
+    if (!r->read()) {
+      continue;
+    }
+
+    m_roots.push_back(std::move(r));
+
+    // WaitForMultipleObjects() needs one more for the stop event
+    if (m_roots.size() + 1 >= MAXIMUM_WAIT_OBJECTS) {
+      log::error("too many directories to watch, ignoring the rest");
+      break;
+    }
+  }
+
+  if (m_roots.empty()) {
+    return;
+  }
+
+  ::ResetEvent(m_stop.get());
+
+  m_thread = MOShared::startSafeThread([this] {
+    run();
+  });
+}
+
+void DirectoryWatcher::stop()
+{
+  if (m_thread.joinable()) {
+    ::SetEvent(m_stop.get());
+    m_thread.join();
+  }
+
+  // pending reads write into the roots, they must be cancelled and finished
+  // before the buffers are freed
+  for (auto& r : m_roots) {
+    if (r->active) {
+      DWORD bytes = 0;
+      ::CancelIoEx(r->dir.get(), &r->ov);
+      ::GetOverlappedResult(r->dir.get(), &r->ov, &bytes, TRUE);
+    }
+  }
+
+  m_roots.clear();
+}
+
+bool DirectoryWatcher::watching() const
+{
+  return m_thread.joinable();
+}
+
+bool DirectoryWatcher::watching(const std::wstring& root) const
+{
+  if (!watching()) {
+    return false;
+  }
+
+  for (auto& r : m_roots) {
+    if (r->path == root) {
+      return r->active;
+    }
+  }
+
+  return false;
+}
+
+void DirectoryWatcher::run()
+{
+  // the stop event is first, followed by the active roots in the same order
+  // as `roots`
+  std::vector<HANDLE> handles;
+  std::vector<Root*> roots;
+
+  handles.push_back(m_stop.get());
+
+  for (auto& r : m_roots) {
+    handles.push_back(r->event.get());
+    roots.push_back(r.get());
+  }
+
+  for (;;) {
+    const auto ret = ::WaitForMultipleObjects(static_cast<DWORD>(handles.size()),
+                                              handles.data(), FALSE, INFINITE);
+
+    if (ret == WAIT_OBJECT_0) {
+      // stop event
+      break;
+    }
+
+    if (ret < WAIT_OBJECT_0 + 1 || ret >= WAIT_OBJECT_0 + handles.size()) {
+      const auto e = GetLastError();
+      log::error("failed to wait for directory changes, {}", formatSystemMessage(e));
+      break;
+    }
+
+    const std::size_t i = ret - WAIT_OBJECT_0 - 1;
+    auto& r             = *roots[i];
+    std::vector<FileChange> changes;
+
+    DWORD bytes = 0;
+    if (::GetOverlappedResult(r.dir.get(), &r.ov, &bytes, FALSE)) {
+      if (bytes == 0) {
+        // the buffer overflowed, the changes are lost
+        log::debug("too many changes in '{}', rescanning", r.path);
+        changes.push_back({FileChange::Overflow, r.path, {}});
+      } else {
+        r.parse(changes);
+      }
+
+      ::ResetEvent(r.event.get());
+      r.active = r.read();
+    } else {
+      const auto e = GetLastError();
+
+      if (e == ERROR_NOTIFY_ENUM_DIR) {
+        log::debug("too many changes in '{}', rescanning", r.path);
+        ::ResetEvent(r.event.get());
+        r.active = r.read();
+      } else {
+        log::error("stopped watching '{}', {}", r.path, formatSystemMessage(e));
+        r.active = false;
+      }
+
+      changes.push_back({FileChange::Overflow, r.path, {}});
+    }
+
+    if (!r.active) {
+      // a failed root would keep its event signalled
+      handles.erase(handles.begin() + i + 1);
+      roots.erase(roots.begin() + i);
+    }
+
+    m_callback(std::move(changes));
+
+    if (roots.empty()) {
+      log::debug("no more directories to watch");
+      break;
+    }
+  }
+}
+
+}  // namespace env
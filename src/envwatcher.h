@@ -0,0 +1,95 @@
+#ifndef ENV_WATCHER_H
+#define ENV_WATCHER_H
+
+#include "envmodule.h"
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace env
+{
+
+// one change reported by DirectoryWatcher
+//
+struct FileChange
+{
+  enum Types
+  {
+    // a file or directory was created or renamed to this path
+    Added,
+
+    // a file or directory was deleted or renamed from this path
+    Removed,
+
+    // the contents or time of a file changed
+    Modified,
+
+    // changes were lost, everything under the root must be rescanned; `path`
+    // is empty
+    Overflow
+  };
+
+  Types type;
+
+  // watched directory
+  std::wstring root;
+
+  // relative to the root
+  std::wstring path;
+};
+
+// watches directories and everything under them on a background thread by
+// using ReadDirectoryChangesW()
+//
+// changes are given to the callback in batches, on the watcher thread; when
+// the system drops changes because the buffer is full, or the root itself
+// becomes unavailable, a single Overflow change is reported for that root
+// instead
+//
+class DirectoryWatcher
+{
+public:
+  using Callback = std::function<void(std::vector<FileChange>)>;
+
+  DirectoryWatcher(Callback callback);
+  ~DirectoryWatcher();
+
+  // noncopyable
+  DirectoryWatcher(const DirectoryWatcher&)            = delete;
+  DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+  // stops watching the current directories, if any, and starts watching the
+  // given ones; directories that can't be opened are logged and skipped
+  //
+  void watch(const std::vector<std::wstring>& roots);
+
+  // stops watching everything and joins the thread
+  //
+  void stop();
+
+  // whether watch() has been called successfully since the last stop(), even
+  // if all the directories have failed since
+  //
+  bool watching() const;
+
+  // whether changes to the given directory are still being reported, false if
+  // it was never opened or if it has failed since
+  //
+  bool watching(const std::wstring& root) const;
+
+private:
+  struct Root;
+
+  Callback m_callback;
+  HandlePtr m_stop;
+  std::vector<std::unique_ptr<Root>> m_roots;
+  std::thread m_thread;
+
+  void run();
+};
+
+}  // namespace env
+
+#endif  // ENV_WATCHER_H
@@ -0,0 +1,209 @@
+#include "hashservice.h"
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <log.h>
+
+using namespace MOBase;
+
+namespace
+{
+
+// cancellation is checked between chunks, a mapped window is hashed in
+// several of them so cancelling doesn't wait for a whole window
+constexpr qint64 ChunkSize = 8 * 1024 * 1024;
+
+}  // namespace
+
+HashService::HashService(std::size_t maxJobs, QObject* parent)
+    : QObject(parent), m_Pool(std::max<std::size_t>(maxJobs, 1))
+{}
+
+HashService::~HashService()
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    for (auto&& [tag, job] : m_Jobs) {
+      job->cancelled = true;
+    }
+
+    m_Jobs.clear();
+  }
+
+  m_Pool.waitForAll();
+}
+
+void HashService::hash(unsigned int tag, const QString& path)
+{
+  auto job = std::make_shared<Job>();
+
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    auto& slot = m_Jobs[tag];
+    if (slot) {
+      slot->cancelled = true;
+    }
+
+    slot = job;
+  }
+
+  m_Pool.submit([this, tag, job, path] {
+    run(tag, job, path);
+  });
+}
+
+void HashService::cancel(unsigned int tag)
+{
+  std::scoped_lock lock(m_Mutex);
+
+  auto itor = m_Jobs.find(tag);
+  if (itor == m_Jobs.end()) {
+    return;
+  }
+
+  itor->second->cancelled = true;
+  m_Jobs.erase(itor);
+}
+
+bool HashService::busy(unsigned int tag) const
+{
+  std::scoped_lock lock(m_Mutex);
+  return (m_Jobs.find(tag) != m_Jobs.end());
+}
+
+bool HashService::current(unsigned int tag, const std::shared_ptr<Job>& job) const
+{
+  std::scoped_lock lock(m_Mutex);
+
+  auto itor = m_Jobs.find(tag);
+  return (itor != m_Jobs.end() && itor->second == job && !job->cancelled);
+}
+
+void HashService::run(unsigned int tag, std::shared_ptr<Job> job, const QString& path)
+{
+  if (job->cancelled) {
+    return;
+  }
+
+  const QFileInfo fi(path);
+  const auto size = fi.size();
+  const auto time = fi.lastModified();
+
+  int lastPercent = -1;
+
+  auto onProgress = [&](qint64 done, qint64 total) {
+    const int percent = (total > 0 ? static_cast<int>(done * 100 / total) : 100);
+    if (percent == lastPercent) {
+      return;
+    }
+
+    lastPercent = percent;
+
+    // signals are emitted on the thread of the service; the job is checked
+    // again there because it may have been cancelled in the meantime
+    QMetaObject::invokeMethod(
+        this,
+        [=] {
+          if (current(tag, job)) {
+            emit progress(tag, done, total);
+          }
+        },
+        Qt::QueuedConnection);
+  };
+
+  QString error;
+  const auto md5 = hashFile(path, job->cancelled, onProgress, &error);
+
+  if (job->cancelled) {
+    log::debug("hashing '{}' cancelled", path);
+    return;
+  }
+
+  QMetaObject::invokeMethod(
+      this,
+      [=] {
+        if (!current(tag, job)) {
+          return;
+        }
+
+        {
+          std::scoped_lock lock(m_Mutex);
+          m_Jobs.erase(tag);
+        }
+
+        if (md5.isEmpty()) {
+          emit failed(tag, error);
+        } else {
+          emit finished(tag, md5, size, time);
+        }
+      },
+      Qt::QueuedConnection);
+}
+
+QByteArray HashService::hashFile(const QString& path,
+                                 const std::atomic<bool>& cancelled,
+                                 std::function<void(qint64, qint64)> progress,
+                                 QString* error)
+{
+  auto fail = [&](const QString& what) {
+    log::error("can't hash '{}': {}", path, what);
+
+    if (error) {
+      *error = what;
+    }
+
+    return QByteArray();
+  };
+
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return fail(file.errorString());
+  }
+
+  QCryptographicHash hash(QCryptographicHash::Md5);
+  const qint64 size = file.size();
+
+  for (qint64 offset = 0; offset < size; offset += WindowSize) {
+    const qint64 length = std::min(WindowSize, size - offset);
+    uchar* p            = file.map(offset, length);
+
+    if (p == nullptr) {
+      // mapping can fail on some network drives, fall back to reading
+      if (!file.seek(offset)) {
+        return fail(file.errorString());
+      }
+    }
+
+    for (qint64 done = 0; done < length; done += ChunkSize) {
+      if (cancelled) {
+        return {};
+      }
+
+      const qint64 n = std::min(ChunkSize, length - done);
+
+      if (p != nullptr) {
+        hash.addData(QByteArray::fromRawData(
+            reinterpret_cast<const char*>(p + done), static_cast<int>(n)));
+      } else {
+        const QByteArray data = file.read(n);
+        if (data.size() != n) {
+          return fail(file.errorString());
+        }
+
+        hash.addData(data);
+      }
+
+      if (progress) {
+        progress(offset + done + n, size);
+      }
+    }
+
+    if (p != nullptr) {
+      file.unmap(p);
+    }
+  }
+
+  return hash.result();
+}
@@ -0,0 +1,94 @@
+#ifndef MODORGANIZER_HASHSERVICE_INCLUDED
+#define MODORGANIZER_HASHSERVICE_INCLUDED
+
+#include "taskpool.h"
+#include <QByteArray>
+#include <QDateTime>
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// computes md5 hashes of files in the background
+//
+// files are read through memory-mapped windows so the system can read ahead
+// while the previous window is being hashed; at most `maxJobs` files are
+// hashed at the same time so that several large archives don't fight over
+// the disk
+//
+// each job is identified by a tag chosen by the caller, such as a download
+// id; results are reported through signals on the thread that owns the
+// service, and never for a job that was cancelled
+//
+class HashService : public QObject
+{
+  Q_OBJECT
+
+public:
+  // size of the mapped windows
+  static constexpr qint64 WindowSize = 64 * 1024 * 1024;
+
+  explicit HashService(std::size_t maxJobs = 2, QObject* parent = nullptr);
+
+  // cancels all jobs and waits for the running ones
+  ~HashService();
+
+  // queues the given file, a job already queued for the same tag is cancelled
+  // first
+  //
+  void hash(unsigned int tag, const QString& path);
+
+  // cancels the job for the given tag, if any
+  //
+  void cancel(unsigned int tag);
+
+  // whether a job is queued or running for the given tag
+  //
+  bool busy(unsigned int tag) const;
+
+  // hashes the given file on the calling thread; returns an empty array if the
+  // file can't be read or if `cancelled` becomes true, `error` is set in the
+  // former case
+  //
+  // `progress` is called after each chunk with the number of bytes hashed so
+  // far and the size of the file
+  //
+  static QByteArray hashFile(const QString& path, const std::atomic<bool>& cancelled,
+                             std::function<void(qint64, qint64)> progress = {},
+                             QString* error = nullptr);
+
+signals:
+  // emitted at most once per percent
+  //
+  void progress(unsigned int tag, qint64 done, qint64 total);
+
+  // `size` and `time` are the ones of the file when hashing started, they can
+  // be used later to tell whether the hash is still valid
+  //
+  void finished(unsigned int tag, QByteArray md5, qint64 size, QDateTime time);
+
+  void failed(unsigned int tag, QString error);
+
+private:
+  struct Job
+  {
+    std::atomic<bool> cancelled = false;
+  };
+
+  MOShared::TaskPool m_Pool;
+
+  mutable std::mutex m_Mutex;
+  std::map<unsigned int, std::shared_ptr<Job>> m_Jobs;
+
+  void run(unsigned int tag, std::shared_ptr<Job> job, const QString& path);
+
+  // whether `job` is still the current job for `tag`, which is false once it
+  // has been cancelled or replaced
+  //
+  bool current(unsigned int tag, const std::shared_ptr<Job>& job) const;
+};
+
+#endif  // MODORGANIZER_HASHSERVICE_INCLUDED
@@ -27,11 +27,24 @@ using namespace MOBase;
 static LogModel* g_instance = nullptr;
 const std::size_t MaxLines  = 1000;
 
+// entries waiting to be added to the model, more are dropped
+const std::size_t PendingLines = 8192;
+
+// delay before pending entries are added to the model
+const auto DrainInterval = std::chrono::milliseconds(50);
+
 static std::unique_ptr<env::Console> m_console;
 static bool m_stdout = false;
 static std::mutex m_stdoutMutex;
 
-LogModel::LogModel() {}
+LogModel::LogModel()
+    : m_pending(PendingLines), m_dropped(0), m_drainScheduled(false)
+{
+  m_drainTimer.setSingleShot(true);
+  m_drainTimer.setInterval(DrainInterval);
+
+  connect(&m_drainTimer, &QTimer::timeout, this, &LogModel::drain);
+}
 
 void LogModel::create()
 {
@@ -45,12 +58,20 @@ LogModel& LogModel::instance()
 
 void LogModel::add(MOBase::log::Entry e)
 {
-  QMetaObject::invokeMethod(
-      this,
-      [this, e] {
-        onEntryAdded(std::move(e));
-      },
-      Qt::QueuedConnection);
+  if (!m_pending.push(std::move(e))) {
+    m_dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // the timer can only be started from the ui thread, but this is only
+  // posted once per batch
+  if (!m_drainScheduled.exchange(true)) {
+    QMetaObject::invokeMethod(
+        this,
+        [this] {
+          m_drainTimer.start();
+        },
+        Qt::QueuedConnection);
+  }
 }
 
 QString LogModel::formattedMessage(const QModelIndex& index) const
@@ -73,27 +94,59 @@ const std::deque<MOBase::log::Entry>& LogModel::entries() const
   return m_entries;
 }
 
-void LogModel::onEntryAdded(MOBase::log::Entry e)
+void LogModel::drain()
 {
-  bool full = false;
-  if (m_entries.size() > MaxLines) {
-    m_entries.pop_front();
-    full = true;
+  // cleared first so entries added from now on schedule another drain
+  m_drainScheduled = false;
+
+  std::vector<log::Entry> entries;
+
+  for (log::Entry e; m_pending.pop(e);) {
+    entries.push_back(std::move(e));
+  }
+
+  if (const auto dropped = m_dropped.exchange(0); dropped > 0) {
+    const auto text = std::to_string(dropped) +
+                      " log lines were not shown here, they are in the log file";
+
+    log::Entry e;
+    e.time             = decltype(e.time)::clock::now();
+    e.level            = log::Warning;
+    e.message          = text;
+    e.formattedMessage = text;
+
+    entries.push_back(std::move(e));
   }
 
-  const int row = static_cast<int>(m_entries.size());
+  if (entries.empty()) {
+    return;
+  }
 
-  if (!full) {
-    beginInsertRows(QModelIndex(), row, row + 1);
+  // only the last lines are kept
+  if (entries.size() > MaxLines) {
+    entries.erase(entries.begin(), entries.end() - MaxLines);
   }
 
-  m_entries.emplace_back(std::move(e));
+  const auto total = m_entries.size() + entries.size();
 
-  if (!full) {
-    endInsertRows();
-  } else {
-    emit dataChanged(createIndex(row, 0), createIndex(row + 1, columnCount({})));
+  if (total > MaxLines) {
+    const auto remove = static_cast<int>(total - MaxLines);
+
+    beginRemoveRows(QModelIndex(), 0, remove - 1);
+    m_entries.erase(m_entries.begin(), m_entries.begin() + remove);
+    endRemoveRows();
   }
+
+  const int first = static_cast<int>(m_entries.size());
+  const int last  = first + static_cast<int>(entries.size()) - 1;
+
+  beginInsertRows(QModelIndex(), first, last);
+
+  for (auto& e : entries) {
+    m_entries.emplace_back(std::move(e));
+  }
+
+  endInsertRows();
 }
 
 QModelIndex LogModel::index(int row, int column, const QModelIndex&) const
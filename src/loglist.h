@@ -21,8 +21,11 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #define LOGBUFFER_H
 
 #include "copyeventfilter.h"
+#include "ringbuffer.h"
 #include "shared/appconfig.h"
+#include <QTimer>
 #include <QTreeView>
+#include <atomic>
 #include <deque>
 #include <log.h>
 
@@ -36,6 +39,9 @@ public:
   static void create();
   static LogModel& instance();
 
+  // can be called from any thread; entries are kept in a buffer and added to
+  // the model in batches by the ui thread
+  //
   void add(MOBase::log::Entry e);
   void clear();
 
@@ -56,8 +62,21 @@ protected:
 private:
   std::deque<MOBase::log::Entry> m_entries;
 
+  // entries added since the last drain(), filled by any thread
+  MOShared::RingBuffer<MOBase::log::Entry> m_pending;
+
+  // number of entries that didn't fit in m_pending
+  std::atomic<std::size_t> m_dropped;
+
+  // whether drain() will be called, only one timer is started at a time
+  std::atomic<bool> m_drainScheduled;
+  QTimer m_drainTimer;
+
   LogModel();
-  void onEntryAdded(MOBase::log::Entry e);
+
+  // moves everything from m_pending to the model
+  //
+  void drain();
 };
 
 class LogList : public QTreeView
@@ -3,6 +3,7 @@
 #include "lootdialog.h"
 #include "organizercore.h"
 #include "spawn.h"
+#include <functional>
 #include <log.h>
 #include <report.h>
 
@@ -12,6 +13,236 @@ using namespace json;
 static QString LootReportPath  = QDir::temp().absoluteFilePath("lootreport.json");
 static const DWORD PipeTimeout = 500;
 
+// size of the chunks read from the report
+static const qint64 ReportChunkSize = 64 * 1024;
+
+namespace
+{
+
+// reads the json report in chunks and hands out each member of the root
+// object as soon as it's complete; the elements of the "plugins" array are
+// handed out one by one instead of the whole array
+//
+// this only finds where values start and end, the values themselves are
+// parsed by QJsonDocument, so the whole report is never in memory at once
+//
+class ReportReader
+{
+public:
+  std::function<void(const QString& key, const QByteArray& value)> onMember;
+  std::function<void(const QByteArray& plugin)> onPlugin;
+
+  // returns false if the json is invalid, everything else is ignored
+  //
+  bool feed(const char* data, qint64 size)
+  {
+    for (qint64 i = 0; i < size; ++i) {
+      if (!step(data[i])) {
+        m_state = State::Failed;
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  // whether the root object was closed
+  //
+  bool done() const { return (m_state == State::Done); }
+
+private:
+  enum class State
+  {
+    BeforeRoot,
+    BeforeKey,
+    InKey,
+    AfterKey,
+    BeforeValue,
+    InValue,
+    AfterValue,
+    BeforeElement,
+    InElement,
+    Done,
+    Failed
+  };
+
+  State m_state = State::BeforeRoot;
+  QString m_key;
+  QByteArray m_value;
+
+  // for the value being read
+  int m_depth     = 0;
+  bool m_inString = false;
+  bool m_escape   = false;
+
+  static bool isSpace(char c)
+  {
+    return (c == ' ' || c == '\t' || c == '\r' || c == '\n');
+  }
+
+  bool step(char c)
+  {
+    switch (m_state) {
+    case State::BeforeRoot:
+      if (c == '{') {
+        m_state = State::BeforeKey;
+        return true;
+      }
+
+      return isSpace(c);
+
+    case State::BeforeKey:
+      if (c == '"') {
+        m_key.clear();
+        m_escape = false;
+        m_state  = State::InKey;
+        return true;
+      } else if (c == '}') {
+        m_state = State::Done;
+        return true;
+      }
+
+      return isSpace(c);
+
+    case State::InKey:
+      // keys are only compared to known names, escapes are kept as-is
+      if (m_escape) {
+        m_escape = false;
+      } else if (c == '\\') {
+        m_escape = true;
+      } else if (c == '"') {
+        m_state = State::AfterKey;
+        return true;
+      }
+
+      m_key += QChar::fromLatin1(c);
+      return true;
+
+    case State::AfterKey:
+      if (c == ':') {
+        m_state = State::BeforeValue;
+        return true;
+      }
+
+      return isSpace(c);
+
+    case State::BeforeValue:
+      if (isSpace(c)) {
+        return true;
+      }
+
+      if (m_key == "plugins" && c == '[') {
+        m_state = State::BeforeElement;
+        return true;
+      }
+
+      startValue(State::InValue);
+      return value(c);
+
+    case State::InValue:
+      return value(c);
+
+    case State::AfterValue:
+      if (c == ',') {
+        m_state = State::BeforeKey;
+        return true;
+      } else if (c == '}') {
+        m_state = State::Done;
+        return true;
+      }
+
+      return isSpace(c);
+
+    case State::BeforeElement:
+      if (isSpace(c) || c == ',') {
+        return true;
+      } else if (c == ']') {
+        m_state = State::AfterValue;
+        return true;
+      }
+
+      startValue(State::InElement);
+      return value(c);
+
+    case State::InElement:
+      return value(c);
+
+    case State::Done:
+      return isSpace(c);
+
+    case State::Failed:
+    default:
+      return false;
+    }
+  }
+
+  void startValue(State s)
+  {
+    m_value.clear();
+    m_depth    = 0;
+    m_inString = false;
+    m_escape   = false;
+    m_state    = s;
+  }
+
+  bool value(char c)
+  {
+    if (m_inString) {
+      if (m_escape) {
+        m_escape = false;
+      } else if (c == '\\') {
+        m_escape = true;
+      } else if (c == '"') {
+        m_inString = false;
+      }
+
+      m_value += c;
+      return true;
+    }
+
+    if (m_depth == 0 && (c == ',' || c == '}' || c == ']')) {
+      // end of a number, bool or null, the character belongs to the parent
+      endValue();
+      return step(c);
+    }
+
+    m_value += c;
+
+    if (c == '"') {
+      m_inString = true;
+    } else if (c == '{' || c == '[') {
+      ++m_depth;
+    } else if (c == '}' || c == ']') {
+      if (--m_depth == 0) {
+        endValue();
+      }
+    }
+
+    return true;
+  }
+
+  void endValue()
+  {
+    if (m_state == State::InElement) {
+      m_state = State::BeforeElement;
+
+      if (onPlugin) {
+        onPlugin(m_value);
+      }
+    } else {
+      m_state = State::AfterValue;
+
+      if (onMember) {
+        onMember(m_key, m_value.trimmed());
+      }
+    }
+
+    m_value.clear();
+  }
+};
+
+}  // namespace
+
 class AsyncPipe
 {
 public:
@@ -611,24 +842,50 @@ bool Loot::waitForCompletion()
   return true;
 }
 
-void Loot::processStdout(const std::string& lootOut)
+void Loot::LineTokenizer::feed(const std::string& data)
 {
-  emit output(QString::fromStdString(lootOut));
+  // lines that were handed out are only dropped now, their views are still
+  // valid until this is called
+  m_buffer.erase(0, m_start);
+  m_start = 0;
 
-  m_outputBuffer += lootOut;
-  if (m_outputBuffer.empty()) {
+  m_buffer += data;
+}
+
+bool Loot::LineTokenizer::next(std::string_view& line)
+{
+  const auto newline = m_buffer.find('\n', m_start);
+  if (newline == std::string::npos) {
+    return false;
+  }
+
+  line = std::string_view(m_buffer.data() + m_start, newline - m_start);
+  m_start = newline + 1;
+
+  if (!line.empty() && line.back() == '\r') {
+    line.remove_suffix(1);
+  }
+
+  return true;
+}
+
+void Loot::processStdout(const std::string& lootOut)
+{
+  if (lootOut.empty()) {
     return;
   }
 
-  std::size_t start = 0;
+  emit output(QString::fromStdString(lootOut));
 
-  for (;;) {
-    const auto newline = m_outputBuffer.find("\n", start);
-    if (newline == std::string::npos) {
-      break;
+  m_lines.feed(lootOut);
+
+  std::string_view line;
+
+  while (m_lines.next(line)) {
+    if (line.empty()) {
+      continue;
     }
 
-    const std::string_view line(m_outputBuffer.c_str() + start, newline - start);
     const auto m = lootcli::parseMessage(line);
 
     if (m.type == lootcli::MessageType::None) {
@@ -637,11 +894,7 @@ void Loot::processStdout(const std::string& lootOut)
     }
 
     processMessage(m);
-
-    start = newline + 1;
   }
-
-  m_outputBuffer.erase(0, start);
 }
 
 void Loot::processMessage(const lootcli::Message& m)
@@ -708,41 +961,85 @@ void Loot::processOutputFile(Report& r) const
     return;
   }
 
-  QJsonParseError e;
-  const QJsonDocument doc = QJsonDocument::fromJson(outFile.readAll(), &e);
-  if (doc.isNull()) {
-    emit log(MOBase::log::Error,
-             QString("invalid json, %1 (error %2)").arg(e.errorString()).arg(e.error));
+  // the members are converted like they were in the whole document
+  auto parse = [&](const QByteArray& value, const char* what) -> QJsonValue {
+    QJsonParseError e;
+    const QJsonDocument doc = QJsonDocument::fromJson(value, &e);
 
-    return;
-  }
+    if (doc.isObject()) {
+      return doc.object();
+    } else if (doc.isArray()) {
+      return doc.array();
+    }
 
-  requireObject(doc, "root");
+    emit log(MOBase::log::Error, QString("invalid json for %1, %2 (error %3)")
+                                     .arg(what)
+                                     .arg(e.errorString())
+                                     .arg(e.error));
 
-  const QJsonObject object = doc.object();
+    return {};
+  };
 
-  r.messages = reportMessages(getOpt<QJsonArray>(object, "messages"));
-  r.plugins  = reportPlugins(getOpt<QJsonArray>(object, "plugins"));
-  r.stats    = reportStats(getWarn<QJsonObject>(object, "stats"));
-}
+  bool hasStats = false;
 
-std::vector<Loot::Plugin> Loot::reportPlugins(const QJsonArray& plugins) const
-{
-  std::vector<Loot::Plugin> v;
+  ReportReader reader;
+
+  reader.onMember = [&](const QString& key, const QByteArray& value) {
+    if (key == "messages") {
+      r.messages =
+          reportMessages(convertWarn<QJsonArray>(parse(value, "messages"), "messages"));
+    } else if (key == "stats") {
+      r.stats  = reportStats(convertWarn<QJsonObject>(parse(value, "stats"), "stats"));
+      hasStats = true;
+    }
+  };
 
-  for (auto pluginValue : plugins) {
-    const auto o = convertWarn<QJsonObject>(pluginValue, "plugin");
+  // plugins are handed out as soon as they're read
+  reader.onPlugin = [&](const QByteArray& value) {
+    const auto o = convertWarn<QJsonObject>(parse(value, "plugin"), "plugin");
     if (o.isEmpty()) {
-      continue;
+      return;
     }
 
     auto p = reportPlugin(o);
     if (!p.name.isEmpty()) {
-      v.emplace_back(std::move(p));
+      emit pluginReported(p);
+      r.plugins.emplace_back(std::move(p));
+    }
+  };
+
+  std::vector<char> buffer(ReportChunkSize);
+
+  for (;;) {
+    const auto n = outFile.read(buffer.data(), ReportChunkSize);
+
+    if (n < 0) {
+      emit log(MOBase::log::Error, QString("failed to read file, %1 (error %2)")
+                                       .arg(outFile.errorString())
+                                       .arg(outFile.error()));
+      return;
+    }
+
+    if (n == 0) {
+      break;
+    }
+
+    if (!reader.feed(buffer.data(), n)) {
+      emit log(MOBase::log::Error, QString("invalid json in '%1' near offset %2")
+                                       .arg(LootReportPath)
+                                       .arg(outFile.pos()));
+      return;
     }
   }
 
-  return v;
+  if (!reader.done()) {
+    emit log(MOBase::log::Error,
+             QString("json in '%1' is incomplete").arg(LootReportPath));
+  }
+
+  if (!hasStats) {
+    log::warn("'stats' is missing from the loot report");
+  }
 }
 
 Loot::Plugin Loot::reportPlugin(const QJsonObject& plugin) const
@@ -5,6 +5,8 @@
 #include <QWidget>
 #include <log.h>
 #include <lootcli/lootcli.h>
+#include <string>
+#include <string_view>
 #include <windows.h>
 
 Q_DECLARE_METATYPE(lootcli::Progress);
@@ -100,16 +102,41 @@ signals:
   void output(const QString& s);
   void progress(const lootcli::Progress p);
   void log(MOBase::log::Levels level, const QString& s) const;
+
+  // emitted for each plugin while the report is being read, before finished()
+  //
+  void pluginReported(const Loot::Plugin& p) const;
+
   void finished();
 
 private:
+  // splits the output of lootcli in lines as it arrives, an incomplete line is
+  // kept until the rest is received
+  //
+  class LineTokenizer
+  {
+  public:
+    void feed(const std::string& data);
+
+    // sets `line` to the next complete line, without the line break; the line
+    // is valid until the next call to feed()
+    //
+    bool next(std::string_view& line);
+
+  private:
+    std::string m_buffer;
+
+    // start of the next line in m_buffer
+    std::size_t m_start = 0;
+  };
+
   OrganizerCore& m_core;
   std::unique_ptr<QThread> m_thread;
   std::atomic<bool> m_cancel;
   std::atomic<bool> m_result;
   env::HandlePtr m_lootProcess;
   std::unique_ptr<AsyncPipe> m_pipe;
-  std::string m_outputBuffer;
+  LineTokenizer m_lines;
   std::vector<QString> m_errors, m_warnings;
   Report m_report;
 
@@ -127,7 +154,6 @@ private:
   void deleteReportFile();
 
   Message reportMessage(const QJsonObject& message) const;
-  std::vector<Plugin> reportPlugins(const QJsonArray& plugins) const;
   Loot::Plugin reportPlugin(const QJsonObject& plugin) const;
   Loot::Stats reportStats(const QJsonObject& stats) const;
 
@@ -137,6 +163,8 @@ private:
   std::vector<QString> reportStringArray(const QJsonArray& array) const;
 };
 
+Q_DECLARE_METATYPE(Loot::Plugin);
+
 bool runLoot(QWidget* parent, OrganizerCore& core, bool didUpdateMasterList);
 
 #endif  // MODORGANIZER_LOOT_H
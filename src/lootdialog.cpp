@@ -56,7 +56,8 @@ bool MarkdownPage::acceptNavigationRequest(const QUrl& url, NavigationType, bool
 
 LootDialog::LootDialog(QWidget* parent, OrganizerCore& core, Loot& loot)
     : QDialog(parent, Qt::WindowMaximizeButtonHint), ui(new Ui::LootDialog),
-      m_core(core), m_loot(loot), m_finished(false), m_cancelling(false)
+      m_core(core), m_loot(loot), m_finished(false), m_cancelling(false),
+      m_reportCleared(false)
 {
   createUI();
 
@@ -81,6 +82,13 @@ LootDialog::LootDialog(QWidget* parent, OrganizerCore& core, Loot& loot)
       },
       Qt::QueuedConnection);
 
+  QObject::connect(
+      &m_loot, &Loot::pluginReported, this,
+      [&](auto&& p) {
+        addPluginReport(p);
+      },
+      Qt::QueuedConnection);
+
   QObject::connect(
       &m_loot, &Loot::finished, this,
       [&] {
@@ -273,15 +281,25 @@ void LootDialog::log(log::Levels lv, const QString& s)
   }
 }
 
+void LootDialog::addPluginReport(const Loot::Plugin& p)
+{
+  if (!m_reportCleared) {
+    m_core.pluginList()->clearAdditionalInformation();
+    m_reportCleared = true;
+  }
+
+  m_core.pluginList()->addLootReport(p.name, p);
+}
+
 void LootDialog::showReport()
 {
   const auto& lootReport = m_loot.report();
 
-  if (m_loot.result()) {
+  // plugins were added to the list as they were reported, this only clears
+  // the old information if loot didn't report any
+  if (m_loot.result() && !m_reportCleared) {
     m_core.pluginList()->clearAdditionalInformation();
-    for (auto&& p : lootReport.plugins) {
-      m_core.pluginList()->addLootReport(p.name, p);
-    }
+    m_reportCleared = true;
   }
 
   m_report.setText(lootReport.toMarkdown());
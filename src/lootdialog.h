@@ -1,6 +1,7 @@
 #ifndef MODORGANIZER_LOOTDIALOG_H
 #define MODORGANIZER_LOOTDIALOG_H
 
+#include "loot.h"
 #include <expanderwidget.h>
 #include <log.h>
 #include <lootcli/lootcli.h>
@@ -11,7 +12,6 @@ class LootDialog;
 }
 
 class OrganizerCore;
-class Loot;
 
 class MarkdownDocument : public QObject
 {
@@ -67,6 +67,10 @@ private:
   Loot& m_loot;
   bool m_finished;
   bool m_cancelling;
+
+  // whether the previous loot information was removed from the plugin list,
+  // done when the first plugin is reported
+  bool m_reportCleared;
   MarkdownDocument m_report;
 
   void createUI();
@@ -74,6 +78,7 @@ private:
   void addLineOutput(const QString& line);
   void onFinished();
   void log(MOBase::log::Levels lv, const QString& s);
+  void addPluginReport(const Loot::Plugin& p);
   void showReport();
 };
 
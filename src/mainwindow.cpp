@@ -2417,7 +2417,7 @@ void MainWindow::fileMoved(const QString& filePath, const QString& oldOriginName
         WIN32_FIND_DATAW findData;
         HANDLE hFind;
         hFind = ::FindFirstFileW(ToWString(fullNewPath).c_str(), &findData);
-        filePtr->addOrigin(newOrigin.getID(), findData.ftCreationTime, L"", -1);
+        filePtr->addOrigin(newOrigin.getID(), findData.ftCreationTime, {});
         FindClose(hFind);
       }
       if (m_OrganizerCore.directoryStructure()->originExists(
@@ -28,6 +28,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "categories.h"
 #include "modinfodialog.h"
 #include "modlist.h"
+#include "modmetaindex.h"
 #include "organizercore.h"
 #include "overwriteinfodialog.h"
 #include "thread_utils.h"
@@ -55,6 +56,7 @@ std::map<QString, unsigned int, MOBase::FileNameComparator> ModInfo::s_ModsByNam
 std::map<std::pair<QString, int>, std::vector<unsigned int>> ModInfo::s_ModsByModID;
 int ModInfo::s_NextID;
 QRecursiveMutex ModInfo::s_Mutex;
+ModMetaIndex ModInfo::s_MetaIndex;
 
 QString ModInfo::s_HiddenExt(".mohidden");
 
@@ -82,17 +84,18 @@ bool ModInfo::isRegularName(const QString& name)
   return !isSeparatorName(name) && !isBackupName(name);
 }
 
-ModInfo::Ptr ModInfo::createFrom(const QDir& dir, OrganizerCore& core)
+ModInfo::Ptr ModInfo::createFrom(const QDir& dir, OrganizerCore& core,
+                                 const ModMeta* meta)
 {
   QMutexLocker locker(&s_Mutex);
   ModInfo::Ptr result;
 
   if (isBackupName(dir.dirName())) {
-    result = ModInfo::Ptr(new ModInfoBackup(dir, core));
+    result = ModInfo::Ptr(new ModInfoBackup(dir, core, meta));
   } else if (isSeparatorName(dir.dirName())) {
-    result = Ptr(new ModInfoSeparator(dir, core));
+    result = Ptr(new ModInfoSeparator(dir, core, meta));
   } else {
-    result = ModInfo::Ptr(new ModInfoRegular(dir, core));
+    result = ModInfo::Ptr(new ModInfoRegular(dir, core, meta));
   }
   result->m_Index = s_Collection.size();
   s_Collection.push_back(result);
@@ -240,13 +243,43 @@ void ModInfo::updateFromDisc(const QString& modsDirectory, OrganizerCore& core,
   s_NextID    = 0;
   s_Overwrite = nullptr;
 
+  // the index is only read once per instance
+  const QString metaIndexPath = ModMetaIndex::defaultPath();
+  if (s_MetaIndex.path() != metaIndexPath) {
+    s_MetaIndex.load(metaIndexPath);
+  }
+
   {  // list all directories in the mod directory and make a mod out of each
+    struct Discovered
+    {
+      QString path;
+      ModMeta meta;
+    };
+
+    std::vector<Discovered> discovered;
+
     QDir mods(QDir::fromNativeSeparators(modsDirectory));
     mods.setFilter(QDir::Dirs | QDir::NoDotAndDotDot);
     QDirIterator modIter(mods);
     while (modIter.hasNext()) {
-      createFrom(QDir(modIter.next()), core);
+      discovered.push_back({modIter.next(), {}});
     }
+
+    // reading meta.ini files is the slow part of creating mods, they're read
+    // in parallel first, or taken from the index if they haven't changed;
+    // the mods themselves are QObjects and are created on this thread
+    parallelMap(
+        std::begin(discovered), std::end(discovered),
+        [](Discovered& d) {
+          d.meta = s_MetaIndex.get(d.path + "/meta.ini");
+        },
+        refreshThreadCount);
+
+    for (auto&& d : discovered) {
+      createFrom(QDir(d.path), core, &d.meta);
+    }
+
+    s_MetaIndex.save(metaIndexPath);
   }
 
   auto* game               = core.managedGame();
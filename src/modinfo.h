@@ -24,6 +24,8 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "imodinterface.h"
 #include "versioninfo.h"
 
+class ModMeta;
+class ModMetaIndex;
 class OrganizerCore;
 class PluginContainer;
 class QDir;
@@ -986,10 +988,13 @@ protected:
    * @brief Create a new mod from the specified directory and add it to the collection.
    *
    * @param dir Directory to create from.
+   * @param meta Contents of the meta.ini of the mod if they've already been
+   *     read, or null to read them.
    *
    * @return pointer to the info-structure of the newly created/added mod.
    */
-  static ModInfo::Ptr createFrom(const QDir& dir, OrganizerCore& core);
+  static ModInfo::Ptr createFrom(const QDir& dir, OrganizerCore& core,
+                                 const ModMeta* meta = nullptr);
 
   /**
    * @brief Create a new "foreign-managed" mod from a tuple of plugin and archives.
@@ -1016,6 +1021,9 @@ protected:
   static std::map<QString, unsigned int, MOBase::FileNameComparator> s_ModsByName;
   static std::map<std::pair<QString, int>, std::vector<unsigned int>> s_ModsByModID;
   static int s_NextID;
+
+  // meta.ini files of regular mods, see ModMetaIndex
+  static ModMetaIndex s_MetaIndex;
 };
 
 #endif  // MODINFO_H
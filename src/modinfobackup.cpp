@@ -12,6 +12,7 @@ QString ModInfoBackup::getDescription() const
   return tr("This is the backup of a mod");
 }
 
-ModInfoBackup::ModInfoBackup(const QDir& path, OrganizerCore& core)
-    : ModInfoRegular(path, core)
+ModInfoBackup::ModInfoBackup(const QDir& path, OrganizerCore& core,
+                             const ModMeta* meta)
+    : ModInfoRegular(path, core, meta)
 {}
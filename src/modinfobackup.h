@@ -43,7 +43,7 @@ public:
   virtual void addInstalledFile(int, int) override {}
 
 private:
-  ModInfoBackup(const QDir& path, OrganizerCore& core);
+  ModInfoBackup(const QDir& path, OrganizerCore& core, const ModMeta* meta = nullptr);
 };
 
 #endif  // MODINFOBACKUP_H
@@ -6,6 +6,7 @@
 #include "shared/directoryentry.h"
 #include "shared/fileentry.h"
 #include "shared/filesorigin.h"
+#include "thread_utils.h"
 #include "ui_modinfodialog.h"
 #include "utility.h"
 
@@ -16,6 +17,59 @@ using namespace MOBase;
 // checking whether menu items apply to them, just show all of them
 const std::size_t max_small_selection = 50;
 
+// below this, classifying files on the ui thread is faster than starting
+// threads
+const std::size_t min_parallel_files = 5000;
+
+// splits the given files in chunks and calls f(file, chunk) for each file on
+// several threads; chunks are returned in the order of the files so they can
+// be merged in that order
+//
+template <class Chunk, class F>
+std::vector<Chunk> processFiles(const std::vector<FileEntryPtr>& files,
+                                std::size_t threadCount, F&& f)
+{
+  struct Range
+  {
+    std::size_t chunk, begin, end;
+  };
+
+  const auto n = files.size();
+  threadCount  = std::max<std::size_t>(threadCount, 1);
+
+  if (n < min_parallel_files) {
+    threadCount = 1;
+  }
+
+  // a few chunks per thread so threads finishing early can pick up more
+  const auto size = n / (threadCount * 4) + 1;
+
+  std::vector<Range> ranges;
+  for (std::size_t begin = 0; begin < n; begin += size) {
+    ranges.push_back({ranges.size(), begin, std::min(n, begin + size)});
+  }
+
+  std::vector<Chunk> chunks(ranges.size());
+
+  auto process = [&](const Range& r) {
+    auto& chunk = chunks[r.chunk];
+
+    for (std::size_t i = r.begin; i < r.end; ++i) {
+      f(*files[i], chunk);
+    }
+  };
+
+  if (threadCount == 1) {
+    for (const auto& r : ranges) {
+      process(r);
+    }
+  } else {
+    parallelMap(ranges.begin(), ranges.end(), process, threadCount);
+  }
+
+  return chunks;
+}
+
 std::size_t smallSelectionSize(const QTreeView* tree)
 {
   const std::size_t too_many = std::numeric_limits<std::size_t>::max();
@@ -543,6 +597,33 @@ std::vector<QAction*> ConflictsTab::createGotoActions(const ConflictItem* item)
   return actions;
 }
 
+// names of the given origins separated by commas
+//
+template <class Iterator>
+std::wstring joinOriginNames(const DirectoryEntry& ds, Iterator begin, Iterator end)
+{
+  std::wstring s;
+
+  for (auto itor = begin; itor != end; ++itor) {
+    if (!s.empty()) {
+      s += L", ";
+    }
+
+    s += ds.getOriginByID(itor->originID()).getName();
+  }
+
+  return s;
+}
+
+// sort key of the file column, the path of the parent directory is built by the
+// model
+//
+void setFileSortKey(FileEntry& file, ConflictListModel::SortKey& key)
+{
+  key.directory = file.getParent();
+  key.text      = ToQString(file.getName());
+}
+
 GeneralConflictsTab::GeneralConflictsTab(ConflictsTab* tab, Ui::ModInfoDialog* pui,
                                          OrganizerCore& oc)
     : m_tab(tab), ui(pui), m_core(oc),
@@ -550,6 +631,30 @@ GeneralConflictsTab::GeneralConflictsTab(ConflictsTab* tab, Ui::ModInfoDialog* p
       m_overwrittenModel(new OverwrittenConflictListModel(ui->overwrittenTree)),
       m_noConflictModel(new NoConflictListModel(ui->noConflictTree))
 {
+  m_overwriteModel->setFactory([this](auto&& row) {
+    return createOverwriteItem(row.index, row.archive);
+  });
+
+  m_overwrittenModel->setFactory([this](auto&& row) {
+    return createOverwrittenItem(row.index, row.fileOrigin, row.archive);
+  });
+
+  m_noConflictModel->setFactory([this](auto&& row) {
+    return createNoConflictItem(row.index, row.archive);
+  });
+
+  m_overwriteModel->setSortKeyFunction([this](auto&& row, auto col, auto& key) {
+    return overwriteSortKey(row, col, key);
+  });
+
+  m_overwrittenModel->setSortKeyFunction([this](auto&& row, auto col, auto& key) {
+    return overwrittenSortKey(row, col, key);
+  });
+
+  m_noConflictModel->setSortKeyFunction([this](auto&& row, auto col, auto& key) {
+    return noConflictSortKey(row, col, key);
+  });
+
   m_expanders.overwrite.set(ui->overwriteExpander, ui->overwriteTree, true);
   m_expanders.overwritten.set(ui->overwrittenExpander, ui->overwrittenTree, true);
   m_expanders.nonconflict.set(ui->noConflictExpander, ui->noConflictTree);
@@ -631,77 +736,108 @@ bool GeneralConflictsTab::update()
 {
   clear();
 
-  if (m_tab->origin() != nullptr) {
-    const auto rootPath = m_tab->mod().absolutePath();
+  const auto* origin = m_tab->origin();
 
-    for (const auto& file : m_tab->origin()->getFiles()) {
-      // careful: these two strings are moved into createXItem() below
-      QString relativeName =
-          QDir::fromNativeSeparators(ToQString(file->getRelativePath()));
-      QString fileName = rootPath + relativeName;
+  if (origin != nullptr) {
+    m_rootPath = m_tab->mod().absolutePath();
+
+    using Row = ConflictListModel::Row;
+
+    struct Chunk
+    {
+      GeneralConflictNumbers counts;
+      std::vector<Row> overwrite, overwritten, noConflict;
+    };
+
+    const auto originID = origin->getID();
+
+    // only classifies the files, the items are created by the models when
+    // they're displayed
+    auto classify = [&](const FileEntry& file, Chunk& chunk) {
+      auto& counts = chunk.counts;
 
       bool archive         = false;
-      const int fileOrigin = file->getOrigin(archive);
+      const int fileOrigin = file.getOrigin(archive);
 
-      ++m_counts.numTotalFiles;
+      ++counts.numTotalFiles;
 
-      const auto& alternatives = file->getAlternatives();
+      const auto& alternatives = file.getAlternatives();
+      const Row row{file.getIndex(), fileOrigin, archive};
 
-      if (fileOrigin == m_tab->origin()->getID()) {
+      if (fileOrigin == originID) {
         // current mod is primary origin, the winner
-        (archive) ? ++m_counts.numTotalArchive : ++m_counts.numTotalLoose;
+        (archive) ? ++counts.numTotalArchive : ++counts.numTotalLoose;
 
         if (!alternatives.empty()) {
-          m_overwriteModel->add(
-              createOverwriteItem(file->getIndex(), archive, std::move(fileName),
-                                  std::move(relativeName), alternatives));
+          chunk.overwrite.push_back(row);
 
-          ++m_counts.numOverwrite;
+          ++counts.numOverwrite;
           if (archive) {
-            ++m_counts.numOverwriteArchive;
+            ++counts.numOverwriteArchive;
           } else {
-            ++m_counts.numOverwriteLoose;
+            ++counts.numOverwriteLoose;
           }
         } else {
           // otherwise, put the file in the noconflict tree
-          m_noConflictModel->add(createNoConflictItem(
-              file->getIndex(), archive, std::move(fileName), std::move(relativeName)));
+          chunk.noConflict.push_back(row);
 
-          ++m_counts.numNonConflicting;
+          ++counts.numNonConflicting;
           if (archive) {
-            ++m_counts.numNonConflictingArchive;
+            ++counts.numNonConflictingArchive;
           } else {
-            ++m_counts.numNonConflictingLoose;
+            ++counts.numNonConflictingLoose;
           }
         }
       } else {
-        auto currId     = m_tab->origin()->getID();
         auto currModAlt = std::find_if(alternatives.begin(), alternatives.end(),
-                                       [&currId](auto const& alt) {
-                                         return currId == alt.originID();
+                                       [&originID](auto const& alt) {
+                                         return originID == alt.originID();
                                        });
 
         if (currModAlt == alternatives.end()) {
           log::error("Mod {} not found in the list of origins for file {}",
-                     m_tab->origin()->getName(), fileName);
-          continue;
+                     origin->getName(), file.getRelativePath());
+          return;
         }
 
         bool currModFileArchive = currModAlt->isFromArchive();
 
-        m_overwrittenModel->add(createOverwrittenItem(file->getIndex(), fileOrigin,
-                                                      archive, std::move(fileName),
-                                                      std::move(relativeName)));
+        chunk.overwritten.push_back(row);
 
-        ++m_counts.numOverwritten;
+        ++counts.numOverwritten;
         if (currModFileArchive) {
-          ++m_counts.numOverwrittenArchive;
-          ++m_counts.numTotalArchive;
+          ++counts.numOverwrittenArchive;
+          ++counts.numTotalArchive;
         } else {
-          ++m_counts.numOverwrittenLoose;
-          ++m_counts.numTotalLoose;
+          ++counts.numOverwrittenLoose;
+          ++counts.numTotalLoose;
         }
       }
+    };
+
+    const auto chunks = processFiles<Chunk>(
+        origin->getFiles(), m_core.settings().refreshThreadCount(), classify);
+
+    for (const auto& chunk : chunks) {
+      m_counts.add(chunk.counts);
+    }
+
+    m_overwriteModel->reserve(static_cast<std::size_t>(m_counts.numOverwrite));
+    m_overwrittenModel->reserve(static_cast<std::size_t>(m_counts.numOverwritten));
+    m_noConflictModel->reserve(static_cast<std::size_t>(m_counts.numNonConflicting));
+
+    for (const auto& chunk : chunks) {
+      for (const auto& row : chunk.overwrite) {
+        m_overwriteModel->add(row);
+      }
+
+      for (const auto& row : chunk.overwritten) {
+        m_overwrittenModel->add(row);
+      }
+
+      for (const auto& row : chunk.noConflict) {
+        m_noConflictModel->add(row);
+      }
     }
 
     m_overwriteModel->finished();
@@ -714,49 +850,157 @@ bool GeneralConflictsTab::update()
   return (m_counts.numOverwrite > 0 || m_counts.numOverwritten > 0);
 }
 
-ConflictItem GeneralConflictsTab::createOverwriteItem(
-    FileIndex index, bool archive, QString fileName, QString relativeName,
-    const MOShared::AlternativesVector& alternatives)
+std::optional<ConflictItem>
+GeneralConflictsTab::createOverwriteItem(FileIndex index, bool archive) const
 {
-  const auto& ds = *m_core.directoryStructure();
-  std::wstring altString;
+  const auto* origin = m_tab->origin();
+  if (!origin) {
+    return {};
+  }
 
-  for (const auto& alt : alternatives) {
-    if (!altString.empty()) {
-      altString += L", ";
-    }
+  const auto file = origin->findFile(index);
+  if (!file) {
+    return {};
+  }
 
-    altString += ds.getOriginByID(alt.originID()).getName();
+  const auto& alternatives = file->getAlternatives();
+  if (alternatives.empty()) {
+    return {};
   }
 
-  auto origin = ToQString(ds.getOriginByID(alternatives.back().originID()).getName());
+  const auto& ds = *m_core.directoryStructure();
+  const auto altString =
+      joinOriginNames(ds, alternatives.begin(), alternatives.end());
+
+  auto altOrigin =
+      ToQString(ds.getOriginByID(alternatives.back().originID()).getName());
+
+  QString relativeName = QDir::fromNativeSeparators(ToQString(file->getRelativePath()));
+  QString fileName     = m_rootPath + relativeName;
 
   return ConflictItem(ToQString(altString), std::move(relativeName), QString(), index,
-                      std::move(fileName), true, std::move(origin), archive);
+                      std::move(fileName), true, std::move(altOrigin), archive);
 }
 
-ConflictItem GeneralConflictsTab::createNoConflictItem(FileIndex index, bool archive,
-                                                       QString fileName,
-                                                       QString relativeName)
+std::optional<ConflictItem>
+GeneralConflictsTab::createNoConflictItem(FileIndex index, bool archive) const
 {
+  const auto* origin = m_tab->origin();
+  if (!origin) {
+    return {};
+  }
+
+  const auto file = origin->findFile(index);
+  if (!file) {
+    return {};
+  }
+
+  QString relativeName = QDir::fromNativeSeparators(ToQString(file->getRelativePath()));
+  QString fileName     = m_rootPath + relativeName;
+
   return ConflictItem(QString(), std::move(relativeName), QString(), index,
                       std::move(fileName), false, QString(), archive);
 }
 
-ConflictItem GeneralConflictsTab::createOverwrittenItem(FileIndex index, int fileOrigin,
-                                                        bool archive, QString fileName,
-                                                        QString relativeName)
+std::optional<ConflictItem>
+GeneralConflictsTab::createOverwrittenItem(FileIndex index, int fileOrigin,
+                                           bool archive) const
 {
+  const auto* origin = m_tab->origin();
+  if (!origin) {
+    return {};
+  }
+
+  const auto file = origin->findFile(index);
+  if (!file) {
+    return {};
+  }
+
   const auto& ds                = *m_core.directoryStructure();
   const FilesOrigin& realOrigin = ds.getOriginByID(fileOrigin);
 
   QString after     = ToQString(realOrigin.getName());
   QString altOrigin = after;
 
+  QString relativeName = QDir::fromNativeSeparators(ToQString(file->getRelativePath()));
+  QString fileName     = m_rootPath + relativeName;
+
   return ConflictItem(QString(), std::move(relativeName), std::move(after), index,
                       std::move(fileName), true, std::move(altOrigin), archive);
 }
 
+bool GeneralConflictsTab::overwriteSortKey(const ConflictListModel::Row& row,
+                                           std::size_t col,
+                                           ConflictListModel::SortKey& key) const
+{
+  const auto* origin = m_tab->origin();
+  if (!origin) {
+    return false;
+  }
+
+  const auto file = origin->findFile(row.index);
+  if (!file) {
+    return false;
+  }
+
+  if (col == 0) {
+    setFileSortKey(*file, key);
+  } else {
+    const auto& alternatives = file->getAlternatives();
+
+    key.text = ToQString(joinOriginNames(*m_core.directoryStructure(),
+                                         alternatives.begin(), alternatives.end()));
+  }
+
+  return true;
+}
+
+bool GeneralConflictsTab::overwrittenSortKey(const ConflictListModel::Row& row,
+                                             std::size_t col,
+                                             ConflictListModel::SortKey& key) const
+{
+  if (col != 0) {
+    // the providing mod, doesn't need the file
+    const auto& ds = *m_core.directoryStructure();
+    key.text       = ToQString(ds.getOriginByID(row.fileOrigin).getName());
+
+    return true;
+  }
+
+  const auto* origin = m_tab->origin();
+  if (!origin) {
+    return false;
+  }
+
+  const auto file = origin->findFile(row.index);
+  if (!file) {
+    return false;
+  }
+
+  setFileSortKey(*file, key);
+
+  return true;
+}
+
+bool GeneralConflictsTab::noConflictSortKey(const ConflictListModel::Row& row,
+                                            std::size_t,
+                                            ConflictListModel::SortKey& key) const
+{
+  const auto* origin = m_tab->origin();
+  if (!origin) {
+    return false;
+  }
+
+  const auto file = origin->findFile(row.index);
+  if (!file) {
+    return false;
+  }
+
+  setFileSortKey(*file, key);
+
+  return true;
+}
+
 QString percent(int a, int b)
 {
   if (b == 0) {
@@ -886,8 +1130,17 @@ void GeneralConflictsTab::onOverwrittenActivated(const QModelIndex& index)
 AdvancedConflictsTab::AdvancedConflictsTab(ConflictsTab* tab, Ui::ModInfoDialog* pui,
                                            OrganizerCore& oc)
     : m_tab(tab), ui(pui), m_core(oc),
-      m_model(new AdvancedConflictListModel(ui->conflictsAdvancedList))
+      m_model(new AdvancedConflictListModel(ui->conflictsAdvancedList)),
+      m_showAllAlts(false)
 {
+  m_model->setFactory([this](auto&& row) {
+    return createItem(row.index, row.fileOrigin, row.archive);
+  });
+
+  m_model->setSortKeyFunction([this](auto&& row, auto col, auto& key) {
+    return sortKey(row, col, key);
+  });
+
   m_filter.setEdit(ui->conflictsAdvancedFilter);
   m_filter.setList(ui->conflictsAdvancedList);
   m_filter.setUseSourceSort(true);
@@ -949,27 +1202,68 @@ void AdvancedConflictsTab::update()
 {
   clear();
 
-  if (m_tab->origin() != nullptr) {
-    const auto rootPath = m_tab->mod().absolutePath();
+  const auto* origin = m_tab->origin();
+
+  if (origin != nullptr) {
+    m_rootPath    = m_tab->mod().absolutePath();
+    m_showAllAlts = ui->conflictsAdvancedShowAll->isChecked();
 
-    const auto& files = m_tab->origin()->getFiles();
-    m_model->reserve(files.size());
+    using Row = ConflictListModel::Row;
 
-    for (const auto& file : files) {
-      // careful: these two strings are moved into createItem() below
-      QString relativeName =
-          QDir::fromNativeSeparators(ToQString(file->getRelativePath()));
-      QString fileName = rootPath + relativeName;
+    const auto originID       = origin->getID();
+    const bool showNoConflict = ui->conflictsAdvancedShowNoConflict->isChecked();
 
+    // only decides which files are shown, the items are created by the model
+    // when they're displayed
+    auto classify = [&](const FileEntry& file, std::vector<Row>& rows) {
       bool archive             = false;
-      const int fileOrigin     = file->getOrigin(archive);
-      const auto& alternatives = file->getAlternatives();
+      const int fileOrigin     = file.getOrigin(archive);
+      const auto& alternatives = file.getAlternatives();
+
+      if (alternatives.empty()) {
+        // this file has no conflicts at all, only display it if the user
+        // wants it
+        if (showNoConflict) {
+          rows.push_back({file.getIndex(), fileOrigin, archive});
+        }
+
+        return;
+      }
+
+      if (fileOrigin == originID) {
+        // current origin is the active winner
+        rows.push_back({file.getIndex(), fileOrigin, archive});
+        return;
+      }
 
-      auto item = createItem(file->getIndex(), fileOrigin, archive, std::move(fileName),
-                             std::move(relativeName), alternatives);
+      // current mod is one of the alternatives
+      auto currModIter = std::find_if(alternatives.begin(), alternatives.end(),
+                                      [&originID](auto const& alt) {
+                                        return originID == alt.originID();
+                                      });
 
-      if (item) {
-        m_model->add(std::move(*item));
+      if (currModIter == alternatives.end()) {
+        log::error("Mod {} not found in the list of origins for file {}",
+                   origin->getName(), file.getRelativePath());
+        return;
+      }
+
+      rows.push_back({file.getIndex(), fileOrigin, currModIter->isFromArchive()});
+    };
+
+    const auto chunks = processFiles<std::vector<Row>>(
+        origin->getFiles(), m_core.settings().refreshThreadCount(), classify);
+
+    std::size_t count = 0;
+    for (const auto& rows : chunks) {
+      count += rows.size();
+    }
+
+    m_model->reserve(count);
+
+    for (const auto& rows : chunks) {
+      for (const auto& row : rows) {
+        m_model->add(row);
       }
     }
 
@@ -978,24 +1272,51 @@ void AdvancedConflictsTab::update()
 }
 
 std::optional<ConflictItem>
-AdvancedConflictsTab::createItem(FileIndex index, int fileOrigin, bool archive,
-                                 QString fileName, QString relativeName,
-                                 const MOShared::AlternativesVector& alternatives)
+AdvancedConflictsTab::createItem(FileIndex index, int fileOrigin, bool archive) const
 {
-  const auto& ds = *m_core.directoryStructure();
+  const auto* currOrigin = m_tab->origin();
+  if (!currOrigin) {
+    return {};
+  }
+
+  const auto file = currOrigin->findFile(index);
+  if (!file) {
+    return {};
+  }
 
   std::wstring before, after;
+  if (!originNames(*file, fileOrigin, before, after)) {
+    return {};
+  }
 
-  auto currOrigin        = m_tab->origin();
-  bool isCurrOrigArchive = archive;
+  const bool hasAlts = !before.empty() || !after.empty();
 
-  if (!alternatives.empty()) {
-    const bool showAllAlts = ui->conflictsAdvancedShowAll->isChecked();
+  auto beforeQS = QString::fromStdWString(before);
+  auto afterQS  = QString::fromStdWString(after);
+
+  QString relativeName = QDir::fromNativeSeparators(ToQString(file->getRelativePath()));
+  QString fileName     = m_rootPath + relativeName;
+
+  return ConflictItem(std::move(beforeQS), std::move(relativeName), std::move(afterQS),
+                      index, std::move(fileName), hasAlts, QString(), archive);
+}
+
+bool AdvancedConflictsTab::originNames(const FileEntry& file, int fileOrigin,
+                                       std::wstring& before, std::wstring& after) const
+{
+  const auto* currOrigin = m_tab->origin();
+  if (!currOrigin) {
+    return false;
+  }
 
+  const auto& ds           = *m_core.directoryStructure();
+  const auto& alternatives = file.getAlternatives();
+
+  if (!alternatives.empty()) {
     if (currOrigin->getID() == fileOrigin) {
       // current origin is the active winner, all alternatives go in 'before'
 
-      if (showAllAlts) {
+      if (m_showAllAlts) {
         for (const auto& alt : alternatives) {
           const auto& altOrigin = ds.getOriginByID(alt.originID());
           if (!before.empty()) {
@@ -1022,14 +1343,11 @@ AdvancedConflictsTab::createItem(FileIndex index, int fileOrigin, bool archive,
                                       });
 
       if (currModIter == alternatives.end()) {
-        log::error("Mod {} not found in the list of origins for file {}",
-                   currOrigin->getName(), fileName);
-        return {};
+        // already logged by update()
+        return false;
       }
 
-      isCurrOrigArchive = currModIter->isFromArchive();
-
-      if (showAllAlts) {
+      if (m_showAllAlts) {
         // fills 'before' and 'after' with all the alternatives that come
         // before and after the current mod, trusting the alternatives vector to be
         // already sorted correctly
@@ -1085,20 +1403,33 @@ AdvancedConflictsTab::createItem(FileIndex index, int fileOrigin, bool archive,
     }
   }
 
-  const bool hasAlts = !before.empty() || !after.empty();
+  return true;
+}
 
-  if (!hasAlts) {
-    // if both before and after are empty, it means this file has no conflicts
-    // at all, only display it if the user wants it
-    if (!ui->conflictsAdvancedShowNoConflict->isChecked()) {
-      return {};
-    }
+bool AdvancedConflictsTab::sortKey(const ConflictListModel::Row& row, std::size_t col,
+                                   ConflictListModel::SortKey& key) const
+{
+  const auto* origin = m_tab->origin();
+  if (!origin) {
+    return false;
   }
 
-  auto beforeQS = QString::fromStdWString(before);
-  auto afterQS  = QString::fromStdWString(after);
+  const auto file = origin->findFile(row.index);
+  if (!file) {
+    return false;
+  }
 
-  return ConflictItem(std::move(beforeQS), std::move(relativeName), std::move(afterQS),
-                      index, std::move(fileName), hasAlts, QString(),
-                      isCurrOrigArchive);
+  if (col == 1) {
+    setFileSortKey(*file, key);
+    return true;
+  }
+
+  std::wstring before, after;
+  if (!originNames(*file, row.fileOrigin, before, after)) {
+    return false;
+  }
+
+  key.text = ToQString(col == 0 ? before : after);
+
+  return true;
 }
@@ -3,6 +3,7 @@
 
 #include "expanderwidget.h"
 #include "filterwidget.h"
+#include "modinfodialogconflictsmodels.h"
 #include "modinfodialogtab.h"
 #include "shared/fileregisterfwd.h"
 #include <QTreeWidget>
@@ -12,8 +13,6 @@ using namespace MOBase;
 
 class ConflictsTab;
 class OrganizerCore;
-class ConflictItem;
-class ConflictListModel;
 
 class GeneralConflictsTab : public QObject
 {
@@ -66,20 +65,52 @@ private:
     int numOverwrittenArchive    = 0;
 
     void clear() { *this = {}; };
+
+    void add(const GeneralConflictNumbers& n)
+    {
+      numTotalFiles += n.numTotalFiles;
+      numTotalLoose += n.numTotalLoose;
+      numTotalArchive += n.numTotalArchive;
+      numNonConflicting += n.numNonConflicting;
+      numNonConflictingLoose += n.numNonConflictingLoose;
+      numNonConflictingArchive += n.numNonConflictingArchive;
+      numOverwrite += n.numOverwrite;
+      numOverwriteLoose += n.numOverwriteLoose;
+      numOverwriteArchive += n.numOverwriteArchive;
+      numOverwritten += n.numOverwritten;
+      numOverwrittenLoose += n.numOverwrittenLoose;
+      numOverwrittenArchive += n.numOverwrittenArchive;
+    }
   };
 
   GeneralConflictNumbers m_counts;
 
-  ConflictItem createOverwriteItem(MOShared::FileIndex index, bool archive,
-                                   QString fileName, QString relativeName,
-                                   const MOShared::AlternativesVector& alternatives);
+  // path of the mod when update() was called, used to create the items
+  QString m_rootPath;
+
+  // these are the factories of the models, they only read the directory
+  // structure and can be called from any thread
+  //
+  std::optional<ConflictItem> createOverwriteItem(MOShared::FileIndex index,
+                                                  bool archive) const;
+
+  std::optional<ConflictItem> createNoConflictItem(MOShared::FileIndex index,
+                                                   bool archive) const;
+
+  std::optional<ConflictItem> createOverwrittenItem(MOShared::FileIndex index,
+                                                    int fileOrigin, bool archive) const;
+
+  // sort keys of the models, the second column of the overwrite and
+  // overwritten lists has the origins of the file
+  //
+  bool overwriteSortKey(const ConflictListModel::Row& row, std::size_t col,
+                        ConflictListModel::SortKey& key) const;
 
-  ConflictItem createNoConflictItem(MOShared::FileIndex index, bool archive,
-                                    QString fileName, QString relativeName);
+  bool overwrittenSortKey(const ConflictListModel::Row& row, std::size_t col,
+                          ConflictListModel::SortKey& key) const;
 
-  ConflictItem createOverwrittenItem(MOShared::FileIndex index, int fileOrigin,
-                                     bool archive, QString fileName,
-                                     QString relativeName);
+  bool noConflictSortKey(const ConflictListModel::Row& row, std::size_t col,
+                         ConflictListModel::SortKey& key) const;
 
   void updateUICounters();
 
@@ -110,9 +141,26 @@ private:
   FilterWidget m_filter;
   ConflictListModel* m_model;
 
-  std::optional<ConflictItem>
-  createItem(MOShared::FileIndex index, int fileOrigin, bool archive, QString fileName,
-             QString relativeName, const MOShared::AlternativesVector& alternatives);
+  // state when update() was called, used to create the items
+  QString m_rootPath;
+  bool m_showAllAlts;
+
+  // factory of the model, only reads the directory structure and can be
+  // called from any thread
+  //
+  std::optional<ConflictItem> createItem(MOShared::FileIndex index, int fileOrigin,
+                                         bool archive) const;
+
+  // sort key of the model, doesn't create the item
+  //
+  bool sortKey(const ConflictListModel::Row& row, std::size_t col,
+               ConflictListModel::SortKey& key) const;
+
+  // names of the origins shown before and after the current mod for the given
+  // file; returns false if the current mod is not an origin of the file
+  //
+  bool originNames(const MOShared::FileEntry& file, int fileOrigin,
+                   std::wstring& before, std::wstring& after) const;
 };
 
 class ConflictsTab : public ModInfoDialogTab
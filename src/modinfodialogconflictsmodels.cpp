@@ -1,8 +1,13 @@
 #include "modinfodialogconflictsmodels.h"
 #include "modinfodialog.h"
+#include "shared/directoryentry.h"
+#include <numeric>
+#include <unordered_map>
 #include <utility.h>
 
 using MOBase::naturalCompare;
+using MOBase::ToQString;
+using namespace MOShared;
 
 ConflictItem::ConflictItem(QString before, QString relativeName, QString after,
                            MOShared::FileIndex index, QString fileName,
@@ -90,16 +95,26 @@ ConflictListModel::ConflictListModel(QTreeView* tree, std::vector<Column> column
   m_tree->setModel(this);
 }
 
+void ConflictListModel::setFactory(Factory f)
+{
+  m_factory = std::move(f);
+}
+
+void ConflictListModel::setSortKeyFunction(SortKeyFunction f)
+{
+  m_sortKey = std::move(f);
+}
+
 void ConflictListModel::clear()
 {
   beginResetModel();
-  m_items.clear();
+  m_entries.clear();
   endResetModel();
 }
 
 void ConflictListModel::reserve(std::size_t s)
 {
-  m_items.reserve(s);
+  m_entries.reserve(s);
 }
 
 QModelIndex ConflictListModel::index(int row, int col, const QModelIndex&) const
@@ -118,7 +133,7 @@ int ConflictListModel::rowCount(const QModelIndex& parent) const
     return 0;
   }
 
-  return static_cast<int>(m_items.size());
+  return static_cast<int>(m_entries.size());
 }
 
 int ConflictListModel::columnCount(const QModelIndex&) const
@@ -133,51 +148,38 @@ const ConflictItem* ConflictListModel::itemFromIndex(const QModelIndex& index) c
     return nullptr;
   }
 
-  const auto i = static_cast<std::size_t>(row);
-  if (i >= m_items.size()) {
-    return nullptr;
-  }
-
-  return &m_items[i];
+  return getItem(static_cast<std::size_t>(row));
 }
 
-QModelIndex ConflictListModel::indexFromItem(const ConflictItem* item, int col)
+QVariant ConflictListModel::data(const QModelIndex& index, int role) const
 {
-  for (std::size_t i = 0; i < m_items.size(); ++i) {
-    if (&m_items[i] == item) {
-      return createIndex(static_cast<int>(i), col);
-    }
-  }
+  const auto row = index.row();
+  const auto col = index.column();
 
-  return {};
-}
+  if (row < 0 || col < 0) {
+    return {};
+  }
 
-QVariant ConflictListModel::data(const QModelIndex& index, int role) const
-{
-  if (role == Qt::DisplayRole || role == Qt::FontRole) {
-    const ConflictItem* item = itemFromIndex(index);
-    if (!item) {
-      return {};
-    }
+  const auto r = static_cast<std::size_t>(row);
+  const auto c = static_cast<std::size_t>(col);
 
-    const auto col = index.column();
-    if (col < 0) {
-      return {};
-    }
+  if (r >= m_entries.size() || c >= m_columns.size()) {
+    return {};
+  }
 
-    const auto c = static_cast<std::size_t>(col);
-    if (c >= m_columns.size()) {
+  if (role == Qt::DisplayRole) {
+    const ConflictItem* item = getItem(r);
+    if (!item) {
       return {};
     }
 
-    if (role == Qt::DisplayRole) {
-      return (item->*m_columns[c].getText)();
-    } else if (role == Qt::FontRole) {
-      if (item->isArchive()) {
-        QFont f = m_tree->font();
-        f.setItalic(true);
-        return f;
-      }
+    return (item->*m_columns[c].getText)();
+  } else if (role == Qt::FontRole) {
+    // doesn't need the item
+    if (m_entries[r].row.archive) {
+      QFont f = m_tree->font();
+      f.setItalic(true);
+      return f;
     }
   }
 
@@ -209,35 +211,39 @@ void ConflictListModel::sort(int colIndex, Qt::SortOrder order)
 
   emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
 
-  const auto oldList = persistentIndexList();
-  std::vector<std::pair<const ConflictItem*, int>> oldItems;
+  const auto oldRows = doSort();
 
-  const auto itemCount = oldList.size();
-  oldItems.reserve(static_cast<std::size_t>(itemCount));
+  if (!oldRows.empty()) {
+    std::vector<int> newRows(oldRows.size());
+    for (std::size_t i = 0; i < oldRows.size(); ++i) {
+      newRows[oldRows[i]] = static_cast<int>(i);
+    }
 
-  for (int i = 0; i < itemCount; ++i) {
-    const QModelIndex& index = oldList[i];
-    oldItems.push_back({itemFromIndex(index), index.column()});
-  }
+    const auto oldList = persistentIndexList();
 
-  doSort();
+    QModelIndexList newList;
+    newList.reserve(oldList.size());
 
-  QModelIndexList newList;
-  newList.reserve(itemCount);
+    for (const QModelIndex& index : oldList) {
+      const auto row = index.row();
 
-  for (int i = 0; i < itemCount; ++i) {
-    const auto& pair = oldItems[static_cast<std::size_t>(i)];
-    newList.append(indexFromItem(pair.first, pair.second));
-  }
+      if (row < 0 || static_cast<std::size_t>(row) >= newRows.size()) {
+        newList.append({});
+      } else {
+        newList.append(
+            createIndex(newRows[static_cast<std::size_t>(row)], index.column()));
+      }
+    }
 
-  changePersistentIndexList(oldList, newList);
+    changePersistentIndexList(oldList, newList);
+  }
 
   emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
 }
 
-void ConflictListModel::add(ConflictItem item)
+void ConflictListModel::add(Row row)
 {
-  m_items.emplace_back(std::move(item));
+  m_entries.push_back({row, nullptr});
 }
 
 void ConflictListModel::finished()
@@ -250,44 +256,116 @@ void ConflictListModel::finished()
 
 const ConflictItem* ConflictListModel::getItem(std::size_t row) const
 {
-  if (row >= m_items.size()) {
+  if (row >= m_entries.size()) {
     return nullptr;
   }
 
-  return &m_items[row];
+  const auto& e = m_entries[row];
+
+  if (!e.item && m_factory) {
+    if (auto item = m_factory(e.row)) {
+      e.item = std::make_unique<ConflictItem>(std::move(*item));
+    }
+  }
+
+  return e.item.get();
 }
 
-void ConflictListModel::doSort()
+std::vector<std::size_t> ConflictListModel::doSort()
 {
-  if (m_items.empty()) {
-    return;
+  if (m_entries.empty()) {
+    return {};
   }
 
   if (m_sortColumn < 0) {
-    return;
+    return {};
   }
 
   const auto c = static_cast<std::size_t>(m_sortColumn);
   if (c >= m_columns.size()) {
-    return;
+    return {};
   }
 
-  const auto& col = m_columns[c];
+  if (!m_sortKey) {
+    return {};
+  }
+
+  const auto n = m_entries.size();
+
+  // rows whose file is gone keep an empty key
+  std::vector<SortKey> keys(n);
+
+  for (std::size_t i = 0; i < n; ++i) {
+    if (!m_sortKey(m_entries[i].row, c, keys[i])) {
+      keys[i] = {};
+    }
+  }
+
+  // paths of the directories, built once for all the files in them
+  std::unordered_map<const DirectoryEntry*, QString> paths;
+
+  auto pathOf = [&](const DirectoryEntry* d) -> const QString& {
+    auto itor = paths.find(d);
+
+    if (itor == paths.end()) {
+      QString path;
+
+      for (auto* p = d; p && p->getParent(); p = p->getParent()) {
+        path = ToQString(p->getName()) + (path.isEmpty() ? "" : "/") + path;
+      }
+
+      itor = paths.emplace(d, std::move(path)).first;
+    }
+
+    return itor->second;
+  };
+
+  std::vector<const QString*> dirs(n, nullptr);
+  const QString empty;
+
+  for (std::size_t i = 0; i < n; ++i) {
+    dirs[i] = keys[i].directory ? &pathOf(keys[i].directory) : &empty;
+  }
+
+  auto compare = [&](std::size_t a, std::size_t b) {
+    if (dirs[a] != dirs[b]) {
+      const auto r = naturalCompare(*dirs[a], *dirs[b]);
+      if (r != 0) {
+        return r;
+      }
+    }
+
+    return naturalCompare(keys[a].text, keys[b].text);
+  };
+
+  std::vector<std::size_t> order(n);
+  std::iota(order.begin(), order.end(), 0);
 
   // avoids branching on sort order while sorting
-  auto sortAsc = [&](const auto& a, const auto& b) {
-    return (naturalCompare((a.*col.getText)(), (b.*col.getText)()) < 0);
+  auto sortAsc = [&](std::size_t a, std::size_t b) {
+    return (compare(a, b) < 0);
   };
 
-  auto sortDesc = [&](const auto& a, const auto& b) {
-    return (naturalCompare((a.*col.getText)(), (b.*col.getText)()) > 0);
+  auto sortDesc = [&](std::size_t a, std::size_t b) {
+    return (compare(a, b) > 0);
   };
 
   if (m_sortOrder == Qt::AscendingOrder) {
-    std::sort(m_items.begin(), m_items.end(), sortAsc);
+    std::sort(order.begin(), order.end(), sortAsc);
   } else {
-    std::sort(m_items.begin(), m_items.end(), sortDesc);
+    std::sort(order.begin(), order.end(), sortDesc);
+  }
+
+  std::vector<Entry> sorted;
+  sorted.reserve(n);
+
+  for (const auto i : order) {
+    sorted.push_back(std::move(m_entries[i]));
   }
+
+  m_entries = std::move(sorted);
+
+  return order;
 }
 
 OverwriteConflictListModel::OverwriteConflictListModel(QTreeView* tree)
@@ -1,4 +1,10 @@
+#ifndef MODINFODIALOGCONFLICTSMODELS_H
+#define MODINFODIALOGCONFLICTSMODELS_H
+
 #include "shared/fileentry.h"
+#include <functional>
+#include <memory>
+#include <optional>
 
 class PluginContainer;
 
@@ -39,6 +45,13 @@ private:
   bool m_isArchive;
 };
 
+// a flat list of files from the directory structure
+//
+// rows only store the index of the file and what's needed to draw them, the
+// ConflictItem of a row is created by the factory the first time it's needed,
+// which is usually only for the visible rows; sorting uses keys built from the
+// file entries instead, so it never creates items
+//
 class ConflictListModel : public QAbstractItemModel
 {
   Q_OBJECT;
@@ -50,8 +63,46 @@ public:
     const QString& (ConflictItem::*getText)() const;
   };
 
+  struct Row
+  {
+    MOShared::FileIndex index;
+
+    // primary origin of the file
+    MOShared::OriginID fileOrigin;
+
+    // whether the row is shown as coming from an archive
+    bool archive;
+  };
+
+  // what a row is sorted by for a column; rows are sorted by the path of
+  // `directory` first, if any, and then by `text`
+  //
+  struct SortKey
+  {
+    // parent of the file for the file column, its path is only built once for
+    // all the files in it
+    const MOShared::DirectoryEntry* directory = nullptr;
+
+    // file name for the file column, origin names for the others
+    QString text;
+  };
+
+  // creates the item for a row, returns nothing if the file doesn't exist
+  // anymore
+  //
+  using Factory = std::function<std::optional<ConflictItem>(const Row&)>;
+
+  // fills the sort key of a row for the given column from the file entry and
+  // origin ids, must not create the item; returns false if the file doesn't
+  // exist anymore
+  //
+  using SortKeyFunction = std::function<bool(const Row&, std::size_t, SortKey&)>;
+
   ConflictListModel(QTreeView* tree, std::vector<Column> columns);
 
+  void setFactory(Factory f);
+  void setSortKeyFunction(SortKeyFunction f);
+
   void clear();
   void reserve(std::size_t s);
 
@@ -63,23 +114,35 @@ public:
   QVariant headerData(int col, Qt::Orientation, int role) const;
 
   void sort(int colIndex, Qt::SortOrder order = Qt::AscendingOrder);
-  void add(ConflictItem item);
+  void add(Row row);
 
   void finished();
 
+  // creates the item if it doesn't exist yet, returns null if the row is
+  // invalid or if the file is gone
+  //
   const ConflictItem* getItem(std::size_t row) const;
 
 private:
+  struct Entry
+  {
+    Row row;
+    mutable std::unique_ptr<ConflictItem> item;
+  };
+
   QTreeView* m_tree;
   std::vector<Column> m_columns;
-  std::vector<ConflictItem> m_items;
+  Factory m_factory;
+  SortKeyFunction m_sortKey;
+  std::vector<Entry> m_entries;
   int m_sortColumn;
   Qt::SortOrder m_sortOrder;
 
   const ConflictItem* itemFromIndex(const QModelIndex& index) const;
-  QModelIndex indexFromItem(const ConflictItem* item, int col);
 
-  void doSort();
+  // sorts the entries, returns the old row of each entry at its new position
+  //
+  std::vector<std::size_t> doSort();
 };
 
 class OverwriteConflictListModel : public ConflictListModel
@@ -113,3 +176,5 @@ class AdvancedConflictListModel : public ConflictListModel
 public:
   AdvancedConflictListModel(QTreeView* tree);
 };
+
+#endif  // MODINFODIALOGCONFLICTSMODELS_H
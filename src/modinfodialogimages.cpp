@@ -73,6 +73,11 @@ ImagesTab::ImagesTab(ModInfoDialogTabContext cx)
     onPreviewButton();
   });
 
+  connect(&m_loader, &ThumbnailLoader::thumbnailLoaded, this,
+          &ImagesTab::onThumbnailLoaded);
+  connect(&m_loader, &ThumbnailLoader::originalLoaded, this,
+          &ImagesTab::onOriginalLoaded);
+
   ui->imagesShowDDS->setEnabled(m_ddsAvailable);
 
   ui->imagesThumbnails->setAutoFillBackground(false);
@@ -100,6 +105,9 @@ ImagesTab::ImagesTab(ModInfoDialogTabContext cx)
 
 void ImagesTab::clear()
 {
+  // results for the old files are discarded
+  m_loader.cancel();
+
   m_files.clear();
   ui->imagesScrollerVBar->setValue(0);
   select(BadIndex);
@@ -131,6 +139,7 @@ void ImagesTab::update()
   }
 
   ui->imagesThumbnails->update();
+  requestThumbnails();
 
   setHasData(m_files.size() > 0);
 }
@@ -251,10 +260,15 @@ void ImagesTab::select(std::size_t i, Visibility v)
   m_files.select(i);
 
   if (auto* f = m_files.selectedFile()) {
-    // when jumping elsewhere in the list, such as with page down/up, the file
-    // might not be visible yet, which means it hasn't been loaded and would
-    // pass a null image in setImage() below
-    f->ensureOriginalLoaded();
+    // the full image is decoded in the background, the thumbnail is shown
+    // until it's ready
+    if (!f->failed() && !f->thumbnail().isNull()) {
+      m_image->setImage(f->thumbnail());
+    } else {
+      m_image->clear();
+    }
+
+    m_loader.loadOriginal(m_files.idOf(f), f->path());
 
     ui->imagesPath->setText(QDir::toNativeSeparators(f->path()));
     ui->imagesExplore->setEnabled(true);
@@ -263,27 +277,8 @@ void ImagesTab::select(std::size_t i, Visibility v)
       ui->previewPluginButton->setEnabled(true);
     else
       ui->previewPluginButton->setEnabled(false);
-    ui->imagesSize->setText(dimensionString(f->original().size()));
-
-    if (f->original().isNull()) {
-      m_image->clear();
 
-      QImage image(300, 100, QImage::Format_RGBA64);
-      QPainter paint;
-      paint.begin(&image);
-      paint.fillRect(0, 0, 300, 100, QBrush(QColor(0, 0, 0, 255)));
-      paint.setPen(m_theme.textColor);
-      paint.setFont(m_theme.font);
-      paint.drawImage(QPoint(150 - 16, 50 - 20 - 16), QImage(":/MO/gui/warning"));
-      const auto flags = Qt::AlignHCenter | Qt::AlignVCenter | Qt::TextWordWrap;
-      paint.drawText(0, 46, 300, 54, flags,
-                     "This image format is not supported by Qt, but the preview plugin "
-                     "may be able to display it. Use the button above.");
-      paint.end();
-
-      m_image->setImage(image);
-    } else
-      m_image->setImage(f->original());
+    updateSizeLabel();
     ensureVisible(i, v);
   } else {
     ui->imagesPath->clear();
@@ -296,6 +291,77 @@ void ImagesTab::select(std::size_t i, Visibility v)
   ui->imagesThumbnails->update();
 }
 
+void ImagesTab::setPreview(const QImage& original)
+{
+  if (original.isNull()) {
+    m_image->clear();
+
+    QImage image(300, 100, QImage::Format_RGBA64);
+    QPainter paint;
+    paint.begin(&image);
+    paint.fillRect(0, 0, 300, 100, QBrush(QColor(0, 0, 0, 255)));
+    paint.setPen(m_theme.textColor);
+    paint.setFont(m_theme.font);
+    paint.drawImage(QPoint(150 - 16, 50 - 20 - 16), QImage(":/MO/gui/warning"));
+    const auto flags = Qt::AlignHCenter | Qt::AlignVCenter | Qt::TextWordWrap;
+    paint.drawText(0, 46, 300, 54, flags,
+                   "This image format is not supported by Qt, but the preview plugin "
+                   "may be able to display it. Use the button above.");
+    paint.end();
+
+    m_image->setImage(image);
+  } else {
+    m_image->setImage(original);
+  }
+}
+
+void ImagesTab::updateSizeLabel()
+{
+  const auto* f = m_files.selectedFile();
+
+  if (f && f->originalSize().isValid()) {
+    ui->imagesSize->setText(dimensionString(f->originalSize()));
+  } else {
+    ui->imagesSize->clear();
+  }
+}
+
+void ImagesTab::onThumbnailLoaded(std::size_t id, const QString& path, int size,
+                                  QImage image, QSize originalSize)
+{
+  auto& files = m_files.allFiles();
+
+  if (id >= files.size() || files[id].path() != path) {
+    return;
+  }
+
+  auto& f = files[id];
+  f.setThumbnail(std::move(image), size, originalSize);
+
+  if (&f == m_files.selectedFile()) {
+    updateSizeLabel();
+  }
+
+  ui->imagesThumbnails->update();
+}
+
+void ImagesTab::onOriginalLoaded(std::size_t id, const QString& path, QImage image)
+{
+  auto* f = m_files.selectedFile();
+
+  // ignore images that were selected before
+  if (!f || m_files.idOf(f) != id || f->path() != path) {
+    return;
+  }
+
+  if (!image.isNull()) {
+    f->setOriginalSize(image.size());
+  }
+
+  setPreview(image);
+  updateSizeLabel();
+}
+
 void ImagesTab::moveSelection(int by)
 {
   if (m_files.empty()) {
@@ -418,6 +484,49 @@ void ImagesTab::paintThumbnailsArea(QPaintEvent* e)
   }
 }
 
+void ImagesTab::requestThumbnails()
+{
+  if (!ui->imagesThumbnails->isVisible()) {
+    // requested when shown
+    return;
+  }
+
+  const auto geo   = makeGeometry();
+  const auto value = ui->imagesScrollerVBar->value();
+
+  if (value < 0) {
+    return;
+  }
+
+  const auto first     = static_cast<std::size_t>(value);
+  const auto visible   = geo.fullyVisibleCount() + 1;
+  const auto imageSize = geo.imageRect(0).size();
+  const int size       = std::max(imageSize.width(), imageSize.height());
+
+  if (size <= 0) {
+    return;
+  }
+
+  const int thumbnailSize = ThumbnailLoader::thumbnailSize(size);
+  std::vector<ThumbnailLoader::Request> requests;
+
+  // visible thumbnails first, then the next page so they're ready when
+  // scrolling down; this replaces the previous requests, so thumbnails that
+  // are not visible anymore are not loaded
+  for (std::size_t i = first; i < first + visible * 2; ++i) {
+    const auto* f = m_files.get(i);
+    if (!f) {
+      break;
+    }
+
+    if (f->needsThumbnail(thumbnailSize)) {
+      requests.push_back({m_files.idOf(f), f->path(), size});
+    }
+  }
+
+  m_loader.load(requests);
+}
+
 void ImagesTab::paintThumbnail(const PaintContext& cx)
 {
   paintThumbnailBackground(cx);
@@ -449,17 +558,18 @@ void ImagesTab::paintThumbnailBorder(const PaintContext& cx)
 
 void ImagesTab::paintThumbnailImage(const PaintContext& cx)
 {
-  if (cx.file->failed()) {
+  const auto& thumbnail = cx.file->scaledThumbnail(cx.geo);
+
+  if (thumbnail.isNull()) {
+    // not loaded yet, only the border is drawn
     return;
   }
 
-  cx.file->loadIfNeeded(cx.geo);
-
   const auto imageRect       = cx.geo.imageRect(cx.thumbIndex);
-  const auto scaledThumbRect = centeredRect(imageRect, cx.file->thumbnail().size());
+  const auto scaledThumbRect = centeredRect(imageRect, thumbnail.size());
 
   cx.painter.fillRect(scaledThumbRect, m_theme.backgroundColor);
-  cx.painter.drawImage(scaledThumbRect, cx.file->thumbnail());
+  cx.painter.drawImage(scaledThumbRect, thumbnail);
 }
 
 void ImagesTab::paintThumbnailText(const PaintContext& cx)
@@ -486,6 +596,12 @@ void ImagesTab::paintThumbnailText(const PaintContext& cx)
 void ImagesTab::scrollAreaResized(const QSize&)
 {
   updateScrollbar();
+  requestThumbnails();
+}
+
+void ImagesTab::thumbnailAreaShown()
+{
+  requestThumbnails();
 }
 
 void ImagesTab::thumbnailAreaMouseEvent(QMouseEvent* e)
@@ -553,6 +669,7 @@ bool ImagesTab::thumbnailAreaKeyPressEvent(QKeyEvent* e)
 void ImagesTab::onScrolled()
 {
   ui->imagesThumbnails->update();
+  requestThumbnails();
 }
 
 void ImagesTab::showTooltip(QHelpEvent* e)
@@ -564,9 +681,12 @@ void ImagesTab::showTooltip(QHelpEvent* e)
     return;
   }
 
-  const auto s = QString("%1 (%2)")
-                     .arg(QDir::toNativeSeparators(f->path()))
-                     .arg(dimensionString(f->original().size()));
+  auto s = QDir::toNativeSeparators(f->path());
+
+  // the size is known once the thumbnail has been loaded
+  if (f->originalSize().isValid()) {
+    s = QString("%1 (%2)").arg(s).arg(dimensionString(f->originalSize()));
+  }
 
   QToolTip::showText(e->globalPos(), s, ui->imagesThumbnails);
 }
@@ -669,6 +789,15 @@ void ThumbnailsWidget::resizeEvent(QResizeEvent* e)
   }
 }
 
+void ThumbnailsWidget::showEvent(QShowEvent* e)
+{
+  QWidget::showEvent(e);
+
+  if (m_tab) {
+    m_tab->thumbnailAreaShown();
+  }
+}
+
 void ThumbnailsWidget::keyPressEvent(QKeyEvent* e)
 {
   if (m_tab) {
@@ -879,24 +1008,9 @@ QSize Geometry::scaledImageSize(const QSize& originalSize) const
   return resizeWithAspectRatio(originalSize, availableSize);
 }
 
-File::File(QString path) : m_path(std::move(path)), m_failed(false) {}
-
-void File::ensureOriginalLoaded()
-{
-  if (!m_original.isNull()) {
-    // already loaded
-    return;
-  }
-
-  QImageReader reader(m_path);
-
-  if (!reader.read(&m_original)) {
-    log::error("failed to load '{}'\n{} (error {})", m_path, reader.errorString(),
-               static_cast<int>(reader.error()));
-
-    m_failed = true;
-  }
-}
+File::File(QString path)
+    : m_path(std::move(path)), m_thumbnailSize(0), m_failed(false)
+{}
 
 const QString& File::path() const
 {
@@ -912,59 +1026,73 @@ const QString& File::filename() const
   return m_filename;
 }
 
-const QImage& File::original() const
+const QSize& File::originalSize() const
 {
-  return m_original;
+  return m_originalSize;
 }
 
-const QImage& File::thumbnail() const
+void File::setOriginalSize(QSize s)
 {
-  return m_thumbnail;
+  m_originalSize = s;
 }
 
-bool File::failed() const
+bool File::needsThumbnail(int size) const
 {
-  return m_failed;
+  return (!m_failed && m_thumbnailSize < size);
 }
 
-void File::loadIfNeeded(const Geometry& geo)
+void File::setThumbnail(QImage image, int size, QSize originalSize)
 {
-  if (needsLoad(geo)) {
-    load(geo);
-  }
-}
+  m_scaled = {};
 
-bool File::needsLoad(const Geometry& geo) const
-{
-  if (m_failed) {
-    return false;
+  if (image.isNull()) {
+    m_failed    = true;
+    m_thumbnail = QImage(":/MO/gui/warning");
+    return;
   }
 
-  if (m_original.isNull() || m_thumbnail.isNull()) {
-    return true;
+  m_failed        = false;
+  m_thumbnail     = std::move(image);
+  m_thumbnailSize = size;
+
+  if (originalSize.isValid()) {
+    m_originalSize = originalSize;
   }
+}
 
-  const auto scaledSize = geo.scaledImageSize(m_original.size());
-  return (m_thumbnail.size() != scaledSize);
+const QImage& File::thumbnail() const
+{
+  return m_thumbnail;
 }
 
-void File::load(const Geometry& geo)
+const QImage& File::scaledThumbnail(const Geometry& geo)
 {
-  m_failed = false;
-  ensureOriginalLoaded();
+  if (m_thumbnail.isNull()) {
+    return m_thumbnail;
+  }
 
-  if (m_failed) {
-    QImage warning(":/MO/gui/warning");
-    const auto scaledSize = geo.scaledImageSize(warning.size());
+  // the warning icon is drawn at its own size
+  const QSize reference =
+      (m_failed || !m_originalSize.isValid()) ? m_thumbnail.size() : m_originalSize;
 
-    m_thumbnail =
-        warning.scaled(scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-  } else {
-    const auto scaledSize = geo.scaledImageSize(m_original.size());
+  const auto scaledSize = geo.scaledImageSize(reference);
 
-    m_thumbnail =
-        m_original.scaled(scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+  if (scaledSize == m_thumbnail.size()) {
+    return m_thumbnail;
   }
+
+  if (m_scaled.size() != scaledSize) {
+    // thumbnails are small, scaling them on the ui thread is cheap
+    m_scaled =
+        m_thumbnail.scaled(scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+  }
+
+  return m_scaled;
+}
+
+bool File::failed() const
+{
+  return m_failed;
 }
 
 Files::Files() : m_selection(BadIndex), m_filtered(false) {}
@@ -1056,6 +1184,20 @@ std::size_t Files::indexOf(const File* f) const
   return BadIndex;
 }
 
+std::size_t Files::idOf(const File* f) const
+{
+  if (!f || m_allFiles.empty()) {
+    return BadIndex;
+  }
+
+  const auto* begin = m_allFiles.data();
+  if (f < begin || f >= begin + m_allFiles.size()) {
+    return BadIndex;
+  }
+
+  return static_cast<std::size_t>(f - begin);
+}
+
 const File* Files::selectedFile() const
 {
   return get(m_selection);
@@ -5,6 +5,7 @@
 #include "modinfodialogtab.h"
 #include "organizercore.h"
 #include "plugincontainer.h"
+#include "thumbnailloader.h"
 #include <QScrollBar>
 
 using namespace MOBase;
@@ -62,6 +63,10 @@ protected:
   //
   void resizeEvent(QResizeEvent* e) override;
 
+  // forwards to ImagesTab::thumbnailAreaShown()
+  //
+  void showEvent(QShowEvent* e) override;
+
   // forwards to ImagesTab::thumbnailAreaKeyPressEvent()
   //
   void keyPressEvent(QKeyEvent* e) override;
@@ -227,29 +232,50 @@ private:
   QRect calcTopRect() const;
 };
 
+// an image in the list; thumbnails are loaded by the ThumbnailLoader and
+// given to setThumbnail()
+//
 class File
 {
 public:
   File(QString path);
 
-  void ensureOriginalLoaded();
-
   const QString& path() const;
   const QString& filename() const;
-  const QImage& original() const;
+
+  // size of the full image, invalid until the thumbnail or the original has
+  // been loaded
+  //
+  const QSize& originalSize() const;
+  void setOriginalSize(QSize s);
+
+  // whether a thumbnail of the given size must be requested, which is false
+  // if a thumbnail at least as large has been loaded or if loading failed
+  //
+  bool needsThumbnail(int size) const;
+
+  // sets the thumbnail loaded for the given size, a null image means it
+  // couldn't be loaded
+  //
+  void setThumbnail(QImage image, int size, QSize originalSize);
+
+  // thumbnail as it was loaded, null if there's none yet
+  //
   const QImage& thumbnail() const;
-  bool failed() const;
 
-  void loadIfNeeded(const Geometry& geo);
+  // thumbnail scaled to fit in the geometry, null if there's none yet
+  //
+  const QImage& scaledThumbnail(const Geometry& geo);
+
+  bool failed() const;
 
 private:
   QString m_path;
   mutable QString m_filename;
-  QImage m_original, m_thumbnail;
+  QSize m_originalSize;
+  QImage m_thumbnail, m_scaled;
+  int m_thumbnailSize;
   bool m_failed;
-
-  bool needsLoad(const Geometry& geo) const;
-  void load(const Geometry& geo);
 };
 
 class Files
@@ -272,6 +298,9 @@ public:
   File* get(std::size_t i);
   std::size_t indexOf(const File* f) const;
 
+  // index of the file in allFiles()
+  std::size_t idOf(const File* f) const;
+
   const File* selectedFile() const;
   File* selectedFile();
   std::size_t selectedIndex() const;
@@ -339,11 +368,13 @@ private:
   bool m_ddsAvailable, m_ddsEnabled;
   Theme m_theme;
   Metrics m_metrics;
+  ThumbnailLoader m_loader;
 
   void getSupportedFormats();
   void enableDDS(bool b);
 
   void scrollAreaResized(const QSize& s);
+  void thumbnailAreaShown();
   void paintThumbnailsArea(QPaintEvent* e);
   void thumbnailAreaMouseEvent(QMouseEvent* e);
   void thumbnailAreaWheelEvent(QWheelEvent* e);
@@ -355,8 +386,13 @@ private:
   void onShowDDS();
   void onPreviewButton();
   void onFilterChanged();
+  void onThumbnailLoaded(std::size_t id, const QString& path, int size, QImage image,
+                         QSize originalSize);
+  void onOriginalLoaded(std::size_t id, const QString& path, QImage image);
 
   void select(std::size_t i, Visibility v = Visibility::Full);
+  void setPreview(const QImage& image);
+  void updateSizeLabel();
   void moveSelection(int by);
   void ensureVisible(std::size_t i, Visibility v);
 
@@ -371,6 +407,12 @@ private:
   void paintThumbnailImage(const PaintContext& cx);
   void paintThumbnailText(const PaintContext& cx);
 
+  // requests thumbnails for the visible files first, then the next page;
+  // called when the visible files change, such as when scrolling, resizing or
+  // filtering, never while painting
+  //
+  void requestThumbnails();
+
   void checkFiltering();
   void switchToAll();
   void switchToFiltered();
@@ -3,6 +3,7 @@
 #include "categories.h"
 #include "messagedialog.h"
 #include "moddatacontent.h"
+#include "modmetaindex.h"
 #include "organizercore.h"
 #include "plugincontainer.h"
 #include "report.h"
@@ -28,7 +29,8 @@ static bool ByName(const ModInfo::Ptr& LHS, const ModInfo::Ptr& RHS)
 }
 }  // namespace
 
-ModInfoRegular::ModInfoRegular(const QDir& path, OrganizerCore& core)
+ModInfoRegular::ModInfoRegular(const QDir& path, OrganizerCore& core,
+                               const ModMeta* meta)
     : ModInfoWithConflictInfo(core), m_Name(path.dirName()),
       m_Path(path.absolutePath()), m_Repository(),
       m_GameName(core.managedGame()->gameShortName()), m_IsAlternate(false),
@@ -39,7 +41,11 @@ ModInfoRegular::ModInfoRegular(const QDir& path, OrganizerCore& core)
 {
   m_CreationTime = QFileInfo(path.absolutePath()).birthTime();
   // read out the meta-file for information
-  readMeta();
+  if (meta) {
+    readMeta(*meta);
+  } else {
+    readMeta();
+  }
   if (m_GameName.compare(core.managedGame()->gameShortName(), Qt::CaseInsensitive) != 0)
     if (!core.managedGame()->primarySources().contains(m_GameName, Qt::CaseInsensitive))
       m_IsAlternate = true;
@@ -84,7 +90,11 @@ bool ModInfoRegular::isEmpty() const
 
 void ModInfoRegular::readMeta()
 {
-  QSettings metaFile(m_Path + "/meta.ini", QSettings::IniFormat);
+  readMeta(s_MetaIndex.get(m_Path + "/meta.ini"));
+}
+
+void ModInfoRegular::readMeta(const ModMeta& metaFile)
+{
   m_Comments           = metaFile.value("comments", "").toString();
   m_Notes              = metaFile.value("notes", "").toString();
   QString tempGameName = metaFile.value("gameName", m_GameName).toString();
@@ -219,24 +229,19 @@ void ModInfoRegular::readMeta()
     }
   }
 
-  int numFiles = metaFile.beginReadArray("installedFiles");
+  int numFiles = metaFile.arraySize("installedFiles");
   for (int i = 0; i < numFiles; ++i) {
-    metaFile.setArrayIndex(i);
-    m_InstalledFileIDs.insert(std::make_pair(metaFile.value("modid").toInt(),
-                                             metaFile.value("fileid").toInt()));
+    m_InstalledFileIDs.insert(
+        std::make_pair(metaFile.arrayValue("installedFiles", i, "modid").toInt(),
+                       metaFile.arrayValue("installedFiles", i, "fileid").toInt()));
   }
-  metaFile.endArray();
 
   // Plugin settings:
-  metaFile.beginGroup("Plugins");
-  for (auto pluginName : metaFile.childGroups()) {
-    metaFile.beginGroup(pluginName);
-    for (auto settingKey : metaFile.childKeys()) {
-      m_PluginSettings[pluginName][settingKey] = metaFile.value(settingKey);
+  for (auto&& [pluginName, settings] : metaFile.subgroups("Plugins")) {
+    for (auto&& [settingKey, value] : settings) {
+      m_PluginSettings[pluginName][settingKey] = value;
     }
-    metaFile.endGroup();
   }
-  metaFile.endGroup();
 
   m_MetaInfoChanged = false;
 }
@@ -393,6 +393,7 @@ public:
   virtual void saveMeta() override;
 
   void readMeta() override;
+  void readMeta(const ModMeta& metaFile);
 
   virtual void setHasCustomURL(bool b) override;
   virtual bool hasCustomURL() const override;
@@ -434,7 +435,11 @@ private slots:
 protected:
   virtual std::set<int> doGetContents() const override;
 
-  ModInfoRegular(const QDir& path, OrganizerCore& core);
+  // `meta` is the content of the meta.ini of the mod, it's read from
+  // s_MetaIndex if null
+  //
+  ModInfoRegular(const QDir& path, OrganizerCore& core,
+                 const ModMeta* meta = nullptr);
 
 private:
   QString m_Name;
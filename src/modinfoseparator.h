@@ -54,7 +54,8 @@ protected:
   virtual bool doIsValid() const override { return true; }
 
 private:
-  ModInfoSeparator(const QDir& path, OrganizerCore& core);
+  ModInfoSeparator(const QDir& path, OrganizerCore& core,
+                   const ModMeta* meta = nullptr);
 };
 
 #endif
@@ -47,43 +47,43 @@ std::vector<ModInfo::EConflictFlag> ModInfoWithConflictInfo::getConflictFlags()
 {
   std::vector<ModInfo::EConflictFlag> result;
   switch (isConflicted()) {
-  case CONFLICT_MIXED: {
+  case ConflictIndex::CONFLICT_MIXED: {
     result.push_back(ModInfo::FLAG_CONFLICT_MIXED);
   } break;
-  case CONFLICT_OVERWRITE: {
+  case ConflictIndex::CONFLICT_OVERWRITE: {
     result.push_back(ModInfo::FLAG_CONFLICT_OVERWRITE);
   } break;
-  case CONFLICT_OVERWRITTEN: {
+  case ConflictIndex::CONFLICT_OVERWRITTEN: {
     result.push_back(ModInfo::FLAG_CONFLICT_OVERWRITTEN);
   } break;
-  case CONFLICT_REDUNDANT: {
+  case ConflictIndex::CONFLICT_REDUNDANT: {
     result.push_back(ModInfo::FLAG_CONFLICT_REDUNDANT);
   } break;
   default: { /* NOP */
   }
   }
   switch (isLooseArchiveConflicted()) {
-  case CONFLICT_MIXED: {
+  case ConflictIndex::CONFLICT_MIXED: {
     result.push_back(ModInfo::FLAG_ARCHIVE_LOOSE_CONFLICT_OVERWRITE);
     result.push_back(ModInfo::FLAG_ARCHIVE_LOOSE_CONFLICT_OVERWRITTEN);
   } break;
-  case CONFLICT_OVERWRITE: {
+  case ConflictIndex::CONFLICT_OVERWRITE: {
     result.push_back(ModInfo::FLAG_ARCHIVE_LOOSE_CONFLICT_OVERWRITE);
   } break;
-  case CONFLICT_OVERWRITTEN: {
+  case ConflictIndex::CONFLICT_OVERWRITTEN: {
     result.push_back(ModInfo::FLAG_ARCHIVE_LOOSE_CONFLICT_OVERWRITTEN);
   } break;
   default: { /* NOP */
   }
   }
   switch (isArchiveConflicted()) {
-  case CONFLICT_MIXED: {
+  case ConflictIndex::CONFLICT_MIXED: {
     result.push_back(ModInfo::FLAG_ARCHIVE_CONFLICT_MIXED);
   } break;
-  case CONFLICT_OVERWRITE: {
+  case ConflictIndex::CONFLICT_OVERWRITE: {
     result.push_back(ModInfo::FLAG_ARCHIVE_CONFLICT_OVERWRITE);
   } break;
-  case CONFLICT_OVERWRITTEN: {
+  case ConflictIndex::CONFLICT_OVERWRITTEN: {
     result.push_back(ModInfo::FLAG_ARCHIVE_CONFLICT_OVERWRITTEN);
   } break;
   default: { /* NOP */
@@ -92,10 +92,52 @@ std::vector<ModInfo::EConflictFlag> ModInfoWithConflictInfo::getConflictFlags()
   return result;
 }
 
+ModInfoWithConflictInfo::Conflicts
+ModInfoWithConflictInfo::conflictsFromIndex(const ConflictIndex::Conflicts& c) const
+{
+  Conflicts conflicts;
+
+  conflicts.m_CurrentConflictState      = c.currentState;
+  conflicts.m_ArchiveConflictState      = c.archiveState;
+  conflicts.m_ArchiveConflictLooseState = c.archiveLooseState;
+  conflicts.m_HasHiddenFiles            = c.hasHiddenFiles;
+
+  // the index has origin IDs, mods want indices
+  auto toIndices = [&](const std::set<OriginID>& ids, std::set<unsigned int>& out) {
+    for (const auto id : ids) {
+      const auto* o = m_Core.directoryStructure()->findOriginByID(id);
+      if (o) {
+        out.insert(ModInfo::getIndex(ToQString(o->getName())));
+      }
+    }
+  };
+
+  toIndices(c.overwrite, conflicts.m_OverwriteList);
+  toIndices(c.overwritten, conflicts.m_OverwrittenList);
+  toIndices(c.archiveOverwrite, conflicts.m_ArchiveOverwriteList);
+  toIndices(c.archiveOverwritten, conflicts.m_ArchiveOverwrittenList);
+  toIndices(c.archiveLooseOverwrite, conflicts.m_ArchiveLooseOverwriteList);
+  toIndices(c.archiveLooseOverwritten, conflicts.m_ArchiveLooseOverwrittenList);
+
+  return conflicts;
+}
+
 ModInfoWithConflictInfo::Conflicts ModInfoWithConflictInfo::doConflictCheck() const
 {
   Conflicts conflicts;
 
+  std::wstring name = ToWString(this->name());
+
+  if (const auto* index = m_Core.conflictIndex()) {
+    if (m_Core.directoryStructure()->originExists(name)) {
+      const auto id = m_Core.directoryStructure()->getOriginByName(name).getID();
+
+      if (auto c = index->find(id)) {
+        return conflictsFromIndex(*c);
+      }
+    }
+  }
+
   bool providesAnything = false;
   bool hasHiddenFiles   = false;
 
@@ -104,7 +146,6 @@ ModInfoWithConflictInfo::Conflicts ModInfoWithConflictInfo::doConflictCheck() co
     dataID = m_Core.directoryStructure()->getOriginByName(L"data").getID();
   }
 
-  std::wstring name          = ToWString(this->name());
   const std::wstring hideExt = ToWString(ModInfo::s_HiddenExt);
 
   if (m_Core.directoryStructure()->originExists(name)) {
@@ -215,30 +256,30 @@ ModInfoWithConflictInfo::Conflicts ModInfoWithConflictInfo::doConflictCheck() co
 
     if (files.size() != 0) {
       if (!providesAnything)
-        conflicts.m_CurrentConflictState = CONFLICT_REDUNDANT;
+        conflicts.m_CurrentConflictState = ConflictIndex::CONFLICT_REDUNDANT;
       else if (!conflicts.m_OverwriteList.empty() &&
                !conflicts.m_OverwrittenList.empty())
-        conflicts.m_CurrentConflictState = CONFLICT_MIXED;
+        conflicts.m_CurrentConflictState = ConflictIndex::CONFLICT_MIXED;
       else if (!conflicts.m_OverwriteList.empty())
-        conflicts.m_CurrentConflictState = CONFLICT_OVERWRITE;
+        conflicts.m_CurrentConflictState = ConflictIndex::CONFLICT_OVERWRITE;
       else if (!conflicts.m_OverwrittenList.empty())
-        conflicts.m_CurrentConflictState = CONFLICT_OVERWRITTEN;
+        conflicts.m_CurrentConflictState = ConflictIndex::CONFLICT_OVERWRITTEN;
 
       if (!conflicts.m_ArchiveOverwriteList.empty() &&
           !conflicts.m_ArchiveOverwrittenList.empty())
-        conflicts.m_ArchiveConflictState = CONFLICT_MIXED;
+        conflicts.m_ArchiveConflictState = ConflictIndex::CONFLICT_MIXED;
       else if (!conflicts.m_ArchiveOverwriteList.empty())
-        conflicts.m_ArchiveConflictState = CONFLICT_OVERWRITE;
+        conflicts.m_ArchiveConflictState = ConflictIndex::CONFLICT_OVERWRITE;
       else if (!conflicts.m_ArchiveOverwrittenList.empty())
-        conflicts.m_ArchiveConflictState = CONFLICT_OVERWRITTEN;
+        conflicts.m_ArchiveConflictState = ConflictIndex::CONFLICT_OVERWRITTEN;
 
       if (!conflicts.m_ArchiveLooseOverwrittenList.empty() &&
           !conflicts.m_ArchiveLooseOverwriteList.empty())
-        conflicts.m_ArchiveConflictLooseState = CONFLICT_MIXED;
+        conflicts.m_ArchiveConflictLooseState = ConflictIndex::CONFLICT_MIXED;
       else if (!conflicts.m_ArchiveLooseOverwrittenList.empty())
-        conflicts.m_ArchiveConflictLooseState = CONFLICT_OVERWRITTEN;
+        conflicts.m_ArchiveConflictLooseState = ConflictIndex::CONFLICT_OVERWRITTEN;
       else if (!conflicts.m_ArchiveLooseOverwriteList.empty())
-        conflicts.m_ArchiveConflictLooseState = CONFLICT_OVERWRITE;
+        conflicts.m_ArchiveConflictLooseState = ConflictIndex::CONFLICT_OVERWRITE;
 
       conflicts.m_HasHiddenFiles = hasHiddenFiles;
     }
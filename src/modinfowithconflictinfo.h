@@ -3,6 +3,7 @@
 
 #include <ifiletree.h>
 
+#include "conflictindex.h"
 #include "memoizedlock.h"
 #include "modinfo.h"
 
@@ -100,15 +101,7 @@ protected:
   ModInfoWithConflictInfo(OrganizerCore& core);
 
 private:
-  enum EConflictType
-  {
-    CONFLICT_NONE,
-    CONFLICT_OVERWRITE,
-    CONFLICT_OVERWRITTEN,
-    CONFLICT_MIXED,
-    CONFLICT_REDUNDANT,
-    CONFLICT_CROSS
-  };
+  using EConflictType = ConflictIndex::EConflictType;
 
 private:
   /**
@@ -146,9 +139,9 @@ protected:
 private:
   struct Conflicts
   {
-    EConflictType m_CurrentConflictState      = CONFLICT_NONE;
-    EConflictType m_ArchiveConflictState      = CONFLICT_NONE;
-    EConflictType m_ArchiveConflictLooseState = CONFLICT_NONE;
+    EConflictType m_CurrentConflictState      = ConflictIndex::CONFLICT_NONE;
+    EConflictType m_ArchiveConflictState      = ConflictIndex::CONFLICT_NONE;
+    EConflictType m_ArchiveConflictLooseState = ConflictIndex::CONFLICT_NONE;
     bool m_HasLooseOverwrite                  = false;
     bool m_HasHiddenFiles                     = false;
 
@@ -166,7 +159,11 @@ private:
                                         // this mod's archive files
   };
 
+  // uses the conflict index from the last refresh if it has an entry for this
+  // mod, or walks the files of this mod otherwise
+  //
   Conflicts doConflictCheck() const;
+  Conflicts conflictsFromIndex(const ConflictIndex::Conflicts& c) const;
 
   MOBase::MemoizedLocked<std::shared_ptr<const MOBase::IFileTree>> m_FileTree;
   MOBase::MemoizedLocked<bool> m_Valid;
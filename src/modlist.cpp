@@ -55,6 +55,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <QWidgetAction>
 
 #include <algorithm>
+#include <map>
 #include <sstream>
 #include <stdexcept>
 
@@ -63,7 +64,9 @@ using namespace MOBase;
 ModList::ModList(PluginContainer* pluginContainer, OrganizerCore* organizer)
     : QAbstractItemModel(organizer), m_Organizer(organizer), m_Profile(nullptr),
       m_NexusInterface(nullptr), m_Modified(false), m_InNotifyChange(false),
-      m_FontMetrics(QFont()), m_PluginContainer(pluginContainer)
+      m_FontMetrics(QFont()), m_PluginContainer(pluginContainer),
+      m_UpdateIcon(":/MO/gui/update_available"), m_DowngradeIcon(":/MO/gui/warning"),
+      m_DateVersionIcon(":/MO/gui/version_date")
 {
   m_LastCheck.start();
 }
@@ -194,7 +197,7 @@ QVariant ModList::data(const QModelIndex& modelIndex, int role) const
         (column == COL_CONFLICTFLAGS)) {
       return QVariant();
     } else if (column == COL_NAME) {
-      return getDisplayName(modInfo);
+      return cachedRow(modIndex, *modInfo).displayName;
     } else if (column == COL_VERSION) {
       VersionInfo verInfo = modInfo->version();
       QString version     = verInfo.displayString();
@@ -218,14 +221,7 @@ QVariant ModList::data(const QModelIndex& modelIndex, int role) const
         return QVariant();
       }
     } else if (column == COL_GAME) {
-      if (m_PluginContainer != nullptr) {
-        for (auto game : m_PluginContainer->plugins<IPluginGame>()) {
-          if (game->gameShortName().compare(modInfo->gameName(), Qt::CaseInsensitive) ==
-              0)
-            return game->gameName();
-        }
-      }
-      return modInfo->gameName();
+      return cachedRow(modIndex, *modInfo).gameDisplayName;
     } else if (column == COL_CATEGORY) {
       if (modInfo->hasFlag(ModInfo::FLAG_FOREIGN)) {
         return tr("Non-MO");
@@ -234,13 +230,7 @@ QVariant ModList::data(const QModelIndex& modelIndex, int role) const
         if (category != -1) {
           CategoryFactory& categoryFactory = CategoryFactory::instance();
           if (categoryFactory.categoryExists(category)) {
-            try {
-              int categoryIdx = categoryFactory.getCategoryIndex(category);
-              return categoryFactory.getCategoryName(categoryIdx);
-            } catch (const std::exception& e) {
-              log::error("failed to retrieve category name: {}", e.what());
-              return QString();
-            }
+            return cachedRow(modIndex, *modInfo).categoryName;
           } else {
             log::warn("category {} doesn't exist (may have been removed)", category);
             modInfo->setCategory(category, false);
@@ -284,18 +274,7 @@ QVariant ModList::data(const QModelIndex& modelIndex, int role) const
     }
   } else if (role == GroupingRole) {
     if (column == COL_CATEGORY) {
-      QVariantList categoryNames;
-      std::set<int> categories         = modInfo->getCategories();
-      CategoryFactory& categoryFactory = CategoryFactory::instance();
-      for (auto iter = categories.begin(); iter != categories.end(); ++iter) {
-        categoryNames.append(
-            categoryFactory.getCategoryName(categoryFactory.getCategoryIndex(*iter)));
-      }
-      if (categoryNames.count() != 0) {
-        return categoryNames;
-      } else {
-        return QVariant();
-      }
+      return cachedRow(modIndex, *modInfo).categoryNames;
     } else {
       return modInfo->nexusId();
     }
@@ -341,11 +320,11 @@ QVariant ModList::data(const QModelIndex& modelIndex, int role) const
   } else if (role == Qt::DecorationRole) {
     if (column == COL_VERSION) {
       if (modInfo->updateAvailable()) {
-        return QIcon(":/MO/gui/update_available");
+        return m_UpdateIcon;
       } else if (modInfo->downgradeAvailable()) {
-        return QIcon(":/MO/gui/warning");
+        return m_DowngradeIcon;
       } else if (modInfo->version().scheme() == VersionInfo::SCHEME_DATE) {
-        return QIcon(":/MO/gui/version_date");
+        return m_DateVersionIcon;
       }
     }
     return QVariant();
@@ -475,6 +454,156 @@ QVariant ModList::data(const QModelIndex& modelIndex, int role) const
   }
 }
 
+const ModList::RowCache& ModList::cachedRow(unsigned int modIndex,
+                                            const ModInfo& info) const
+{
+  if (modIndex >= m_RowCache.size()) {
+    m_RowCache.resize(std::max(ModInfo::getNumMods(), modIndex + 1));
+  }
+
+  auto& row                        = m_RowCache[modIndex];
+  CategoryFactory& categoryFactory = CategoryFactory::instance();
+
+  // cheap checks, the inputs are all members of the mod
+  if (row.built && row.categoryGeneration == categoryFactory.generation() &&
+      row.name == info.name() && row.gameName == info.gameName() &&
+      row.primaryCategory == info.primaryCategory() &&
+      row.categories == info.getCategories()) {
+    return row;
+  }
+
+  row                    = {};
+  row.built              = true;
+  row.categoryGeneration = categoryFactory.generation();
+  row.name               = info.name();
+  row.gameName           = info.gameName();
+  row.primaryCategory    = info.primaryCategory();
+  row.categories         = info.getCategories();
+
+  row.displayName = row.name;
+  if (info.isSeparator()) {
+    row.displayName.replace("_separator", "");
+  }
+
+  row.gameDisplayName = row.gameName;
+  if (m_PluginContainer != nullptr) {
+    for (auto game : m_PluginContainer->plugins<IPluginGame>()) {
+      if (game->gameShortName().compare(row.gameName, Qt::CaseInsensitive) == 0) {
+        row.gameDisplayName = game->gameName();
+        break;
+      }
+    }
+  }
+
+  if (categoryFactory.categoryExists(row.primaryCategory)) {
+    try {
+      row.categoryName = categoryFactory.getCategoryName(
+          categoryFactory.getCategoryIndex(row.primaryCategory));
+    } catch (const std::exception& e) {
+      log::error("failed to retrieve category name: {}", e.what());
+    }
+  }
+
+  QVariantList categoryNames;
+  for (int category : row.categories) {
+    try {
+      categoryNames.append(
+          categoryFactory.getCategoryName(categoryFactory.getCategoryIndex(category)));
+    } catch (const std::exception& e) {
+      log::error("failed to retrieve category name: {}", e.what());
+    }
+  }
+
+  if (!categoryNames.isEmpty()) {
+    row.categoryNames = categoryNames;
+  }
+
+  return row;
+}
+
+QString ModList::categoryName(unsigned int modIndex) const
+{
+  return cachedRow(modIndex, *ModInfo::getByIndex(modIndex)).categoryName;
+}
+
+ModList::FlagsSortKey ModList::flagsSortKey(unsigned int modIndex) const
+{
+  return cachedFlagsRow(modIndex).flagsKey;
+}
+
+ModList::FlagsSortKey ModList::conflictFlagsSortKey(unsigned int modIndex) const
+{
+  return cachedFlagsRow(modIndex).conflictFlagsKey;
+}
+
+const ModList::RowCache& ModList::cachedFlagsRow(unsigned int modIndex) const
+{
+  auto modInfo = ModInfo::getByIndex(modIndex);
+
+  // cachedRow() may have to rebuild the row, which drops the keys
+  cachedRow(modIndex, *modInfo);
+  auto& row = m_RowCache[modIndex];
+
+  if (row.flagsKeysBuilt) {
+    return row;
+  }
+
+  const auto flags = modInfo->getFlags();
+
+  unsigned long flagsId = 0;
+  for (ModInfo::EFlag flag : flags) {
+    if ((flag != ModInfo::FLAG_FOREIGN) && (flag != ModInfo::FLAG_OVERWRITE)) {
+      flagsId += 1 << (int)flag;
+    }
+  }
+
+  const auto conflictFlags = modInfo->getConflictFlags();
+
+  unsigned long conflictFlagsId = 0;
+  for (ModInfo::EConflictFlag flag : conflictFlags) {
+    if ((flag != ModInfo::FLAG_OVERWRITE_CONFLICT)) {
+      conflictFlagsId += 1 << (int)flag;
+    }
+  }
+
+  row.flagsKey         = {flags.size(), flagsId};
+  row.conflictFlagsKey = {conflictFlags.size(), conflictFlagsId};
+  row.flagsKeysBuilt   = true;
+
+  return row;
+}
+
+void ModList::invalidateFlags(int modIndex) const
+{
+  if (modIndex < 0) {
+    for (auto& row : m_RowCache) {
+      row.flagsKeysBuilt = false;
+    }
+
+    return;
+  }
+
+  if (modIndex < static_cast<int>(m_RowCache.size())) {
+    m_RowCache[modIndex].flagsKeysBuilt = false;
+  }
+}
+
+void ModList::invalidateRows(int rowStart, int rowEnd) const
+{
+  if (rowStart < 0) {
+    m_RowCache.clear();
+    return;
+  }
+
+  if (rowEnd < 0) {
+    rowEnd = rowStart;
+  }
+
+  for (int i = rowStart; i <= rowEnd && i < static_cast<int>(m_RowCache.size()); ++i) {
+    m_RowCache[i].built = false;
+  }
+}
+
 bool ModList::renameMod(int index, const QString& newName)
 {
   QString nameFixed = newName;
@@ -660,52 +789,30 @@ void ModList::changeModPriority(std::vector<int> sourceIndices, int newPriority)
   if (m_Profile == nullptr)
     return;
 
-  emit layoutAboutToBeChanged();
-
-  // sort the moving mods by ascending priorities
-  std::sort(sourceIndices.begin(), sourceIndices.end(),
-            [=](const int& LHS, const int& RHS) {
-              return m_Profile->getModPriority(LHS) > m_Profile->getModPriority(RHS);
-            });
-
-  // move mods that are decreasing in priority
-  for (const auto& index : sourceIndices) {
-    int oldPriority = m_Profile->getModPriority(index);
-    if (oldPriority > newPriority) {
-      if (m_Profile->setModPriority(index, newPriority)) {
-        m_ModMoved(ModInfo::getByIndex(index)->name(), oldPriority, newPriority);
-      }
-    }
+  // old priorities, only for the mods being moved
+  std::map<unsigned int, int> oldPriorities;
+  for (const auto index : sourceIndices) {
+    oldPriorities[index] = m_Profile->getModPriority(index);
   }
 
-  // sort the moving mods by descending priorities
-  std::sort(sourceIndices.begin(), sourceIndices.end(),
-            [=](const int& LHS, const int& RHS) {
-              return m_Profile->getModPriority(LHS) < m_Profile->getModPriority(RHS);
-            });
+  emit layoutAboutToBeChanged();
 
-  // if at least one mod is increasing in priority, the target index is
-  // that of the row BELOW the dropped location, otherwise it's the one above
-  for (const auto& index : sourceIndices) {
-    int oldPriority = m_Profile->getModPriority(index);
-    if (oldPriority < newPriority) {
-      --newPriority;
-      break;
-    }
-  }
+  // the whole selection is moved at once, which keeps the order of the
+  // selected mods and only updates the indices and writes the list once
+  const auto changed = m_Profile->moveModsPriority(
+      std::vector<unsigned int>(sourceIndices.begin(), sourceIndices.end()),
+      newPriority);
 
-  // move mods that are increasing in priority
-  for (const auto& index : sourceIndices) {
-    int oldPriority = m_Profile->getModPriority(index);
-    if (oldPriority < newPriority) {
-      if (m_Profile->setModPriority(index, newPriority)) {
-        m_ModMoved(ModInfo::getByIndex(index)->name(), oldPriority, newPriority);
-      }
+  emit layoutChanged();
+
+  for (const auto index : changed) {
+    auto itor = oldPriorities.find(index);
+    if (itor != oldPriorities.end()) {
+      m_ModMoved(ModInfo::getByIndex(index)->name(), itor->second,
+                 m_Profile->getModPriority(index));
     }
   }
 
-  emit layoutChanged();
-
   QModelIndexList indices;
   for (auto& idx : sourceIndices) {
     indices.append(index(idx, 0, QModelIndex()));
@@ -729,6 +836,7 @@ void ModList::changeModPriority(int sourceIndex, int newPriority)
 void ModList::setPluginContainer(PluginContainer* pluginContianer)
 {
   m_PluginContainer = pluginContianer;
+  invalidateRows(-1);
 }
 
 bool ModList::modInfoAboutToChange(ModInfo::Ptr info)
@@ -752,6 +860,7 @@ void ModList::modInfoChanged(ModInfo::Ptr info)
 
     int row = ModInfo::getIndex(info->name());
     info->diskContentModified();
+    invalidateRows(row);
     emit aboutToChangeData();
     emit dataChanged(index(row, 0), index(row, columnCount()));
     emit postDataChanged();
@@ -977,6 +1086,8 @@ void ModList::notifyModStateChanged(QList<unsigned int> modIndices) const
   QModelIndexList indices;
   std::map<QString, IModList::ModStates> mods;
   for (auto modIndex : modIndices) {
+    invalidateRows(modIndex);
+
     indices.append(index(modIndex, 0));
     ModInfo::Ptr modInfo = ModInfo::getByIndex(modIndex);
     mods.emplace(modInfo->name(), state(modIndex));
@@ -1230,6 +1341,8 @@ void ModList::notifyChange(int rowStart, int rowEnd)
     m_InNotifyChange = false;
   });
 
+  invalidateRows(rowStart, rowEnd);
+
   if (rowStart < 0) {
     beginResetModel();
     endResetModel();
@@ -29,6 +29,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include <imodlist.h>
 
 #include <QFile>
+#include <QIcon>
 #include <QListWidget>
 #include <QMetaEnum>
 #include <QNetworkAccessManager>
@@ -170,6 +171,27 @@ public:
    */
   void notifyModStateChanged(QList<unsigned int> modIndices) const;
 
+  /**
+   * @brief Forget the sort keys of the flag columns of a mod. This must be called
+   * every time the caches of a mod are cleared, because its flags and conflicts
+   * may have changed.
+   *
+   * @param modIndex Index of the mod, or -1 for all of them.
+   */
+  void invalidateFlags(int modIndex) const;
+
+  // sorts by the number of flags first, then by which flags are set
+  //
+  using FlagsSortKey = std::pair<std::size_t, unsigned long>;
+
+  // cached values used by ModListSortProxy so sorting doesn't go through
+  // data(), which has side effects, or recompute the flags of every mod for
+  // every comparison
+  //
+  QString categoryName(unsigned int modIndex) const;
+  FlagsSortKey flagsSortKey(unsigned int modIndex) const;
+  FlagsSortKey conflictFlagsSortKey(unsigned int modIndex) const;
+
 public:
   /// \copydoc MOBase::IModList::displayName
   QString displayName(const QString& internalName) const;
@@ -392,6 +414,39 @@ private:
     QFlags<MOBase::IModList::ModState> state;
   };
 
+  // values shown for a row that are expensive to compute but only depend on
+  // the mod itself, see cachedRow()
+  //
+  // the inputs are kept alongside the values because not every change to a
+  // mod goes through notifyChange() or modInfoChanged(), so entries are
+  // checked against them before being used
+  //
+  struct RowCache
+  {
+    bool built                     = false;
+    std::size_t categoryGeneration = 0;
+
+    // inputs
+    QString name;
+    QString gameName;
+    int primaryCategory = -1;
+    std::set<int> categories;
+
+    // values
+    QString displayName;
+    QString gameDisplayName;
+    QString categoryName;
+    QVariant categoryNames;
+
+    // sort keys of the flag columns, computed the first time the list is
+    // sorted by one of them; the flags have no cheap inputs, so these are
+    // dropped by invalidateFlags() when the caches of the mod are cleared, and
+    // with the rest of the row
+    bool flagsKeysBuilt = false;
+    FlagsSortKey flagsKey;
+    FlagsSortKey conflictFlagsKey;
+  };
+
 private:
   OrganizerCore* m_Organizer;
   Profile* m_Profile;
@@ -415,6 +470,28 @@ private:
   QElapsedTimer m_LastCheck;
 
   PluginContainer* m_PluginContainer;
+
+  // by mod index, grows as rows are painted
+  mutable std::vector<RowCache> m_RowCache;
+
+  // decorations of the version column
+  QIcon m_UpdateIcon;
+  QIcon m_DowngradeIcon;
+  QIcon m_DateVersionIcon;
+
+  // returns the cached values for the given row, rebuilding them if the mod
+  // has changed since
+  //
+  const RowCache& cachedRow(unsigned int modIndex, const ModInfo& info) const;
+
+  // forgets the cached values for the given rows, or all of them if
+  // `rowStart` is negative
+  //
+  void invalidateRows(int rowStart, int rowEnd = -1) const;
+
+  // builds the sort keys of the flag columns if needed
+  //
+  const RowCache& cachedFlagsRow(unsigned int modIndex) const;
 };
 
 #endif  // MODLIST_H
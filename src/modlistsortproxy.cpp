@@ -72,29 +72,6 @@ void ModListSortProxy::setCriteria(const std::vector<Criteria>& criteria)
   }
 }
 
-unsigned long ModListSortProxy::flagsId(const std::vector<ModInfo::EFlag>& flags) const
-{
-  unsigned long result = 0;
-  for (ModInfo::EFlag flag : flags) {
-    if ((flag != ModInfo::FLAG_FOREIGN) && (flag != ModInfo::FLAG_OVERWRITE)) {
-      result += 1 << (int)flag;
-    }
-  }
-  return result;
-}
-
-unsigned long ModListSortProxy::conflictFlagsId(
-    const std::vector<ModInfo::EConflictFlag>& flags) const
-{
-  unsigned long result = 0;
-  for (ModInfo::EConflictFlag flag : flags) {
-    if ((flag != ModInfo::FLAG_OVERWRITE_CONFLICT)) {
-      result += 1 << (int)flag;
-    }
-  }
-  return result;
-}
-
 bool ModListSortProxy::lessThan(const QModelIndex& left, const QModelIndex& right) const
 {
   if (sourceModel()->hasChildren(left) || sourceModel()->hasChildren(right)) {
@@ -126,22 +103,12 @@ bool ModListSortProxy::lessThan(const QModelIndex& left, const QModelIndex& righ
 
   switch (left.column()) {
   case ModList::COL_FLAGS: {
-    std::vector<ModInfo::EFlag> leftFlags  = leftMod->getFlags();
-    std::vector<ModInfo::EFlag> rightFlags = rightMod->getFlags();
-    if (leftFlags.size() != rightFlags.size()) {
-      lt = leftFlags.size() < rightFlags.size();
-    } else {
-      lt = flagsId(leftFlags) < flagsId(rightFlags);
-    }
+    lt = m_Organizer->modList()->flagsSortKey(leftIndex) <
+         m_Organizer->modList()->flagsSortKey(rightIndex);
   } break;
   case ModList::COL_CONFLICTFLAGS: {
-    std::vector<ModInfo::EConflictFlag> leftFlags  = leftMod->getConflictFlags();
-    std::vector<ModInfo::EConflictFlag> rightFlags = rightMod->getConflictFlags();
-    if (leftFlags.size() != rightFlags.size()) {
-      lt = leftFlags.size() < rightFlags.size();
-    } else {
-      lt = conflictFlagsId(leftFlags) < conflictFlagsId(rightFlags);
-    }
+    lt = m_Organizer->modList()->conflictFlagsSortKey(leftIndex) <
+         m_Organizer->modList()->conflictFlagsSortKey(rightIndex);
   } break;
   case ModList::COL_CONTENT: {
     const auto& lContents = leftMod->getContents();
@@ -170,16 +137,10 @@ bool ModListSortProxy::lessThan(const QModelIndex& left, const QModelIndex& righ
       else if (rightMod->primaryCategory() < 0)
         lt = true;
       else {
-        try {
-          CategoryFactory& categories = CategoryFactory::instance();
-          QString leftCatName         = categories.getCategoryName(
-              categories.getCategoryIndex(leftMod->primaryCategory()));
-          QString rightCatName = categories.getCategoryName(
-              categories.getCategoryIndex(rightMod->primaryCategory()));
-          lt = leftCatName < rightCatName;
-        } catch (const std::exception& e) {
-          log::error("failed to compare categories: {}", e.what());
-        }
+        // the names are cached by the mod list, looking them up in the
+        // category factory for every comparison made sorting slow
+        lt = m_Organizer->modList()->categoryName(leftIndex) <
+             m_Organizer->modList()->categoryName(rightIndex);
       }
     }
   } break;
@@ -237,6 +198,7 @@ bool ModListSortProxy::lessThan(const QModelIndex& left, const QModelIndex& righ
 void ModListSortProxy::updateFilter(const QString& filter)
 {
   m_Filter = filter;
+  compileFilter();
   updateFilterActive();
   invalidateFilter();
   emit filterInvalidated();
@@ -433,91 +395,127 @@ bool ModListSortProxy::filterMatchesMod(ModInfo::Ptr info, bool enabled) const
     }
   }
 
-  if (!m_Filter.isEmpty()) {
-    bool display       = false;
-    QString filterCopy = QString(m_Filter);
-    filterCopy.replace("||", ";").replace("OR", ";").replace("|", ";");
-    QStringList ORList = filterCopy.split(";", Qt::SkipEmptyParts);
+  if (!m_Filter.isEmpty() && !filterTextMatchesMod(*info)) {
+    return false;
+  }
+
+  if (m_FilterMode == FilterAnd) {
+    return filterMatchesModAnd(info, enabled);
+  } else {
+    return filterMatchesModOr(info, enabled);
+  }
+}
+
+void ModListSortProxy::compileFilter()
+{
+  m_FilterSegments.clear();
 
-    bool segmentGood = true;
+  QString filterCopy = m_Filter;
+  filterCopy.replace("||", ";").replace("OR", ";").replace("|", ";");
 
-    // split in ORSegments that internally use AND logic
-    for (auto& ORSegment : ORList) {
-      QStringList ANDKeywords = ORSegment.split(" ", Qt::SkipEmptyParts);
-      segmentGood             = true;
-      bool foundKeyword       = false;
+  const auto& categories = CategoryFactory::instance();
 
-      // check each word in the segment for match, each word needs to be matched but it
-      // doesn't matter where.
-      for (auto& currentKeyword : ANDKeywords) {
-        foundKeyword = false;
+  // split in OR segments that internally use AND logic
+  for (auto& orSegment : filterCopy.split(";", Qt::SkipEmptyParts)) {
+    std::vector<Keyword> keywords;
 
-        // search keyword in name
-        if (m_EnabledColumns[ModList::COL_NAME] &&
-            info->name().contains(currentKeyword, Qt::CaseInsensitive)) {
-          foundKeyword = true;
-        }
+    for (auto& word : orSegment.split(" ", Qt::SkipEmptyParts)) {
+      Keyword k;
+      k.text = word.toCaseFolded();
 
-        // Search by notes
-        if (!foundKeyword && m_EnabledColumns[ModList::COL_NOTES] &&
-            info->comments().contains(currentKeyword, Qt::CaseInsensitive)) {
-          foundKeyword = true;
-        }
+      bool ok            = false;
+      const int filterID = word.toInt(&ok);
+      if (ok && filterID > 0) {
+        k.digits = QString::number(filterID);
+      }
 
-        // Search by categories
-        if (!foundKeyword && m_EnabledColumns[ModList::COL_CATEGORY]) {
-          for (auto category : info->categories()) {
-            if (category.contains(currentKeyword, Qt::CaseInsensitive)) {
-              foundKeyword = true;
-              break;
-            }
-          }
+      // a handful of categories, matched by id against each mod
+      for (std::size_t i = 0; i < categories.numCategories(); ++i) {
+        const auto ci = static_cast<unsigned int>(i);
+        if (categories.getCategoryName(ci).toCaseFolded().contains(k.text)) {
+          k.categories.push_back(categories.getCategoryID(ci));
         }
+      }
 
-        // Search by Nexus ID
-        if (!foundKeyword && m_EnabledColumns[ModList::COL_MODID]) {
-          bool ok;
-          int filterID = currentKeyword.toInt(&ok);
-          if (ok) {
-            int modID = info->nexusId();
-            while (modID > 0) {
-              if (modID == filterID) {
-                foundKeyword = true;
-                break;
-              }
-              modID = (int)(modID / 10);
-            }
-          }
-        }
+      std::sort(k.categories.begin(), k.categories.end());
+      keywords.push_back(std::move(k));
+    }
 
-        if (!foundKeyword) {
-          // currentKeword is missing from everything, AND fails and we need to check
-          // next ORsegment
-          segmentGood = false;
-          break;
-        }
+    // a segment without words, such as " ", matches everything
+    m_FilterSegments.push_back(std::move(keywords));
+  }
+}
+
+bool ModListSortProxy::filterTextMatchesMod(const ModInfo& info) const
+{
+  const auto& e = searchEntry(info);
 
-      }  // for ANDKeywords loop
+  auto matches = [&](const Keyword& k) {
+    if (m_EnabledColumns[ModList::COL_NAME] && e.foldedName.contains(k.text)) {
+      return true;
+    }
 
-      if (segmentGood) {
-        // the last AND loop didn't break so the ORSegments is true so mod matches
-        // filter
-        display = true;
-        break;
+    if (m_EnabledColumns[ModList::COL_NOTES] && e.foldedNotes.contains(k.text)) {
+      return true;
+    }
+
+    if (m_EnabledColumns[ModList::COL_CATEGORY]) {
+      for (int id : e.categories) {
+        if (std::binary_search(k.categories.begin(), k.categories.end(), id)) {
+          return true;
+        }
       }
+    }
 
-    }  // for ORList loop
+    // a keyword matches the id if it's a prefix of it
+    if (m_EnabledColumns[ModList::COL_MODID] && !k.digits.isEmpty() &&
+        e.modID.startsWith(k.digits)) {
+      return true;
+    }
 
-    if (!display) {
-      return false;
+    return false;
+  };
+
+  // each word in a segment must match, but it doesn't matter where
+  for (auto&& segment : m_FilterSegments) {
+    if (std::all_of(segment.begin(), segment.end(), matches)) {
+      return true;
     }
-  }  // if (!m_CurrentFilter.isEmpty())
+  }
 
-  if (m_FilterMode == FilterAnd) {
-    return filterMatchesModAnd(info, enabled);
-  } else {
-    return filterMatchesModOr(info, enabled);
+  return false;
+}
+
+const ModListSortProxy::SearchEntry&
+ModListSortProxy::searchEntry(const ModInfo& info) const
+{
+  auto& e = m_SearchIndex[&info];
+
+  const auto name  = info.name();
+  const auto notes = info.comments();
+  const int id     = info.nexusId();
+
+  // comparing is much cheaper than folding and the fields rarely change
+  if (e.built && e.name == name && e.notes == notes && e.nexusID == id &&
+      e.categories == info.getCategories()) {
+    return e;
   }
+
+  e.built       = true;
+  e.name        = name;
+  e.notes       = notes;
+  e.nexusID     = id;
+  e.categories  = info.getCategories();
+  e.foldedName  = name.toCaseFolded();
+  e.foldedNotes = notes.toCaseFolded();
+  e.modID       = (id > 0 ? QString::number(id) : QString());
+
+  return e;
+}
+
+void ModListSortProxy::clearSearchIndex()
+{
+  m_SearchIndex.clear();
 }
 
 void ModListSortProxy::setColumnVisible(int column, bool visible)
@@ -649,6 +647,15 @@ bool ModListSortProxy::dropMimeData(const QMimeData* data, Qt::DropAction action
 void ModListSortProxy::setSourceModel(QAbstractItemModel* sourceModel)
 {
   QSortFilterProxyModel::setSourceModel(sourceModel);
+  clearSearchIndex();
+
+  if (sourceModel) {
+    connect(sourceModel, &QAbstractItemModel::modelReset, this,
+            &ModListSortProxy::clearSearchIndex, Qt::UniqueConnection);
+    connect(sourceModel, &QAbstractItemModel::rowsRemoved, this,
+            &ModListSortProxy::clearSearchIndex, Qt::UniqueConnection);
+  }
+
   QAbstractProxyModel* proxy = qobject_cast<QAbstractProxyModel*>(sourceModel);
   if (proxy != nullptr) {
     sourceModel = proxy->sourceModel();
@@ -23,6 +23,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "modlist.h"
 #include <QSortFilterProxyModel>
 #include <bitset>
+#include <unordered_map>
 
 class Profile;
 class OrganizerCore;
@@ -128,13 +129,62 @@ protected:
   virtual bool filterAcceptsRow(int row, const QModelIndex& parent) const;
 
 private:
-  unsigned long flagsId(const std::vector<ModInfo::EFlag>& flags) const;
-  unsigned long conflictFlagsId(const std::vector<ModInfo::EConflictFlag>& flags) const;
   bool hasConflictFlag(const std::vector<ModInfo::EConflictFlag>& flags) const;
   void updateFilterActive();
   bool filterMatchesModAnd(ModInfo::Ptr info, bool enabled) const;
   bool filterMatchesModOr(ModInfo::Ptr info, bool enabled) const;
 
+  // one word of the filter text, see compileFilter()
+  //
+  struct Keyword
+  {
+    // case folded
+    QString text;
+
+    // the keyword as a positive number, matches mod ids starting with these
+    // digits; empty if the keyword is not a number
+    QString digits;
+
+    // sorted ids of the categories whose name contains the keyword
+    std::vector<int> categories;
+  };
+
+  // searchable fields of a mod, built the first time the mod is filtered and
+  // again only when one of them changes
+  //
+  struct SearchEntry
+  {
+    // false until the entry is first built
+    bool built = false;
+
+    // as given by the mod, to check if the entry is still valid
+    QString name;
+    QString notes;
+    int nexusID = 0;
+    std::set<int> categories;
+
+    // case folded
+    QString foldedName;
+    QString foldedNotes;
+
+    // empty if the mod has no id
+    QString modID;
+  };
+
+  // splits the filter text in segments separated by "|", "||" or "OR", each
+  // segment matching a mod if all its words do; this is done once when the
+  // text changes instead of for every row
+  //
+  void compileFilter();
+
+  // whether the compiled filter text matches the given mod
+  //
+  bool filterTextMatchesMod(const ModInfo& info) const;
+
+  // returns the search entry of the given mod, builds it if needed
+  //
+  const SearchEntry& searchEntry(const ModInfo& info) const;
+
   // check if the source model is the by-priority proxy
   //
   bool sourceIsByPriorityProxy() const;
@@ -144,12 +194,18 @@ private slots:
   void aboutToChangeData();
   void postDataChanged();
 
+  // forgets the search entries of all mods, called when mods are removed or
+  // recreated so entries of deleted mods don't stay around
+  void clearSearchIndex();
+
 private:
   OrganizerCore* m_Organizer;
 
   Profile* m_Profile;
   std::vector<Criteria> m_Criteria;
   QString m_Filter;
+  std::vector<std::vector<Keyword>> m_FilterSegments;
+  mutable std::unordered_map<const ModInfo*, SearchEntry> m_SearchIndex;
   std::bitset<ModList::COL_LASTCOLUMN + 1> m_EnabledColumns;
 
   bool m_FilterActive;
@@ -0,0 +1,272 @@
+#include "modmetaindex.h"
+#include "settings.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
+#include <log.h>
+
+using namespace MOBase;
+
+namespace
+{
+
+constexpr std::uint32_t IndexMagic = 0x4d4d4f4d;  // "MOMM"
+
+}  // namespace
+
+ModMeta ModMeta::read(const QString& path)
+{
+  ModMeta m;
+
+  if (!QFileInfo::exists(path)) {
+    return m;
+  }
+
+  QSettings ini(path, QSettings::IniFormat);
+
+  for (auto&& key : ini.allKeys()) {
+    m.m_values.insert(key, ini.value(key));
+  }
+
+  return m;
+}
+
+bool ModMeta::contains(const QString& key) const
+{
+  return (find(key) != m_values.cend());
+}
+
+QVariant ModMeta::value(const QString& key, const QVariant& def) const
+{
+  auto itor = find(key);
+  if (itor == m_values.cend()) {
+    return def;
+  }
+
+  return *itor;
+}
+
+int ModMeta::arraySize(const QString& array) const
+{
+  return value(array + "/size", 0).toInt();
+}
+
+QVariant ModMeta::arrayValue(const QString& array, int i, const QString& key) const
+{
+  // QSettings numbers elements from 1 in the file
+  return value(array + "/" + QString::number(i + 1) + "/" + key);
+}
+
+std::map<QString, std::map<QString, QVariant>>
+ModMeta::subgroups(const QString& group) const
+{
+  std::map<QString, std::map<QString, QVariant>> groups;
+  const QString prefix = group + "/";
+
+  for (auto itor = m_values.cbegin(); itor != m_values.cend(); ++itor) {
+    if (!itor.key().startsWith(prefix, Qt::CaseInsensitive)) {
+      continue;
+    }
+
+    // only "group/subgroup/key"
+    const auto rest = itor.key().mid(prefix.size());
+    const auto sep  = rest.indexOf('/');
+
+    if (sep < 0 || rest.indexOf('/', sep + 1) >= 0) {
+      continue;
+    }
+
+    groups[rest.left(sep)][rest.mid(sep + 1)] = *itor;
+  }
+
+  return groups;
+}
+
+QVariantMap::const_iterator ModMeta::find(const QString& key) const
+{
+  auto itor = m_values.constFind(key);
+  if (itor != m_values.cend()) {
+    return itor;
+  }
+
+  // keys in ini files are case-insensitive for QSettings
+  for (itor = m_values.cbegin(); itor != m_values.cend(); ++itor) {
+    if (itor.key().compare(key, Qt::CaseInsensitive) == 0) {
+      return itor;
+    }
+  }
+
+  return m_values.cend();
+}
+
+QDataStream& operator<<(QDataStream& s, const ModMeta& m)
+{
+  return s << m.m_values;
+}
+
+QDataStream& operator>>(QDataStream& s, ModMeta& m)
+{
+  return s >> m.m_values;
+}
+
+ModMetaIndex::ModMetaIndex() : m_Hits(0), m_Misses(0) {}
+
+QString ModMetaIndex::defaultPath()
+{
+  return Settings::instance().paths().cache() + "/meta.cache";
+}
+
+bool ModMetaIndex::load(const QString& path)
+{
+  std::scoped_lock lock(m_Mutex);
+
+  m_Path = path;
+  m_Entries.clear();
+  m_Hits   = 0;
+  m_Misses = 0;
+
+  QFile file(path);
+
+  if (!file.exists()) {
+    log::debug("no mod meta index at '{}'", path);
+    return false;
+  }
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    log::warn("can't open mod meta index '{}': {}", path, file.errorString());
+    return false;
+  }
+
+  QDataStream s(&file);
+
+  std::uint32_t magic = 0, version = 0;
+  s >> magic >> version;
+
+  if (magic != IndexMagic || version != Version) {
+    log::debug("mod meta index '{}' is invalid or from another version, ignoring",
+               path);
+
+    return false;
+  }
+
+  quint32 count = 0;
+  s >> count;
+
+  Entries entries;
+  entries.reserve(static_cast<int>(count));
+
+  for (quint32 i = 0; i < count; ++i) {
+    QString key;
+    Entry e;
+
+    s >> key >> e.size >> e.time >> e.meta;
+    entries.insert(key, std::move(e));
+  }
+
+  if (s.status() != QDataStream::Ok) {
+    log::warn("mod meta index '{}' is corrupted, ignoring", path);
+    return false;
+  }
+
+  m_Entries = std::move(entries);
+  log::debug("loaded {} mod meta files from '{}'", m_Entries.size(), path);
+
+  return true;
+}
+
+QString ModMetaIndex::path() const
+{
+  std::scoped_lock lock(m_Mutex);
+  return m_Path;
+}
+
+ModMeta ModMetaIndex::get(const QString& iniPath)
+{
+  const QFileInfo fi(iniPath);
+  const auto key = iniPath.toLower();
+
+  if (!fi.exists()) {
+    // mods without a meta.ini are common and cheap, they're not indexed
+    std::scoped_lock lock(m_Mutex);
+    m_Entries.remove(key);
+    return {};
+  }
+
+  return get(iniPath, fi.size(), fi.lastModified().toMSecsSinceEpoch());
+}
+
+ModMeta ModMetaIndex::get(const QString& iniPath, qint64 size, qint64 time)
+{
+  const auto key = iniPath.toLower();
+
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    auto itor = m_Entries.constFind(key);
+    if (itor != m_Entries.constEnd() && itor->size == size && itor->time == time) {
+      ++m_Hits;
+      return itor->meta;
+    }
+  }
+
+  // parsed outside the lock, this is what runs in parallel
+  Entry e;
+  e.size = size;
+  e.time = time;
+  e.meta = ModMeta::read(iniPath);
+
+  std::scoped_lock lock(m_Mutex);
+  ++m_Misses;
+  m_Entries.insert(key, e);
+
+  return e.meta;
+}
+
+bool ModMetaIndex::save(const QString& path)
+{
+  std::scoped_lock lock(m_Mutex);
+
+  if (m_Misses == 0) {
+    m_Hits = 0;
+    return true;
+  }
+
+  for (auto itor = m_Entries.begin(); itor != m_Entries.end();) {
+    if (!QFileInfo::exists(itor.key())) {
+      itor = m_Entries.erase(itor);
+    } else {
+      ++itor;
+    }
+  }
+
+  QSaveFile file(path);
+
+  if (!file.open(QIODevice::WriteOnly)) {
+    log::warn("can't write mod meta index '{}': {}", path, file.errorString());
+    return false;
+  }
+
+  QDataStream s(&file);
+
+  s << IndexMagic << Version << static_cast<quint32>(m_Entries.size());
+
+  for (auto itor = m_Entries.cbegin(); itor != m_Entries.cend(); ++itor) {
+    s << itor.key() << itor->size << itor->time << itor->meta;
+  }
+
+  if (!file.commit()) {
+    log::warn("can't write mod meta index '{}': {}", path, file.errorString());
+    return false;
+  }
+
+  log::debug("mod meta files: {} from index, {} parsed, {} saved to '{}'", m_Hits,
+             m_Misses, m_Entries.size(), path);
+
+  m_Hits   = 0;
+  m_Misses = 0;
+
+  return true;
+}
@@ -0,0 +1,123 @@
+#ifndef MODORGANIZER_MODMETAINDEX_INCLUDED
+#define MODORGANIZER_MODMETAINDEX_INCLUDED
+
+#include <QDataStream>
+#include <QHash>
+#include <QString>
+#include <QVariantMap>
+#include <cstdint>
+#include <map>
+#include <mutex>
+
+// contents of a meta.ini file, as returned by QSettings
+//
+// keys are the full paths given by QSettings::allKeys(), such as
+// "installedFiles/1/modid"; lookups fall back to a case-insensitive match like
+// QSettings does for ini files
+//
+class ModMeta
+{
+public:
+  // parses the given ini file, returns an empty ModMeta if it doesn't exist
+  //
+  static ModMeta read(const QString& path);
+
+  bool contains(const QString& key) const;
+  QVariant value(const QString& key, const QVariant& def = {}) const;
+
+  // number of elements in an array written by QSettings::beginWriteArray()
+  //
+  int arraySize(const QString& array) const;
+
+  // value of `key` in the element `i` of the given array, 0-based like
+  // QSettings::setArrayIndex()
+  //
+  QVariant arrayValue(const QString& array, int i, const QString& key) const;
+
+  // keys of each group directly under `group`, by group name; keys in deeper
+  // groups are ignored, like QSettings::childKeys()
+  //
+  std::map<QString, std::map<QString, QVariant>> subgroups(const QString& group) const;
+
+  friend QDataStream& operator<<(QDataStream& s, const ModMeta& m);
+  friend QDataStream& operator>>(QDataStream& s, ModMeta& m);
+
+private:
+  QVariantMap m_values;
+
+  QVariantMap::const_iterator find(const QString& key) const;
+};
+
+// persistent index of the meta.ini files of all mods, keyed by path and
+// validated with the size and last modification time of the file
+//
+// creating the mods on startup used to parse every meta.ini through
+// QSettings, which takes seconds with thousands of mods; most of them don't
+// change between sessions, so their contents are taken from here instead
+//
+// this works like PluginHeaderCache: load() once, get() from any thread and
+// save() after a refresh
+//
+// the download manager has its own index for the .meta files of downloads,
+// which are ini files too
+//
+class ModMetaIndex
+{
+public:
+  // bumped every time the on-disk format changes, indices with a different
+  // version are ignored
+  static constexpr std::uint32_t Version = 1;
+
+  ModMetaIndex();
+
+  // noncopyable
+  ModMetaIndex(const ModMetaIndex&)            = delete;
+  ModMetaIndex& operator=(const ModMetaIndex&) = delete;
+
+  // default location of the index for the current instance
+  //
+  static QString defaultPath();
+
+  // reads the given index file; returns false if it doesn't exist or is
+  // invalid, in which case all meta.ini files will be parsed
+  //
+  bool load(const QString& path);
+
+  // path given to the last load(), regardless of whether it succeeded; empty
+  // if load() was never called
+  //
+  QString path() const;
+
+  // returns the contents of the given meta.ini, parsing it if it's not in the
+  // index or if its size or time have changed
+  //
+  ModMeta get(const QString& iniPath);
+
+  // same as above, but with a size and time that are already known, such as
+  // from a directory listing; `time` is in milliseconds since the epoch
+  //
+  ModMeta get(const QString& iniPath, qint64 size, qint64 time);
+
+  // writes the index to the given file if any meta.ini was parsed since the
+  // last load() or save(), does nothing otherwise
+  //
+  bool save(const QString& path);
+
+private:
+  struct Entry
+  {
+    qint64 size = 0;
+    qint64 time = 0;
+    ModMeta meta;
+  };
+
+  using Entries = QHash<QString, Entry>;
+
+  mutable std::mutex m_Mutex;
+  QString m_Path;
+  Entries m_Entries;
+  std::size_t m_Hits;
+  std::size_t m_Misses;
+};
+
+#endif  // MODORGANIZER_MODMETAINDEX_INCLUDED
@@ -1,4 +1,5 @@
 #include "organizercore.h"
+#include "changejournal.h"
 #include "credentialsdialog.h"
 #include "delayedfilewriter.h"
 #include "directoryrefresher.h"
@@ -20,6 +21,7 @@
 #include "plugincontainer.h"
 #include "previewdialog.h"
 #include "profile.h"
+#include "refreshprofiler.h"
 #include "shared/appconfig.h"
 #include "shared/directoryentry.h"
 #include "shared/fileentry.h"
@@ -93,6 +95,7 @@ OrganizerCore::OrganizerCore(Settings& settings)
       m_ModList(m_PluginContainer, this), m_PluginList(*this),
       m_DirectoryRefresher(new DirectoryRefresher(settings.refreshThreadCount())),
       m_DirectoryStructure(new DirectoryEntry(L"data", nullptr, 0)),
+      m_ChangeJournal(new ChangeJournal(this)),
       m_VirtualFileTree([this]() {
         return VirtualFileTree::makeTree(m_DirectoryStructure);
       }),
@@ -112,6 +115,8 @@ OrganizerCore::OrganizerCore(Settings& settings)
           SLOT(downloadSpeed(QString, int)));
   connect(m_DirectoryRefresher.get(), SIGNAL(refreshed()), this,
           SLOT(directory_refreshed()));
+  connect(m_ChangeJournal.get(), &ChangeJournal::changed, this,
+          &OrganizerCore::applyFileChanges);
 
   connect(&m_ModList, SIGNAL(removeOrigin(QString)), this, SLOT(removeOrigin(QString)));
   connect(&m_ModList, &ModList::modStatesChanged, [=] {
@@ -159,6 +164,8 @@ OrganizerCore::OrganizerCore(Settings& settings)
 
 OrganizerCore::~OrganizerCore()
 {
+  m_ChangeJournal->stop();
+
   m_RefresherThread.exit();
   m_RefresherThread.wait();
 
@@ -1198,7 +1205,7 @@ void OrganizerCore::refresh(bool saveChanges)
   refreshDirectoryStructure();
 }
 
-void OrganizerCore::refreshESPList(bool force)
+void OrganizerCore::refreshESPList(bool force, const QStringList& outdated)
 {
   TimeThis tt("OrganizerCore::refreshESPList()");
 
@@ -1206,7 +1213,7 @@ void OrganizerCore::refreshESPList(bool force)
     // don't mess up the esp list if we're currently updating the directory
     // structure
     m_PostRefreshTasks.append([=]() {
-      this->refreshESPList(force);
+      this->refreshESPList(force, outdated);
     });
     return;
   }
@@ -1215,7 +1222,7 @@ void OrganizerCore::refreshESPList(bool force)
   // clear list
   try {
     m_PluginList.refresh(m_CurrentProfile->name(), *m_DirectoryStructure,
-                         m_CurrentProfile->getLockedOrderFileName(), force);
+                         m_CurrentProfile->getLockedOrderFileName(), force, outdated);
   } catch (const std::exception& e) {
     reportError(tr("Failed to refresh list of esps: %1").arg(e.what()));
   }
@@ -1275,55 +1282,61 @@ void OrganizerCore::updateModActiveState(int index, bool active)
 void OrganizerCore::updateModsActiveState(const QList<unsigned int>& modIndices,
                                           bool active)
 {
-  int enabled = 0;
+  updatePluginsActiveState(findModPlugins(modIndices), active);
+}
+
+OrganizerCore::ModPlugins
+OrganizerCore::findModPlugins(const QList<unsigned int>& modIndices) const
+{
+  ModPlugins plugins;
+
   for (auto index : modIndices) {
     ModInfo::Ptr modInfo = ModInfo::getByIndex(index);
     QDir dir(modInfo->absolutePath());
-    for (const QString& esm : dir.entryList(QStringList() << "*.esm", QDir::Files)) {
-      const FileEntryPtr file = m_DirectoryStructure->findFile(ToWString(esm));
-      if (file.get() == nullptr) {
-        log::warn("failed to activate {}", esm);
-        continue;
-      }
 
-      if (active != m_PluginList.isEnabled(esm) && file->getAlternatives().empty()) {
-        m_PluginList.blockSignals(true);
-        m_PluginList.enableESP(esm, active);
-        m_PluginList.blockSignals(false);
+    for (QString& name : dir.entryList({"*.esm", "*.esl", "*.esp"}, QDir::Files)) {
+      if (name.endsWith(".esm", Qt::CaseInsensitive)) {
+        plugins.masters.append(std::move(name));
+      } else if (name.endsWith(".esl", Qt::CaseInsensitive)) {
+        plugins.light.append(std::move(name));
+      } else {
+        plugins.regular.append(std::move(name));
       }
     }
+  }
 
-    for (const QString& esl : dir.entryList(QStringList() << "*.esl", QDir::Files)) {
-      const FileEntryPtr file = m_DirectoryStructure->findFile(ToWString(esl));
-      if (file.get() == nullptr) {
-        log::warn("failed to activate {}", esl);
-        continue;
-      }
+  return plugins;
+}
 
-      if (active != m_PluginList.isEnabled(esl) && file->getAlternatives().empty()) {
-        m_PluginList.blockSignals(true);
-        m_PluginList.enableESP(esl, active);
-        m_PluginList.blockSignals(false);
-        ++enabled;
-      }
-    }
-    QStringList esps = dir.entryList(QStringList() << "*.esp", QDir::Files);
-    for (const QString& esp : esps) {
-      const FileEntryPtr file = m_DirectoryStructure->findFile(ToWString(esp));
+void OrganizerCore::updatePluginsActiveState(const ModPlugins& plugins, bool active)
+{
+  // plugins that are not provided by any other mod
+  auto filter = [&](const QStringList& names) {
+    QStringList out;
+
+    for (const QString& name : names) {
+      const FileEntryPtr file = m_DirectoryStructure->findFile(ToWString(name));
       if (file.get() == nullptr) {
-        log::warn("failed to activate {}", esp);
+        log::warn("failed to activate {}", name);
         continue;
       }
 
-      if (active != m_PluginList.isEnabled(esp) && file->getAlternatives().empty()) {
-        m_PluginList.blockSignals(true);
-        m_PluginList.enableESP(esp, active);
-        m_PluginList.blockSignals(false);
-        ++enabled;
+      if (active != m_PluginList.isEnabled(name) && file->getAlternatives().empty()) {
+        out.append(name);
       }
     }
-  }
-  if (active && (enabled > 1)) {
+
+    return out;
+  };
+
+  const QStringList masters = filter(plugins.masters);
+  const QStringList others  = filter(plugins.light) + filter(plugins.regular);
+
+  m_PluginList.blockSignals(true);
+  m_PluginList.enableESPs(masters + others, active);
+  m_PluginList.blockSignals(false);
+
+  if (active && (others.size() > 1)) {
     MessageDialog::showMessage(
         tr("Multiple esps/esls activated, please check that they don't conflict."),
         qApp->activeWindow());
@@ -1357,12 +1370,16 @@ void OrganizerCore::updateModsInDirectoryStructure(
   m_DirectoryRefresher->addMultipleModsFilesToStructure(m_DirectoryStructure, entries);
 
   DirectoryRefresher::cleanStructure(m_DirectoryStructure);
-  // need to refresh plugin list now so we can activate esps
-  refreshESPList(true);
+
+  // need to refresh plugin list now so we can activate esps; only the plugins
+  // of these mods can be new or come from another mod now
+  const auto plugins = findModPlugins(modInfo.keys());
+  refreshESPList(false, plugins.all());
+
   // activate all esps of the specified mod so the bsas get activated along with
   // it
   m_PluginList.blockSignals(true);
-  updateModsActiveState(modInfo.keys(), true);
+  updatePluginsActiveState(plugins, true);
   m_PluginList.blockSignals(false);
   // now we need to refresh the bsa list and save it so there is no confusion
   // about what archives are available and active
@@ -1519,7 +1536,9 @@ void OrganizerCore::directory_refreshed()
   }
 
   std::swap(m_DirectoryStructure, newStructure);
+  m_ConflictIndex = m_DirectoryRefresher->stealConflictIndex();
   m_VirtualFileTree.invalidate();
+  m_MappingPlanner.invalidate();
 
   if (m_StructureDeleter.joinable()) {
     m_StructureDeleter.join();
@@ -1539,6 +1558,8 @@ void OrganizerCore::directory_refreshed()
     modInfo->clearCaches();
   }
 
+  m_ModList.invalidateFlags(-1);
+
   if (!m_PostRefreshTasks.empty()) {
     log::debug("running {} post refresh tasks", m_PostRefreshTasks.size());
 
@@ -1554,141 +1575,271 @@ void OrganizerCore::directory_refreshed()
     refreshLists();
   }
 
+  // started by the refresher if profiling is enabled
+  RefreshProfiler::instance().finish(m_Settings.diagnostics().refreshProfilePath());
+
   emit directoryStructureReady();
 
+  // changes made while refreshing may or may not be in the new structure,
+  // they're applied again since that only looks at what's on disk
+  m_ChangeJournal->start(m_Settings.paths().mods(),
+                         m_Settings.paths().overwrite(),
+                         ModInfo::getOverwrite()->name());
+
+  applyFileChanges();
+
   log::debug("refresh done");
 }
 
+// whether the given path, relative to a mod, can change the plugin or archive
+// lists, which only contain files at the root of mods
+//
+static bool affectsLists(const std::wstring& path)
+{
+  if (path.find_first_of(L"\\/") != std::wstring::npos) {
+    return false;
+  }
+
+  const auto name = QString::fromStdWString(path);
+
+  for (const auto* ext : {".esp", ".esm", ".esl", ".bsa", ".ba2"}) {
+    if (name.endsWith(ext, Qt::CaseInsensitive)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void OrganizerCore::applyFileChanges()
+{
+  if (m_DirectoryUpdate) {
+    // changes are kept and applied when the refresh is done
+    return;
+  }
+
+  auto changes = m_ChangeJournal->takeChanges();
+  if (changes.empty()) {
+    return;
+  }
+
+  if (changes.rescanAll) {
+    log::debug("changes in the mods directory were lost, refreshing");
+    refreshDirectoryStructure();
+    return;
+  }
+
+  TimeThis tt("OrganizerCore::applyFileChanges()");
+
+  DirectoryStats stats;
+  std::set<FileIndex> files;
+  std::set<unsigned int> mods;
+  bool listsChanged = false;
+
+  for (auto&& [name, mc] : changes.mods) {
+    const auto index = ModInfo::getIndex(name);
+    const auto wname = ToWString(name);
+
+    // mods that are not active have no origin, or a disabled one
+    if (index == UINT_MAX || !m_DirectoryStructure->originExists(wname)) {
+      continue;
+    }
+
+    FilesOrigin& origin = m_DirectoryStructure->getOriginByName(wname);
+    if (origin.isDisabled()) {
+      continue;
+    }
+
+    if (mc.rescan) {
+      log::debug("rescanning mod '{}'", name);
+      m_DirectoryStructure->updateFromOrigin(origin, L"", files, stats);
+      listsChanged = true;
+    } else {
+      for (auto&& path : mc.paths) {
+        m_DirectoryStructure->updateFromOrigin(origin, path, files, stats);
+        listsChanged = listsChanged || affectsLists(path);
+      }
+    }
+
+    mods.insert(index);
+  }
+
+  if (mods.empty()) {
+    return;
+  }
+
+  log::debug("{} files changed on disk in {} mods", files.size(), mods.size());
+
+  DirectoryRefresher::cleanStructure(m_DirectoryStructure);
+  m_VirtualFileTree.invalidate();
+  m_MappingPlanner.invalidate();
+
+  const QList<unsigned int> indices(mods.begin(), mods.end());
+
+  if (listsChanged) {
+    refreshLists();
+  }
+
+  updateFileOrigins(files, std::move(mods));
+  m_ModList.notifyModStateChanged(indices);
+}
+
 void OrganizerCore::profileRefresh()
 {
   refresh();
 }
 
-void OrganizerCore::clearCaches(std::vector<unsigned int> const& indices) const
+void OrganizerCore::updateFileOrigins(const std::set<FileIndex>& files,
+                                      std::set<unsigned int> mods)
 {
-  const auto insert = [](auto& dest, const auto& from) {
-    dest.insert(from.begin(), from.end());
-  };
-  std::set<unsigned int> allIndices;
-  for (const auto index : indices) {
-    ModInfo::Ptr modInfo = ModInfo::getByIndex(index);
+  auto fileRegister = m_DirectoryStructure->getFileRegister();
 
-    if (m_CurrentProfile->modEnabled(index)) {
-      // if the mod is enabled, we need to first clear its cache so that
-      // getModOverwrite(), ..., returns the newly conflicting mods (in case
-      // the mod just got enabled)
-      modInfo->clearCaches();
-      insert(allIndices, modInfo->getModOverwrite());
-      insert(allIndices, modInfo->getModOverwritten());
-      insert(allIndices, modInfo->getModArchiveOverwrite());
-      insert(allIndices, modInfo->getModArchiveOverwritten());
-      insert(allIndices, modInfo->getModArchiveLooseOverwrite());
-      insert(allIndices, modInfo->getModArchiveLooseOverwritten());
-    } else {
-      // if the mod is disabled, we need to first fetch the conflicting
-      // mods, and then clear the cache
-      insert(allIndices, modInfo->getModOverwrite());
-      insert(allIndices, modInfo->getModOverwritten());
-      insert(allIndices, modInfo->getModArchiveOverwrite());
-      insert(allIndices, modInfo->getModArchiveOverwritten());
-      insert(allIndices, modInfo->getModArchiveLooseOverwrite());
-      insert(allIndices, modInfo->getModArchiveLooseOverwritten());
-      modInfo->clearCaches();
+  fileRegister->sortOrigins(files);
+  m_MappingPlanner.invalidate();
+
+  // every mod providing one of these files may have a different conflict
+  // state now
+  std::set<OriginID> origins = fileRegister->getOrigins(files);
+
+  for (const OriginID id : origins) {
+    if (const auto* origin = m_DirectoryStructure->findOriginByID(id)) {
+      const auto index = ModInfo::getIndex(ToQString(origin->getName()));
+      if (index != UINT_MAX) {
+        mods.insert(index);
+      }
     }
   }
 
-  for (auto& index : allIndices) {
+  for (const auto index : mods) {
+    auto modInfo    = ModInfo::getByIndex(index);
+    const auto name = ToWString(modInfo->internalName());
+
+    if (m_DirectoryStructure->originExists(name)) {
+      origins.insert(m_DirectoryStructure->getOriginByName(name).getID());
+    }
+  }
+
+  if (m_ConflictIndex) {
+    m_ConflictIndex->invalidate(origins);
+  }
+
+  for (const auto index : mods) {
     ModInfo::getByIndex(index)->clearCaches();
+    m_ModList.invalidateFlags(static_cast<int>(index));
   }
 }
 
 void OrganizerCore::modPrioritiesChanged(const QModelIndexList& indices)
 {
+  // only the origins of mods that were moved or shifted by the move have a
+  // different priority
   for (unsigned int i = 0; i < currentProfile()->numMods(); ++i) {
-    int priority = currentProfile()->getModPriority(i);
-    if (currentProfile()->modEnabled(i)) {
-      ModInfo::Ptr modInfo = ModInfo::getByIndex(i);
-      // priorities in the directory structure are one higher because data is 0
-      directoryStructure()
-          ->getOriginByName(MOBase::ToWString(modInfo->internalName()))
-          .setPriority(priority + 1);
+    if (!currentProfile()->modEnabled(i)) {
+      continue;
+    }
+
+    const auto name = ToWString(ModInfo::getByIndex(i)->internalName());
+    if (!m_DirectoryStructure->originExists(name)) {
+      continue;
+    }
+
+    // priorities in the directory structure are one higher because data is 0
+    const int priority = currentProfile()->getModPriority(i) + 1;
+    auto& origin       = m_DirectoryStructure->getOriginByName(name);
+
+    if (origin.getPriority() != priority) {
+      origin.setPriority(priority);
     }
   }
+
   refreshBSAList();
   currentProfile()->writeModlist();
-  directoryStructure()->getFileRegister()->sortOrigins();
 
-  std::vector<unsigned int> vindices;
+  // the relative order of the mods that were not moved hasn't changed, so only
+  // files from the moved mods can have a different order of origins
+  std::set<FileIndex> files;
+  std::set<unsigned int> mods;
 
   for (auto& idx : indices) {
-    vindices.push_back(idx.data(ModList::IndexRole).toInt());
-  }
+    const auto index = idx.data(ModList::IndexRole).toInt();
+    const auto name  = ToWString(ModInfo::getByIndex(index)->internalName());
 
-  clearCaches(vindices);
-}
+    mods.insert(index);
 
-void OrganizerCore::modStatusChanged(unsigned int index)
-{
-  try {
-    ModInfo::Ptr modInfo = ModInfo::getByIndex(index);
-    if (m_CurrentProfile->modEnabled(index)) {
-      updateModInDirectoryStructure(index, modInfo);
-    } else {
-      updateModActiveState(index, false);
-      if (m_DirectoryStructure->originExists(ToWString(modInfo->name()))) {
-        FilesOrigin& origin =
-            m_DirectoryStructure->getOriginByName(ToWString(modInfo->name()));
-        origin.enable(false);
-      }
-      if (m_UserInterface != nullptr) {
-        m_UserInterface->archivesWriter().write();
-      }
-    }
+    if (m_DirectoryStructure->originExists(name)) {
+      const auto originFiles =
+          m_DirectoryStructure->getOriginByName(name).getFileIndices();
 
-    for (unsigned int i = 0; i < m_CurrentProfile->numMods(); ++i) {
-      ModInfo::Ptr modInfo = ModInfo::getByIndex(i);
-      int priority         = m_CurrentProfile->getModPriority(i);
-      if (m_DirectoryStructure->originExists(ToWString(modInfo->name()))) {
-        // priorities in the directory structure are one higher because data is
-        // 0
-        m_DirectoryStructure->getOriginByName(ToWString(modInfo->name()))
-            .setPriority(priority + 1);
-      }
+      files.insert(originFiles.begin(), originFiles.end());
     }
-    m_DirectoryStructure->getFileRegister()->sortOrigins();
+  }
 
-    refreshLists();
-    clearCaches({index});
-    m_ModList.notifyModStateChanged({index});
+  updateFileOrigins(files, std::move(mods));
+}
 
-  } catch (const std::exception& e) {
-    reportError(tr("failed to update mod list: %1").arg(e.what()));
-  }
+void OrganizerCore::modStatusChanged(unsigned int index)
+{
+  modStatusChanged(QList<unsigned int>{index});
 }
 
 void OrganizerCore::modStatusChanged(QList<unsigned int> index)
 {
+  if (m_DirectoryUpdate) {
+    // the structure is updated in place with the refresher's task pool, which
+    // is busy; the refresh started with the old list of mods so the change is
+    // applied once it's done
+    m_PostRefreshTasks.append([=]() {
+      this->modStatusChanged(index);
+    });
+    return;
+  }
+
   try {
     QMap<unsigned int, ModInfo::Ptr> modsToEnable;
     QMap<unsigned int, ModInfo::Ptr> modsToDisable;
-    std::vector<unsigned int> vindices;
     for (auto idx : index) {
       if (m_CurrentProfile->modEnabled(idx)) {
         modsToEnable[idx] = ModInfo::getByIndex(idx);
       } else {
         modsToDisable[idx] = ModInfo::getByIndex(idx);
       }
-      vindices.push_back(idx);
     }
+
+    // files that gained or lost an origin, the rest of the structure is
+    // left untouched
+    std::set<FileIndex> files;
+
     if (!modsToEnable.isEmpty()) {
       updateModsInDirectoryStructure(modsToEnable);
+
+      for (auto idx : modsToEnable.keys()) {
+        const auto name = ToWString(modsToEnable[idx]->name());
+
+        if (m_DirectoryStructure->originExists(name)) {
+          FilesOrigin& origin = m_DirectoryStructure->getOriginByName(name);
+
+          // the origin may have been created before the mod was moved while
+          // disabled; priorities in the directory structure are one higher
+          // because data is 0
+          origin.setPriority(m_CurrentProfile->getModPriority(idx) + 1);
+
+          const auto originFiles = origin.getFileIndices();
+          files.insert(originFiles.begin(), originFiles.end());
+        }
+      }
     }
     if (!modsToDisable.isEmpty()) {
       updateModsActiveState(modsToDisable.keys(), false);
       for (auto idx : modsToDisable.keys()) {
-        if (m_DirectoryStructure->originExists(ToWString(modsToDisable[idx]->name()))) {
-          FilesOrigin& origin = m_DirectoryStructure->getOriginByName(
-              ToWString(modsToDisable[idx]->name()));
+        const auto name = ToWString(modsToDisable[idx]->name());
+
+        if (m_DirectoryStructure->originExists(name)) {
+          FilesOrigin& origin = m_DirectoryStructure->getOriginByName(name);
+
+          // must be fetched before disabling, which forgets the files
+          const auto originFiles = origin.getFileIndices();
+          files.insert(originFiles.begin(), originFiles.end());
+
           origin.enable(false);
         }
       }
@@ -1697,20 +1848,8 @@ void OrganizerCore::modStatusChanged(QList<unsigned int> index)
       }
     }
 
-    for (unsigned int i = 0; i < m_CurrentProfile->numMods(); ++i) {
-      ModInfo::Ptr modInfo = ModInfo::getByIndex(i);
-      int priority         = m_CurrentProfile->getModPriority(i);
-      if (m_DirectoryStructure->originExists(ToWString(modInfo->name()))) {
-        // priorities in the directory structure are one higher because data is
-        // 0
-        m_DirectoryStructure->getOriginByName(ToWString(modInfo->name()))
-            .setPriority(priority + 1);
-      }
-    }
-    m_DirectoryStructure->getFileRegister()->sortOrigins();
-
     refreshLists();
-    clearCaches(vindices);
+    updateFileOrigins(files, std::set<unsigned int>(index.begin(), index.end()));
     m_ModList.notifyModStateChanged(index);
 
   } catch (const std::exception& e) {
@@ -1993,6 +2132,27 @@ std::vector<Mapping> OrganizerCore::fileMapping(const QString& profileName,
   MappingType result;
 
   QString dataPath = QDir::toNativeSeparators(game->dataDirectory().absolutePath());
+  const auto overwritePath = QDir::toNativeSeparators(m_Settings.paths().overwrite());
+
+  // the directory structure is only for the current profile, mod folders of
+  // other profiles are linked as a whole; so is a custom write target, because
+  // it must be linked in its place in the mod order to create files
+  bool planned =
+      (m_CurrentProfile != nullptr && m_CurrentProfile->name() == profileName &&
+       customOverwrite.isEmpty());
+
+  if (planned) {
+    // the plan only links the files that are in the structure, so pending
+    // changes are applied first; when changes may have been missed, the
+    // structure could lack files that are on disk and mod folders are linked
+    // as a whole instead
+    applyFileChanges();
+
+    if (m_DirectoryUpdate || !m_ChangeJournal->complete()) {
+      log::debug("directory structure may be out of date, linking whole mods");
+      planned = false;
+    }
+  }
 
   bool overwriteActive = false;
 
@@ -2008,7 +2168,7 @@ std::vector<Mapping> OrganizerCore::fileMapping(const QString& profileName,
 
     overwriteActive |= createTarget;
 
-    if (modPtr->isRegular()) {
+    if (!planned && modPtr->isRegular()) {
       result.insert(result.end(), {QDir::toNativeSeparators(std::get<1>(mod)), dataPath,
                                    true, createTarget});
     }
@@ -2019,6 +2179,14 @@ std::vector<Mapping> OrganizerCore::fileMapping(const QString& profileName,
         tr("The designated write target \"%1\" is not enabled.").arg(customOverwrite));
   }
 
+  if (planned) {
+    // the plan doesn't create anything, overwrite is still linked last below
+    const auto& plan =
+        m_MappingPlanner.mappings(*m_DirectoryStructure, profileName, dataPath);
+
+    result.insert(result.end(), plan.begin(), plan.end());
+  }
+
   if (m_CurrentProfile->localSavesEnabled()) {
     LocalSavegames* localSaves = game->feature<LocalSavegames>();
     if (localSaves != nullptr) {
@@ -2031,8 +2199,10 @@ std::vector<Mapping> OrganizerCore::fileMapping(const QString& profileName,
     }
   }
 
-  result.insert(result.end(), {QDir::toNativeSeparators(m_Settings.paths().overwrite()),
-                               dataPath, true, customOverwrite.isEmpty()});
+  // linked last so new files go to overwrite, including in directories that
+  // are linked by the plan
+  result.insert(result.end(),
+                {overwritePath, dataPath, true, customOverwrite.isEmpty()});
 
   for (MOBase::IPluginFileMapper* mapper :
        m_PluginContainer->plugins<MOBase::IPluginFileMapper>()) {
@@ -2046,47 +2216,3 @@ std::vector<Mapping> OrganizerCore::fileMapping(const QString& profileName,
 
   return result;
 }
-
-std::vector<Mapping> OrganizerCore::fileMapping(const QString& dataPath,
-                                                const QString& relPath,
-                                                const DirectoryEntry* base,
-                                                const DirectoryEntry* directoryEntry,
-                                                int createDestination)
-{
-  std::vector<Mapping> result;
-
-  for (FileEntryPtr current : directoryEntry->getFiles()) {
-    bool isArchive = false;
-    int origin     = current->getOrigin(isArchive);
-    if (isArchive || (origin == 0)) {
-      continue;
-    }
-
-    QString originPath = QString::fromStdWString(base->getOriginByID(origin).getPath());
-    QString fileName   = QString::fromStdWString(current->getName());
-    //    QString fileName = ToQString(current->getName());
-    QString source = originPath + relPath + fileName;
-    QString target = dataPath + relPath + fileName;
-    if (source != target) {
-      result.push_back({source, target, false, false});
-    }
-  }
-
-  // recurse into subdirectories
-  for (const auto& d : directoryEntry->getSubDirectories()) {
-    int origin = d->anyOrigin();
-
-    QString originPath = QString::fromStdWString(base->getOriginByID(origin).getPath());
-    QString dirName    = QString::fromStdWString(d->getName());
-    QString source     = originPath + relPath + dirName;
-    QString target     = dataPath + relPath + dirName;
-
-    bool writeDestination = (base == directoryEntry) && (origin == createDestination);
-
-    result.push_back({source, target, true, writeDestination});
-    std::vector<Mapping> subRes =
-        fileMapping(dataPath, relPath + dirName + "\\", base, d, createDestination);
-    result.insert(result.end(), subRes.begin(), subRes.end());
-  }
-  return result;
-}
@@ -16,8 +16,10 @@
 #include "processrunner.h"
 #include "selfupdater.h"
 #include "settings.h"
+#include "shared/fileregisterfwd.h"
 #include "uilocker.h"
 #include "usvfsconnector.h"
+#include "vfsmappingplanner.h"
 #include <boost/signals2.hpp>
 #include <delayedfilewriter.h>
 #include <imoinfo.h>
@@ -41,6 +43,8 @@ class Profile;
 class IUserInterface;
 class PluginContainer;
 class DirectoryRefresher;
+class ConflictIndex;
+class ChangeJournal;
 
 namespace MOBase
 {
@@ -231,6 +235,7 @@ public:
   SelfUpdater* updater() { return &m_Updater; }
   InstallationManager* installationManager();
   MOShared::DirectoryEntry* directoryStructure() { return m_DirectoryStructure; }
+  const ConflictIndex* conflictIndex() const { return m_ConflictIndex.get(); }
   DirectoryRefresher* directoryRefresher() { return m_DirectoryRefresher.get(); }
   ExecutablesList* executablesList() { return &m_ExecutablesList; }
   void setExecutablesList(const ExecutablesList& executablesList)
@@ -278,7 +283,10 @@ public:
   ProcessRunner::Results
   waitForAllUSVFSProcesses(UILocker::Reasons reason = UILocker::PreventExit);
 
-  void refreshESPList(bool force = false);
+  // `outdated` are plugins that are read again even if `force` is false, see
+  // PluginList::refresh()
+  //
+  void refreshESPList(bool force = false, const QStringList& outdated = {});
   void refreshBSAList();
 
   void refreshDirectoryStructure();
@@ -447,13 +455,35 @@ private:
   void saveCurrentProfile();
   void storeSettings();
 
+  // plugins in the root folder of mods, by type
+  struct ModPlugins
+  {
+    QStringList masters;
+    QStringList light;
+    QStringList regular;
+
+    QStringList all() const { return masters + light + regular; }
+  };
+
   void updateModActiveState(int index, bool active);
   void updateModsActiveState(const QList<unsigned int>& modIndices, bool active);
 
-  // clear the conflict caches of all the given mods, and the mods in conflict
-  // with the given mods
+  // lists the plugins of the given mods, each folder is only listed once
   //
-  void clearCaches(std::vector<unsigned int> const& indices) const;
+  ModPlugins findModPlugins(const QList<unsigned int>& modIndices) const;
+
+  // enables or disables the given plugins in one go, except for those that are
+  // also provided by other mods
+  //
+  void updatePluginsActiveState(const ModPlugins& plugins, bool active);
+
+  // resorts the origins of the given files after origins were added, removed
+  // or moved, and clears the conflict caches of the given mods and of every
+  // mod that provides one of these files; their entries in the conflict index
+  // are invalidated so they're computed again from the structure
+  //
+  void updateFileOrigins(const std::set<MOShared::FileIndex>& files,
+                         std::set<unsigned int> mods);
 
   bool createDirectory(const QString& path);
 
@@ -465,14 +495,10 @@ private:
   std::vector<Mapping> fileMapping(const QString& profile,
                                    const QString& customOverwrite);
 
-  std::vector<Mapping> fileMapping(const QString& dataPath, const QString& relPath,
-                                   const MOShared::DirectoryEntry* base,
-                                   const MOShared::DirectoryEntry* directoryEntry,
-                                   int createDestination);
-
 private slots:
 
   void directory_refreshed();
+  void applyFileChanges();
   void downloadRequested(QNetworkReply* reply, QString gameName, int modID,
                          const QString& fileName);
   void removeOrigin(const QString& name);
@@ -520,8 +546,13 @@ private:
 
   std::unique_ptr<DirectoryRefresher> m_DirectoryRefresher;
   MOShared::DirectoryEntry* m_DirectoryStructure;
+  std::unique_ptr<ConflictIndex> m_ConflictIndex;
+  std::unique_ptr<ChangeJournal> m_ChangeJournal;
   MOBase::MemoizedLocked<std::shared_ptr<const MOBase::IFileTree>> m_VirtualFileTree;
 
+  // links for usvfs, kept until the structure changes
+  VfsMappingPlanner m_MappingPlanner;
+
   DownloadManager m_DownloadManager;
   InstallationManager m_InstallationManager;
 
@@ -0,0 +1,222 @@
+#include "pluginheadercache.h"
+#include "settings.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <espfile.h>
+#include <log.h>
+#include <utility.h>
+
+using namespace MOBase;
+
+namespace
+{
+
+constexpr std::uint32_t CacheMagic = 0x48504f4d;  // "MOPH"
+
+QDataStream& operator<<(QDataStream& s, const PluginHeaderCache::Header& h)
+{
+  return s << h.valid << h.isMaster << h.isLight << h.author << h.description
+           << h.masters;
+}
+
+QDataStream& operator>>(QDataStream& s, PluginHeaderCache::Header& h)
+{
+  return s >> h.valid >> h.isMaster >> h.isLight >> h.author >> h.description >>
+         h.masters;
+}
+
+}  // namespace
+
+PluginHeaderCache::PluginHeaderCache() : m_Loaded(false), m_Hits(0), m_Misses(0) {}
+
+QString PluginHeaderCache::defaultPath()
+{
+  return Settings::instance().paths().cache() + "/plugins.cache";
+}
+
+bool PluginHeaderCache::load(const QString& path)
+{
+  std::scoped_lock lock(m_Mutex);
+
+  m_Loaded = true;
+  m_Entries.clear();
+  m_Hits   = 0;
+  m_Misses = 0;
+
+  QFile file(path);
+
+  if (!file.exists()) {
+    log::debug("no plugin header cache at '{}'", path);
+    return false;
+  }
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    log::warn("can't open plugin header cache '{}': {}", path, file.errorString());
+    return false;
+  }
+
+  QDataStream s(&file);
+
+  std::uint32_t magic = 0, version = 0;
+  s >> magic >> version;
+
+  if (magic != CacheMagic || version != Version) {
+    log::debug("plugin header cache '{}' is invalid or from another version, "
+               "ignoring",
+               path);
+
+    return false;
+  }
+
+  quint32 count = 0;
+  s >> count;
+
+  Entries entries;
+  entries.reserve(static_cast<int>(count));
+
+  for (quint32 i = 0; i < count; ++i) {
+    QString key;
+    Entry e;
+
+    s >> key >> e.size >> e.time >> e.header;
+    entries.insert(key, std::move(e));
+  }
+
+  if (s.status() != QDataStream::Ok) {
+    log::warn("plugin header cache '{}' is corrupted, ignoring", path);
+    return false;
+  }
+
+  m_Entries = std::move(entries);
+  log::debug("loaded {} plugin headers from '{}'", m_Entries.size(), path);
+
+  return true;
+}
+
+bool PluginHeaderCache::loaded() const
+{
+  std::scoped_lock lock(m_Mutex);
+  return m_Loaded;
+}
+
+PluginHeaderCache::Header PluginHeaderCache::get(const QString& fullPath)
+{
+  const QFileInfo fi(fullPath);
+  const auto key  = fullPath.toLower();
+  const auto size = fi.size();
+  const auto time = fi.lastModified().toMSecsSinceEpoch();
+
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    auto itor = m_Entries.constFind(key);
+    if (itor != m_Entries.constEnd() && itor->size == size && itor->time == time) {
+      ++m_Hits;
+      return itor->header;
+    }
+  }
+
+  // parsed outside the lock, this is what runs in parallel
+  Entry e;
+  e.size   = size;
+  e.time   = time;
+  e.header = parse(fullPath);
+
+  std::scoped_lock lock(m_Mutex);
+  ++m_Misses;
+
+  // failures are not cached so they're logged again on the next refresh
+  if (e.header.valid) {
+    m_Entries.insert(key, e);
+  } else {
+    m_Entries.remove(key);
+  }
+
+  return e.header;
+}
+
+bool PluginHeaderCache::save(const QString& path)
+{
+  std::scoped_lock lock(m_Mutex);
+
+  if (m_Misses == 0) {
+    m_Hits = 0;
+    return true;
+  }
+
+  for (auto itor = m_Entries.begin(); itor != m_Entries.end();) {
+    if (!QFileInfo::exists(itor.key())) {
+      itor = m_Entries.erase(itor);
+    } else {
+      ++itor;
+    }
+  }
+
+  QSaveFile file(path);
+
+  if (!file.open(QIODevice::WriteOnly)) {
+    log::warn("can't write plugin header cache '{}': {}", path, file.errorString());
+    return false;
+  }
+
+  QDataStream s(&file);
+
+  s << CacheMagic << Version << static_cast<quint32>(m_Entries.size());
+
+  for (auto itor = m_Entries.cbegin(); itor != m_Entries.cend(); ++itor) {
+    s << itor.key() << itor->size << itor->time << itor->header;
+  }
+
+  if (!file.commit()) {
+    log::warn("can't write plugin header cache '{}': {}", path, file.errorString());
+    return false;
+  }
+
+  log::debug("plugin headers: {} from cache, {} parsed, {} saved to '{}'", m_Hits,
+             m_Misses, m_Entries.size(), path);
+
+  m_Hits   = 0;
+  m_Misses = 0;
+
+  return true;
+}
+
+std::size_t PluginHeaderCache::hitCount() const
+{
+  std::scoped_lock lock(m_Mutex);
+  return m_Hits;
+}
+
+std::size_t PluginHeaderCache::missCount() const
+{
+  std::scoped_lock lock(m_Mutex);
+  return m_Misses;
+}
+
+PluginHeaderCache::Header PluginHeaderCache::parse(const QString& fullPath)
+{
+  Header h;
+
+  try {
+    ESP::File file(ToWString(fullPath));
+
+    h.isMaster    = file.isMaster();
+    h.isLight     = file.isLight();
+    h.author      = QString::fromLatin1(file.author().c_str());
+    h.description = QString::fromLatin1(file.description().c_str());
+
+    for (auto&& m : file.masters()) {
+      h.masters.append(QString::fromStdString(m));
+    }
+
+    h.valid = true;
+  } catch (const std::exception& e) {
+    log::error("failed to parse plugin file {}: {}", fullPath, e.what());
+    h = {};
+  }
+
+  return h;
+}
@@ -0,0 +1,101 @@
+#ifndef MODORGANIZER_PLUGINHEADERCACHE_INCLUDED
+#define MODORGANIZER_PLUGINHEADERCACHE_INCLUDED
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <mutex>
+
+// persistent cache of the headers of plugin files, keyed by path and
+// validated with the size and last modification time of the file
+//
+// refreshing the plugin list used to open and parse every plugin, which is
+// the bulk of the refresh time with large load orders; most plugins don't
+// change between refreshes, so their header is taken from here instead
+//
+// a refresh uses this as follows:
+//   1) load() reads the cache written by the previous session, once
+//   2) worker threads call get() for each plugin, which parses the files
+//      that are not in the cache or have changed
+//   3) save() writes the cache back if any plugin had to be parsed, entries
+//      for files that don't exist anymore are dropped
+//
+// get() is thread-safe, load() and save() are not
+//
+class PluginHeaderCache
+{
+public:
+  // bumped every time the on-disk format changes, caches with a different
+  // version are ignored
+  static constexpr std::uint32_t Version = 1;
+
+  // information from the header of a plugin file
+  //
+  struct Header
+  {
+    // false if the file couldn't be parsed, the other fields are empty
+    bool valid = false;
+
+    bool isMaster = false;
+    bool isLight  = false;
+    QString author;
+    QString description;
+    QStringList masters;
+  };
+
+  PluginHeaderCache();
+
+  // noncopyable
+  PluginHeaderCache(const PluginHeaderCache&)            = delete;
+  PluginHeaderCache& operator=(const PluginHeaderCache&) = delete;
+
+  // default location of the cache for the current instance
+  //
+  static QString defaultPath();
+
+  // reads the given cache file; returns false if it doesn't exist or is
+  // invalid, in which case all plugins will be parsed
+  //
+  bool load(const QString& path);
+
+  // whether load() has been called, regardless of whether it succeeded
+  //
+  bool loaded() const;
+
+  // returns the header of the given plugin, parsing the file if it's not in
+  // the cache or if its size or time have changed
+  //
+  Header get(const QString& fullPath);
+
+  // writes the cache to the given file if any header was parsed since the
+  // last load() or save(), does nothing otherwise
+  //
+  bool save(const QString& path);
+
+  // number of headers taken from the cache and parsed since the last save(),
+  // for logging
+  //
+  std::size_t hitCount() const;
+  std::size_t missCount() const;
+
+private:
+  struct Entry
+  {
+    qint64 size = 0;
+    qint64 time = 0;
+    Header header;
+  };
+
+  // keyed by lowercase path
+  using Entries = QHash<QString, Entry>;
+
+  mutable std::mutex m_Mutex;
+  Entries m_Entries;
+  bool m_Loaded;
+  std::size_t m_Hits;
+  std::size_t m_Misses;
+
+  static Header parse(const QString& fullPath);
+};
+
+#endif  // MODORGANIZER_PLUGINHEADERCACHE_INCLUDED
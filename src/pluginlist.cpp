@@ -20,6 +20,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "pluginlist.h"
 #include "modinfo.h"
 #include "modlist.h"
+#include "refreshprofiler.h"
 #include "scopeguard.h"
 #include "settings.h"
 #include "shared/directoryentry.h"
@@ -28,7 +29,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #include "viewmarkingscrollbar.h"
 
 #include "shared/windows_error.h"
-#include <espfile.h>
+#include "thread_utils.h"
 #include <gameplugins.h>
 #include <iplugingame.h>
 #include <report.h>
@@ -163,9 +164,11 @@ void PluginList::highlightPlugins(const std::vector<unsigned int>& modIndices,
 
 void PluginList::refresh(const QString& profileName,
                          const DirectoryEntry& baseDirectory,
-                         const QString& lockedOrderFile, bool force)
+                         const QString& lockedOrderFile, bool force,
+                         const QStringList& outdated)
 {
   TimeThis tt("PluginList::refresh()");
+  RefreshProfiler::Scope scope(RefreshProfiler::Phases::Plugins);
 
   if (force) {
     m_ESPs.clear();
@@ -175,6 +178,17 @@ void PluginList::refresh(const QString& profileName,
 
   ChangeBracket<PluginList> layoutChange(this);
 
+  // outdated plugins are removed here and added back below like new ones,
+  // their state is read again from the plugin lists
+  for (const auto& name : outdated) {
+    auto itor = m_ESPsByName.find(name);
+
+    if (itor != m_ESPsByName.end()) {
+      m_ESPs[itor->second].name = "";
+      m_ESPsByName.erase(itor);
+    }
+  }
+
   QStringList primaryPlugins = m_GamePlugin->primaryPlugins();
   GamePlugins* gamePlugins   = m_GamePlugin->feature<GamePlugins>();
   const bool lightPluginsAreSupported =
@@ -182,9 +196,42 @@ void PluginList::refresh(const QString& profileName,
 
   m_CurrentProfile = profileName;
 
-  QStringList availablePlugins;
+  std::set<QString, FileNameComparator> availablePlugins;
 
   std::vector<FileEntryPtr> files = baseDirectory.getFiles();
+
+  // archives sorted by lowercase name, the archives of a plugin are found by
+  // looking up its base name as a prefix
+  std::vector<std::pair<QString, QString>> archives;
+  for (FileEntryPtr current : files) {
+    if (current.get() == nullptr) {
+      continue;
+    }
+    QString filename = ToQString(current->getName());
+
+    if (filename.endsWith(".bsa", Qt::CaseInsensitive) ||
+        filename.endsWith(".ba2", Qt::CaseInsensitive)) {
+      archives.emplace_back(filename.toLower(), filename);
+    }
+  }
+
+  std::sort(archives.begin(), archives.end());
+
+  // plugins that are not in the list yet, their header is read in parallel
+  // below
+  struct NewPlugin
+  {
+    QString filename;
+    bool forceEnabled;
+    QString originName;
+    QString fullPath;
+    bool hasIni;
+    std::set<QString> archives;
+    PluginHeaderCache::Header header;
+  };
+
+  std::vector<NewPlugin> newPlugins;
+
   for (FileEntryPtr current : files) {
     if (current.get() == nullptr) {
       continue;
@@ -195,7 +242,7 @@ void PluginList::refresh(const QString& profileName,
         filename.endsWith(".esm", Qt::CaseInsensitive) ||
         filename.endsWith(".esl", Qt::CaseInsensitive)) {
 
-      availablePlugins.append(filename);
+      availablePlugins.insert(filename);
 
       if (m_ESPsByName.find(filename) != m_ESPsByName.end()) {
         continue;
@@ -213,15 +260,15 @@ void PluginList::refresh(const QString& profileName,
 
         QString iniPath = baseName + ".ini";
         bool hasIni     = baseDirectory.findFile(ToWString(iniPath)).get() != nullptr;
+
+        const QString prefix = baseName.toLower();
         std::set<QString> loadedArchives;
-        QString candidateName;
-        for (FileEntryPtr archiveCandidate : files) {
-          candidateName = ToQString(archiveCandidate->getName());
-          if (candidateName.startsWith(baseName, Qt::CaseInsensitive) &&
-              (candidateName.endsWith(".bsa", Qt::CaseInsensitive) ||
-               candidateName.endsWith(".ba2", Qt::CaseInsensitive))) {
-            loadedArchives.insert(candidateName);
-          }
+
+        auto itor = std::lower_bound(archives.begin(), archives.end(),
+                                     std::make_pair(prefix, QString()));
+
+        for (; itor != archives.end() && itor->first.startsWith(prefix); ++itor) {
+          loadedArchives.insert(itor->second);
         }
 
         QString originName    = ToQString(origin.getName());
@@ -231,10 +278,9 @@ void PluginList::refresh(const QString& profileName,
           originName           = modInfo->name();
         }
 
-        m_ESPs.push_back(ESPInfo(filename, forceEnabled, originName,
-                                 ToQString(current->getFullPath()), hasIni,
-                                 loadedArchives, lightPluginsAreSupported));
-        m_ESPs.rbegin()->priority = -1;
+        newPlugins.push_back({filename, forceEnabled, originName,
+                              ToQString(current->getFullPath()), hasIni,
+                              std::move(loadedArchives)});
       } catch (const std::exception& e) {
         reportError(
             tr("failed to update esp info for file %1 (source id: %2), error: %3")
@@ -245,8 +291,28 @@ void PluginList::refresh(const QString& profileName,
     }
   }
 
+  if (!m_HeaderCache.loaded()) {
+    m_HeaderCache.load(PluginHeaderCache::defaultPath());
+  }
+
+  parallelMap(
+      newPlugins.begin(), newPlugins.end(),
+      [&](NewPlugin& p) {
+        p.header = m_HeaderCache.get(p.fullPath);
+      },
+      m_Organizer.settings().refreshThreadCount());
+
+  m_HeaderCache.save(PluginHeaderCache::defaultPath());
+
+  for (auto& p : newPlugins) {
+    m_ESPs.push_back(ESPInfo(p.filename, p.forceEnabled, p.originName, p.fullPath,
+                             p.hasIni, p.archives, p.header,
+                             lightPluginsAreSupported));
+    m_ESPs.rbegin()->priority = -1;
+  }
+
   for (const auto& espName : m_ESPsByName) {
-    if (!availablePlugins.contains(espName.first, Qt::CaseInsensitive)) {
+    if (!availablePlugins.contains(espName.first)) {
       m_ESPs[espName.second].name = "";
     }
   }
@@ -399,6 +465,36 @@ void PluginList::enableESP(const QString& name, bool enable)
   }
 }
 
+QStringList PluginList::enableESPs(const QStringList& names, bool enable)
+{
+  QStringList dirty;
+
+  for (const auto& name : names) {
+    auto iter = m_ESPsByName.find(name);
+
+    if (iter == m_ESPsByName.end()) {
+      log::error("plugin not found: {}", name);
+      continue;
+    }
+
+    auto& esp          = m_ESPs[iter->second];
+    const bool enabled = enable || esp.forceEnabled;
+
+    if (esp.enabled != enabled) {
+      esp.enabled = enabled;
+      dirty.append(esp.name);
+    }
+  }
+
+  if (!dirty.isEmpty()) {
+    emit writePluginsList();
+    pluginStatesChanged(dirty, enable ? IPluginList::PluginState::STATE_ACTIVE
+                                      : IPluginList::PluginState::STATE_INACTIVE);
+  }
+
+  return dirty;
+}
+
 int PluginList::findPluginByPriority(int priority)
 {
   for (int i = 0; i < m_ESPs.size(); i++) {
@@ -1705,27 +1801,23 @@ QModelIndex PluginList::parent(const QModelIndex&) const
 PluginList::ESPInfo::ESPInfo(const QString& name, bool enabled,
                              const QString& originName, const QString& fullPath,
                              bool hasIni, std::set<QString> archives,
+                             const PluginHeaderCache::Header& header,
                              bool lightPluginsAreSupported)
     : name(name), fullPath(fullPath), enabled(enabled), forceEnabled(enabled),
       priority(0), loadOrder(-1), originName(originName), hasIni(hasIni),
       archives(archives.begin(), archives.end()), modSelected(false)
 {
-  try {
-    ESP::File file(ToWString(fullPath));
+  if (header.valid) {
     auto extension     = name.right(3).toLower();
     hasMasterExtension = (extension == "esm");
     hasLightExtension  = lightPluginsAreSupported && (extension == "esl");
-    isMasterFlagged    = file.isMaster();
-    isLightFlagged     = lightPluginsAreSupported && file.isLight();
+    isMasterFlagged    = header.isMaster;
+    isLightFlagged     = lightPluginsAreSupported && header.isLight;
 
-    author      = QString::fromLatin1(file.author().c_str());
-    description = QString::fromLatin1(file.description().c_str());
-
-    for (auto&& m : file.masters()) {
-      masters.insert(QString::fromStdString(m));
-    }
-  } catch (const std::exception& e) {
-    log::error("failed to parse plugin file {}: {}", fullPath, e.what());
+    author      = header.author;
+    description = header.description;
+    masters.insert(header.masters.begin(), header.masters.end());
+  } else {
     hasMasterExtension = false;
     hasLightExtension  = false;
     isMasterFlagged    = false;
@@ -21,6 +21,7 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 #define PLUGINLIST_H
 
 #include "loot.h"
+#include "pluginheadercache.h"
 #include "profile.h"
 #include <ifiletree.h>
 #include <ipluginlist.h>
@@ -123,11 +124,15 @@ public:
    * @param baseDirectory the root directory structure representing the virtual data
    *directory
    * @param lockedOrderFile list of plugins that shouldn't change load order
+   * @param outdated plugins that are read again even if they're already in the
+   *        list, used when they may come from another mod now; ignored if
+   *        `refresh` is true since everything is read again
    * @todo the profile is not used? If it was, we should pass the Profile-object instead
    **/
   void refresh(const QString& profileName,
                const MOShared::DirectoryEntry& baseDirectory,
-               const QString& lockedOrderFile, bool refresh);
+               const QString& lockedOrderFile, bool refresh,
+               const QStringList& outdated = {});
 
   /**
    * @brief enable a plugin based on its name
@@ -137,6 +142,16 @@ public:
    **/
   void enableESP(const QString& name, bool enable = true);
 
+  /**
+   * @brief enable or disable several plugins at once, the list is written and
+   *        plugin state callbacks are called only once
+   *
+   * @param names names of the plugins
+   * @param enable set to true to enable the plugins, false to disable them
+   * @return names of the plugins that changed state
+   **/
+  QStringList enableESPs(const QStringList& names, bool enable = true);
+
   /**
    * @brief test if a plugin is enabled
    *
@@ -314,7 +329,7 @@ private:
   {
     ESPInfo(const QString& name, bool enabled, const QString& originName,
             const QString& fullPath, bool hasIni, std::set<QString> archives,
-            bool lightSupported);
+            const PluginHeaderCache::Header& header, bool lightSupported);
 
     QString name;
     QString fullPath;
@@ -378,6 +393,7 @@ private:
   OrganizerCore& m_Organizer;
 
   std::vector<ESPInfo> m_ESPs;
+  PluginHeaderCache m_HeaderCache;
   mutable std::map<QString, QByteArray> m_LastSaveHash;
 
   std::map<QString, int, MOBase::FileNameComparator> m_ESPsByName;
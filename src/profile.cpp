@@ -703,6 +703,71 @@ bool Profile::setModPriority(unsigned int index, int& newPriority)
   return true;
 }
 
+std::vector<unsigned int>
+Profile::moveModsPriority(const std::vector<unsigned int>& indices, int newPriority)
+{
+  std::vector<bool> moving(m_ModStatus.size(), false);
+  for (const auto index : indices) {
+    if (index >= m_ModStatus.size()) {
+      log::error("invalid mod index: {}", index);
+      continue;
+    }
+
+    moving[index] = !ModInfo::getByIndex(index)->hasAutomaticPriority();
+  }
+
+  // the priorities used by regular mods, in order, and the mods in the order
+  // they'll be given these priorities
+  std::vector<int> priorities;
+  std::vector<unsigned int> order, block;
+  std::size_t insertAt = 0;
+
+  priorities.reserve(m_NumRegularMods);
+  order.reserve(m_NumRegularMods);
+
+  for (const auto& [priority, index] : m_ModIndexByPriority) {
+    if (ModInfo::getByIndex(index)->hasAutomaticPriority()) {
+      continue;
+    }
+
+    priorities.push_back(priority);
+
+    if (moving[index]) {
+      block.push_back(index);
+    } else {
+      if (priority < newPriority) {
+        ++insertAt;
+      }
+
+      order.push_back(index);
+    }
+  }
+
+  if (block.empty()) {
+    return {};
+  }
+
+  order.insert(order.begin() + insertAt, block.begin(), block.end());
+
+  std::vector<unsigned int> changed;
+
+  for (std::size_t i = 0; i < order.size(); ++i) {
+    auto& status = m_ModStatus[order[i]];
+
+    if (status.m_Priority != priorities[i]) {
+      status.m_Priority = priorities[i];
+      changed.push_back(order[i]);
+    }
+  }
+
+  if (!changed.empty()) {
+    updateIndices();
+    m_ModListWriter.write();
+  }
+
+  return changed;
+}
+
 Profile* Profile::createPtrFrom(const QString& name, const Profile& reference,
                                 MOBase::IPluginGame const* gamePlugin)
 {
@@ -301,6 +301,20 @@ public:
   //
   bool setModPriority(unsigned int index, int& newPriority);
 
+  // moves the given mods as a single block so that it starts at the given
+  // priority, the mods in the block and the other mods all keep their relative
+  // order; this is what dropping a selection of mods in the list does
+  //
+  // `newPriority` is the priority of the mod the block is inserted before, the
+  // block goes at the end if it's MaximumPriority; mods with an automatic
+  // priority are ignored
+  //
+  // returns the indices of all the mods that have a different priority,
+  // including the ones that were shifted to make room for the block
+  //
+  std::vector<unsigned int> moveModsPriority(const std::vector<unsigned int>& indices,
+                                             int newPriority);
+
   /**
    * @brief determine if a mod is enabled
    *
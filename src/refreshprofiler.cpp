@@ -0,0 +1,291 @@
+#include "refreshprofiler.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <algorithm>
+#include <array>
+#include <log.h>
+#include <set>
+
+using namespace MOBase;
+using namespace MOShared;
+
+namespace
+{
+
+const char* phaseName(RefreshProfiler::Phases p)
+{
+  using P = RefreshProfiler::Phases;
+
+  switch (p) {
+  case P::Walk:
+    return "walk";
+  case P::Archives:
+    return "archives";
+  case P::Merge:
+    return "merge";
+  case P::Sort:
+    return "sort";
+  case P::Conflicts:
+    return "conflicts";
+  case P::Plugins:
+    return "plugins";
+  default:
+    return "?";
+  }
+}
+
+// scopes without a mod are reported under this name in the csv
+const std::string AllMods = "(all)";
+
+}  // namespace
+
+struct RefreshProfiler::ThreadBuffer
+{
+  std::mutex mutex;
+  int id = 0;
+  std::vector<Event> events;
+};
+
+RefreshProfiler::Scope::Scope(Phases phase, std::wstring_view name)
+    : m_phase(phase), m_active(RefreshProfiler::instance().recording())
+{
+  if (m_active) {
+    m_name  = name;
+    m_start = std::chrono::steady_clock::now();
+  }
+}
+
+RefreshProfiler::Scope::~Scope()
+{
+  if (!m_active) {
+    return;
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+  RefreshProfiler::instance().record(
+      {m_phase, std::move(m_name), m_start, end - m_start});
+}
+
+RefreshProfiler::RefreshProfiler() : m_recording(false) {}
+
+RefreshProfiler& RefreshProfiler::instance()
+{
+  static RefreshProfiler p;
+  return p;
+}
+
+void RefreshProfiler::start()
+{
+  // drop events left by a run that was never finished
+  takeEvents();
+
+  {
+    std::scoped_lock lock(m_mutex);
+    m_stats.clear();
+    m_start = std::chrono::steady_clock::now();
+  }
+
+  DirectoryStats::setEnabled(true);
+  m_recording = true;
+
+  log::debug("refresh profiler: recording");
+}
+
+void RefreshProfiler::finish(const QString& dir)
+{
+  if (!m_recording.exchange(false)) {
+    return;
+  }
+
+  DirectoryStats::setEnabled(false);
+
+  const auto events = takeEvents();
+  std::scoped_lock lock(m_mutex);
+
+  if (!QDir().mkpath(dir)) {
+    log::error("refresh profiler: can't create '{}'", dir);
+    return;
+  }
+
+  const auto base = QDir(dir).filePath(
+      "refresh-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"));
+
+  if (writeTrace(base + ".json", events) && writeCsv(base + ".csv", events)) {
+    log::info("refresh profile with {} events written to '{}'", events.size(),
+              QDir::toNativeSeparators(base) + ".{json,csv}");
+  }
+}
+
+void RefreshProfiler::addStats(const std::vector<DirectoryStats>& stats)
+{
+  if (!recording()) {
+    return;
+  }
+
+  std::scoped_lock lock(m_mutex);
+
+  for (auto&& s : stats) {
+    auto& to = m_stats[s.mod.empty() ? AllMods : s.mod];
+    to.mod   = s.mod;
+    to += s;
+  }
+}
+
+void RefreshProfiler::record(Event e)
+{
+  auto& b = threadBuffer();
+
+  // only contended by takeEvents()
+  std::scoped_lock lock(b.mutex);
+  b.events.push_back(std::move(e));
+}
+
+RefreshProfiler::ThreadBuffer& RefreshProfiler::threadBuffer()
+{
+  thread_local std::shared_ptr<ThreadBuffer> buffer;
+
+  if (!buffer) {
+    buffer = std::make_shared<ThreadBuffer>();
+
+    std::scoped_lock lock(m_mutex);
+    buffer->id = static_cast<int>(m_buffers.size()) + 1;
+    m_buffers.push_back(buffer);
+  }
+
+  return *buffer;
+}
+
+std::vector<std::pair<int, RefreshProfiler::Event>> RefreshProfiler::takeEvents()
+{
+  std::vector<std::pair<int, Event>> events;
+
+  std::scoped_lock lock(m_mutex);
+
+  for (auto&& b : m_buffers) {
+    std::scoped_lock bufferLock(b->mutex);
+
+    for (auto&& e : b->events) {
+      events.push_back({b->id, std::move(e)});
+    }
+
+    b->events.clear();
+  }
+
+  std::sort(events.begin(), events.end(), [](auto&& a, auto&& b) {
+    return (a.second.start < b.second.start);
+  });
+
+  return events;
+}
+
+bool RefreshProfiler::writeTrace(const QString& path,
+                                 const std::vector<std::pair<int, Event>>& events) const
+{
+  using us = std::chrono::duration<double, std::micro>;
+
+  QJsonArray list;
+  std::set<int> threads;
+
+  for (auto&& [tid, e] : events) {
+    QJsonObject o;
+
+    o["name"] = e.name.empty() ? QString(phaseName(e.phase))
+                               : QString::fromStdWString(e.name);
+    o["cat"]  = phaseName(e.phase);
+    o["ph"]   = "X";
+    o["ts"]   = us(e.start - m_start).count();
+    o["dur"]  = us(e.duration).count();
+    o["pid"]  = 1;
+    o["tid"]  = tid;
+
+    list.append(o);
+    threads.insert(tid);
+  }
+
+  // names the rows in the viewer
+  for (int tid : threads) {
+    const QJsonObject args{{"name", QString("thread %1").arg(tid)}};
+
+    list.append(QJsonObject{{"name", "thread_name"},
+                            {"ph", "M"},
+                            {"pid", 1},
+                            {"tid", tid},
+                            {"args", args}});
+  }
+
+  QFile f(path);
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    log::error("refresh profiler: can't write '{}', {}", path, f.errorString());
+    return false;
+  }
+
+  const QJsonDocument doc(QJsonObject{{"traceEvents", list}});
+  f.write(doc.toJson(QJsonDocument::Compact));
+  return true;
+}
+
+bool RefreshProfiler::writeCsv(const QString& path,
+                               const std::vector<std::pair<int, Event>>& events) const
+{
+  using seconds = std::chrono::duration<double>;
+
+  constexpr auto PhaseCount = static_cast<std::size_t>(Phases::Count);
+
+  // total time of each phase per mod; the walk of a mod is split in multiple
+  // tasks on different threads, so this is cpu time rather than wall time
+  std::map<std::string, std::array<seconds, PhaseCount>> times;
+
+  for (auto&& [tid, e] : events) {
+    const auto mod =
+        e.name.empty() ? AllMods : QString::fromStdWString(e.name).toStdString();
+
+    times[mod][static_cast<std::size_t>(e.phase)] += e.duration;
+  }
+
+  QFile f(path);
+  if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    log::error("refresh profiler: can't write '{}', {}", path, f.errorString());
+    return false;
+  }
+
+  QStringList header = {"mod"};
+  for (std::size_t i = 0; i < PhaseCount; ++i) {
+    header << phaseName(static_cast<Phases>(i));
+  }
+
+  header << QString::fromStdString(DirectoryStats::csvHeader());
+  f.write((header.join(",") + "\n").toUtf8());
+
+  std::set<std::string> mods;
+  for (auto&& [mod, _] : times) {
+    mods.insert(mod);
+  }
+
+  for (auto&& [mod, _] : m_stats) {
+    mods.insert(mod);
+  }
+
+  const DirectoryStats noStats;
+
+  for (auto&& mod : mods) {
+    // mod names may contain commas
+    QStringList row = {"\"" + QString::fromStdString(mod).replace("\"", "\"\"") + "\""};
+
+    auto itor = times.find(mod);
+    for (std::size_t i = 0; i < PhaseCount; ++i) {
+      row << QString::number(itor == times.end() ? 0.0 : itor->second[i].count());
+    }
+
+    auto sitor = m_stats.find(mod);
+    const auto& s = (sitor == m_stats.end() ? noStats : sitor->second);
+
+    f.write((row.join(",") + "," + QString::fromStdString(s.toCsv()) + "\n").toUtf8());
+  }
+
+  return true;
+}
@@ -0,0 +1,118 @@
+#ifndef MODORGANIZER_REFRESHPROFILER_INCLUDED
+#define MODORGANIZER_REFRESHPROFILER_INCLUDED
+
+#include "shared/fileregisterfwd.h"
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// records how long each phase of a refresh takes, per mod and per thread
+//
+// profiling is enabled by the "refresh_profiling" diagnostics setting; a run
+// starts with the directory refresher and ends once the plugin list has been
+// refreshed, at which point a Chrome trace (which can be opened in
+// chrome://tracing or https://ui.perfetto.dev) and a csv file with the totals
+// of each mod are written
+//
+// scopes are recorded in a buffer owned by the thread that created them, so
+// the pool threads don't contend with each other; when no run is active, a
+// scope only checks an atomic flag
+//
+class RefreshProfiler
+{
+public:
+  enum class Phases
+  {
+    Walk = 0,
+    Archives,
+    Merge,
+    Sort,
+    Conflicts,
+    Plugins,
+
+    // number of phases, not a phase
+    Count
+  };
+
+  // times the enclosing block, does nothing if no run is active
+  //
+  class Scope
+  {
+  public:
+    // `name` is usually the mod being processed, it's only copied if a run
+    // is active
+    Scope(Phases phase, std::wstring_view name = {});
+    ~Scope();
+
+    Scope(const Scope&)            = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    Phases m_phase;
+    std::wstring m_name;
+    std::chrono::steady_clock::time_point m_start;
+    bool m_active;
+  };
+
+  static RefreshProfiler& instance();
+
+  // forgets the previous run, if any, and starts recording; also enables the
+  // DirectoryStats counters
+  //
+  void start();
+
+  // stops recording and writes the trace and csv files in the given directory,
+  // does nothing if no run was started
+  //
+  void finish(const QString& dir);
+
+  // whether a run is active
+  //
+  bool recording() const { return m_recording.load(std::memory_order_relaxed); }
+
+  // adds the counters gathered for mods while walking them; the `mod` member
+  // is used to match them with the phases
+  //
+  void addStats(const std::vector<MOShared::DirectoryStats>& stats);
+
+private:
+  struct Event
+  {
+    Phases phase;
+    std::wstring name;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::duration duration;
+  };
+
+  struct ThreadBuffer;
+
+  std::atomic<bool> m_recording;
+  std::chrono::steady_clock::time_point m_start;
+
+  // buffers of all the threads that have recorded something, they're kept
+  // alive here even if their thread exits
+  std::mutex m_mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+  std::map<std::string, MOShared::DirectoryStats> m_stats;
+
+  RefreshProfiler();
+
+  void record(Event e);
+  ThreadBuffer& threadBuffer();
+
+  std::vector<std::pair<int, Event>> takeEvents();
+
+  bool writeTrace(const QString& path,
+                  const std::vector<std::pair<int, Event>>& events) const;
+
+  bool writeCsv(const QString& path,
+                const std::vector<std::pair<int, Event>>& events) const;
+};
+
+#endif  // MODORGANIZER_REFRESHPROFILER_INCLUDED
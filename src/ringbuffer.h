@@ -0,0 +1,123 @@
+#ifndef MODORGANIZER_RINGBUFFER_INCLUDED
+#define MODORGANIZER_RINGBUFFER_INCLUDED
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace MOShared
+{
+
+// a fixed-size queue that any number of threads can push to without locking,
+// emptied by a single thread
+//
+// push() fails instead of waiting when the buffer is full; each slot has a
+// sequence number telling whether it's free for the producer that claimed it
+// or ready for the consumer, this is Dmitry Vyukov's bounded queue
+//
+// a producer that was interrupted between claiming a slot and filling it
+// makes pop() fail until it's done, even if later slots are ready
+//
+template <class T>
+class RingBuffer
+{
+public:
+  // the capacity is rounded up to a power of two
+  //
+  explicit RingBuffer(std::size_t capacity)
+      : m_Mask(roundUp(capacity) - 1), m_Cells(new Cell[m_Mask + 1]), m_Tail(0),
+        m_Head(0)
+  {
+    for (std::size_t i = 0; i <= m_Mask; ++i) {
+      m_Cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  RingBuffer(const RingBuffer&)            = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+
+  std::size_t capacity() const { return m_Mask + 1; }
+
+  // can be called from any thread, returns false if the buffer is full
+  //
+  template <class U>
+  bool push(U&& value)
+  {
+    std::size_t pos = m_Tail.load(std::memory_order_relaxed);
+    Cell* cell      = nullptr;
+
+    for (;;) {
+      cell           = &m_Cells[pos & m_Mask];
+      const auto seq = cell->sequence.load(std::memory_order_acquire);
+      const auto diff =
+          static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+
+      if (diff == 0) {
+        // the slot is free, try to claim it
+        if (m_Tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // the consumer hasn't emptied this slot yet
+        return false;
+      } else {
+        // another producer claimed it
+        pos = m_Tail.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->value = std::forward<U>(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  // must only be called from one thread at a time, returns false if there's
+  // nothing ready
+  //
+  bool pop(T& out)
+  {
+    Cell& cell     = m_Cells[m_Head & m_Mask];
+    const auto seq = cell.sequence.load(std::memory_order_acquire);
+
+    if (seq != m_Head + 1) {
+      return false;
+    }
+
+    out        = std::move(cell.value);
+    cell.value = T();
+    cell.sequence.store(m_Head + m_Mask + 1, std::memory_order_release);
+    ++m_Head;
+
+    return true;
+  }
+
+private:
+  struct Cell
+  {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  const std::size_t m_Mask;
+  std::unique_ptr<Cell[]> m_Cells;
+
+  // producers and the consumer are kept on separate cache lines
+  alignas(64) std::atomic<std::size_t> m_Tail;
+  alignas(64) std::size_t m_Head;
+
+  static std::size_t roundUp(std::size_t n)
+  {
+    std::size_t p = 2;
+    while (p < n) {
+      p *= 2;
+    }
+
+    return p;
+  }
+};
+
+}  // namespace MOShared
+
+#endif  // MODORGANIZER_RINGBUFFER_INCLUDED
@@ -306,6 +306,16 @@ void Settings::setArchiveParsing(bool b)
   set(m_Settings, "Settings", "archive_parsing_experimental", b);
 }
 
+bool Settings::directorySnapshot() const
+{
+  return get<bool>(m_Settings, "Settings", "directory_snapshot", true);
+}
+
+void Settings::setDirectorySnapshot(bool b)
+{
+  set(m_Settings, "Settings", "directory_snapshot", b);
+}
+
 std::vector<std::map<QString, QVariant>> Settings::executables() const
 {
   ScopedReadArray sra(m_Settings, "customExecutables");
@@ -2345,6 +2355,30 @@ void DiagnosticsSettings::setSpawnDelay(std::chrono::seconds t)
   set(m_Settings, "Settings", "spawn_delay", t.count());
 }
 
+bool DiagnosticsSettings::refreshProfiling() const
+{
+  return get<bool>(m_Settings, "Settings", "refresh_profiling", false);
+}
+
+void DiagnosticsSettings::setRefreshProfiling(bool b)
+{
+  set(m_Settings, "Settings", "refresh_profiling", b);
+}
+
+QString DiagnosticsSettings::refreshProfilePath() const
+{
+  const auto logs = QFileInfo(m_Settings.fileName())
+                        .dir()
+                        .filePath(QString::fromStdWString(AppConfig::logPath()));
+
+  return get<QString>(m_Settings, "Settings", "refresh_profile_path", logs);
+}
+
+void DiagnosticsSettings::setRefreshProfilePath(const QString& path)
+{
+  set(m_Settings, "Settings", "refresh_profile_path", path);
+}
+
 void GlobalSettings::updateRegistryKey()
 {
   const QString OldOrganization  = "Tannin";
@@ -718,6 +718,17 @@ public:
   std::chrono::seconds spawnDelay() const;
   void setSpawnDelay(std::chrono::seconds t);
 
+  // whether refreshes are profiled, see RefreshProfiler
+  //
+  bool refreshProfiling() const;
+  void setRefreshProfiling(bool b);
+
+  // directory where refresh profiles are written, defaults to the logs
+  // directory of the instance
+  //
+  QString refreshProfilePath() const;
+  void setRefreshProfilePath(const QString& path);
+
 private:
   QSettings& m_Settings;
 };
@@ -800,6 +811,12 @@ public:
   bool archiveParsing() const;
   void setArchiveParsing(bool b);
 
+  // whether the listing of the mods is kept between refreshes and restored
+  // for mods that haven't changed on disk, see DirectorySnapshot
+  //
+  bool directorySnapshot() const;
+  void setDirectorySnapshot(bool b);
+
   // whether the user wants to check for updates
   //
   bool checkForUpdates() const;
@@ -14,6 +14,7 @@ DiagnosticsSettingsTab::DiagnosticsSettingsTab(Settings& s, SettingsDialog& d)
   setCrashDumpTypesBox();
 
   ui->dumpsMaxEdit->setValue(settings().diagnostics().maxCoreDumps());
+  ui->refreshProfilingBox->setChecked(settings().diagnostics().refreshProfiling());
 
   QString logsPath = qApp->property("dataPath").toString() + "/" +
                      QString::fromStdWString(AppConfig::logPath());
@@ -104,6 +105,7 @@ void DiagnosticsSettingsTab::update()
       static_cast<env::CoreDumpTypes>(ui->dumpsTypeBox->currentData().toInt()));
 
   settings().diagnostics().setMaxCoreDumps(ui->dumpsMaxEdit->value());
+  settings().diagnostics().setRefreshProfiling(ui->refreshProfilingBox->isChecked());
 
   settings().diagnostics().setLootLogLevel(
       static_cast<lootcli::LogLevels>(ui->lootLogLevel->currentData().toInt()));
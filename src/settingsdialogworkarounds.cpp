@@ -13,6 +13,7 @@ WorkaroundsSettingsTab::WorkaroundsSettingsTab(Settings& s, SettingsDialog& d)
   ui->forceEnableBox->setChecked(settings().game().forceEnableCoreFiles());
   ui->lockGUIBox->setChecked(settings().interface().lockGUI());
   ui->enableArchiveParsingBox->setChecked(settings().archiveParsing());
+  ui->directorySnapshotBox->setChecked(settings().directorySnapshot());
 
   // steam
   QString username, password;
@@ -52,6 +53,7 @@ void WorkaroundsSettingsTab::update()
   settings().game().setForceEnableCoreFiles(ui->forceEnableBox->isChecked());
   settings().interface().setLockGUI(ui->lockGUIBox->isChecked());
   settings().setArchiveParsing(ui->enableArchiveParsingBox->isChecked());
+  settings().setDirectorySnapshot(ui->directorySnapshotBox->isChecked());
 
   // steam
   if (ui->appIDEdit->text() != settings().game().plugin()->steamAPPId()) {
@@ -0,0 +1,475 @@
+#include "archiveindex.h"
+#include "util.h"
+#include <QSaveFile>
+#include <bsatk.h>
+#include <filesystem>
+#include <log.h>
+#include <utility.h>
+
+namespace MOShared
+{
+
+using namespace MOBase;
+
+namespace
+{
+
+constexpr std::uint32_t IndexMagic = 0x41324f4d;  // "MO2A"
+
+struct IndexError : public std::runtime_error
+{
+  using runtime_error::runtime_error;
+};
+
+std::uint64_t toUInt64(FILETIME ft)
+{
+  return (static_cast<std::uint64_t>(ft.dwHighDateTime) << 32) | ft.dwLowDateTime;
+}
+
+// appends plain values to a byte array, in native byte order
+//
+class Writer
+{
+public:
+  Writer(QByteArray& out) : m_out(out) {}
+
+  template <class T>
+  void write(T v)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    m_out.append(reinterpret_cast<const char*>(&v), sizeof(T));
+  }
+
+  void write(std::wstring_view s)
+  {
+    write(static_cast<std::uint32_t>(s.size()));
+    m_out.append(reinterpret_cast<const char*>(s.data()),
+                 static_cast<int>(s.size() * sizeof(wchar_t)));
+  }
+
+private:
+  QByteArray& m_out;
+};
+
+// reads values written by Writer from a memory range, throws IndexError when
+// going past the end
+//
+// strings are returned as views into the range; all the values have an even
+// size, so they stay aligned for wchar_t as long as the range is
+//
+class Reader
+{
+public:
+  Reader(const uchar* begin, const uchar* end) : m_p(begin), m_end(end) {}
+
+  template <class T>
+  T read()
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    need(sizeof(T));
+
+    T v;
+    std::memcpy(&v, m_p, sizeof(T));
+    m_p += sizeof(T);
+
+    return v;
+  }
+
+  std::wstring_view readString()
+  {
+    const auto length = read<std::uint32_t>();
+    const auto bytes  = static_cast<std::size_t>(length) * sizeof(wchar_t);
+
+    need(bytes);
+
+    const std::wstring_view s(reinterpret_cast<const wchar_t*>(m_p), length);
+    m_p += bytes;
+
+    return s;
+  }
+
+  const uchar* pos() const { return m_p; }
+
+private:
+  const uchar* m_p;
+  const uchar* m_end;
+
+  void need(std::size_t n) const
+  {
+    if (static_cast<std::size_t>(m_end - m_p) < n) {
+      throw IndexError("unexpected end of index");
+    }
+  }
+};
+
+// folder:
+//   parent index, name,
+//   file count, then (name, size, uncompressed size) for each file
+//
+// followed by the subfolders, recursively
+//
+void writeFolder(Writer& w, const BSA::Folder::Ptr& folder, std::uint32_t parent,
+                 std::wstring_view name, std::uint32_t& folders, std::uint32_t& files)
+{
+  const auto index = folders++;
+
+  w.write(parent);
+  w.write(name);
+
+  const auto fileCount = folder->getNumFiles();
+  w.write(static_cast<std::uint32_t>(fileCount));
+
+  for (unsigned int i = 0; i < fileCount; ++i) {
+    const BSA::File::Ptr file = folder->getFile(i);
+
+    w.write(ToWString(file->getName(), true));
+    w.write(static_cast<std::uint64_t>(file->getFileSize()));
+    w.write(static_cast<std::uint64_t>(file->getUncompressedFileSize()));
+  }
+
+  files += fileCount;
+
+  const auto dirCount = folder->getNumSubFolders();
+  for (unsigned int i = 0; i < dirCount; ++i) {
+    const BSA::Folder::Ptr sub = folder->getSubFolder(i);
+    writeFolder(w, sub, index, ToWString(sub->getName(), true), folders, files);
+  }
+}
+
+}  // namespace
+
+ArchiveIndex::ArchiveIndex()
+    : m_Map(nullptr), m_Begin(nullptr), m_End(nullptr), m_FolderCount(0),
+      m_FileCount(0)
+{}
+
+ArchiveIndex::~ArchiveIndex()
+{
+  if (m_Map) {
+    m_File.unmap(m_Map);
+  }
+}
+
+std::unique_ptr<ArchiveIndex> ArchiveIndex::fromArchive(const std::wstring& archivePath,
+                                                        std::uint64_t size,
+                                                        std::uint64_t time)
+{
+  BSA::Archive archive;
+  BSA::EErrorCode res = BSA::ERROR_NONE;
+
+  try {
+    // read() can return an error, but it can also throw if the file is not a
+    // valid bsa
+    res = archive.read(ToString(archivePath, false).c_str(), false);
+  } catch (std::exception& e) {
+    log::error("invalid bsa '{}', error {}", archivePath, e.what());
+    return {};
+  }
+
+  if ((res != BSA::ERROR_NONE) && (res != BSA::ERROR_INVALIDHASHES)) {
+    log::error("invalid bsa '{}', error {}", archivePath, res);
+    return {};
+  }
+
+  QByteArray body;
+  std::uint32_t folders = 0, files = 0;
+
+  {
+    Writer w(body);
+    writeFolder(w, archive.getRoot(), NoParent, L"", folders, files);
+  }
+
+  auto index = std::make_unique<ArchiveIndex>();
+
+  {
+    Writer w(index->m_Data);
+
+    w.write(IndexMagic);
+    w.write(Version);
+    w.write(size);
+    w.write(time);
+    w.write(std::wstring_view(archivePath));
+    w.write(folders);
+    w.write(files);
+  }
+
+  index->m_Data.append(body);
+
+  const auto* p = reinterpret_cast<const uchar*>(index->m_Data.constData());
+  index->open(p, p + index->m_Data.size(), archivePath, size, time);
+
+  return index;
+}
+
+std::unique_ptr<ArchiveIndex> ArchiveIndex::map(const std::wstring& indexPath,
+                                                const std::wstring& archivePath,
+                                                std::uint64_t size, std::uint64_t time)
+{
+  auto index = std::make_unique<ArchiveIndex>();
+  index->m_File.setFileName(QString::fromStdWString(indexPath));
+
+  if (!index->m_File.exists()) {
+    return {};
+  }
+
+  if (!index->m_File.open(QIODevice::ReadOnly)) {
+    log::debug("can't open archive index '{}': {}", indexPath,
+               index->m_File.errorString());
+    return {};
+  }
+
+  index->m_Map = index->m_File.map(0, index->m_File.size());
+  if (!index->m_Map) {
+    log::debug("can't map archive index '{}': {}", indexPath,
+               index->m_File.errorString());
+    return {};
+  }
+
+  try {
+    index->open(index->m_Map, index->m_Map + index->m_File.size(), archivePath, size,
+                time);
+  } catch (IndexError& e) {
+    log::debug("archive index '{}' for '{}' can't be used, {}", indexPath,
+               archivePath, e.what());
+    return {};
+  }
+
+  return index;
+}
+
+std::wstring ArchiveIndex::archivePathOf(const std::wstring& indexPath)
+{
+  QFile file(QString::fromStdWString(indexPath));
+
+  if (!file.open(QIODevice::ReadOnly)) {
+    return {};
+  }
+
+  // magic, version, size and time, followed by the path, which can be as long
+  // as the longest path supported
+  const QByteArray header = file.read(24 + 4 + 32767 * sizeof(wchar_t));
+
+  try {
+    const auto* p = reinterpret_cast<const uchar*>(header.constData());
+    Reader r(p, p + header.size());
+
+    if (r.read<std::uint32_t>() != IndexMagic) {
+      return {};
+    }
+
+    r.read<std::uint32_t>();
+    r.read<std::uint64_t>();
+    r.read<std::uint64_t>();
+
+    return std::wstring(r.readString());
+  } catch (IndexError&) {
+    return {};
+  }
+}
+
+bool ArchiveIndex::save(const std::wstring& indexPath) const
+{
+  QSaveFile file(QString::fromStdWString(indexPath));
+
+  if (!file.open(QIODevice::WriteOnly)) {
+    log::debug("can't write archive index '{}': {}", indexPath, file.errorString());
+    return false;
+  }
+
+  if (m_Map) {
+    file.write(reinterpret_cast<const char*>(m_Map), m_File.size());
+  } else {
+    file.write(m_Data);
+  }
+
+  if (!file.commit()) {
+    log::debug("can't write archive index '{}': {}", indexPath, file.errorString());
+    return false;
+  }
+
+  return true;
+}
+
+void ArchiveIndex::forEachFolder(const FolderCallback& f) const
+{
+  Reader r(m_Begin, m_End);
+  std::vector<File> files;
+
+  for (std::size_t i = 0; i < m_FolderCount; ++i) {
+    const auto parent = r.read<std::uint32_t>();
+    const auto name   = r.readString();
+    const auto count  = r.read<std::uint32_t>();
+
+    files.clear();
+    files.reserve(count);
+
+    for (std::uint32_t j = 0; j < count; ++j) {
+      File file;
+      file.name             = r.readString();
+      file.size             = r.read<std::uint64_t>();
+      file.uncompressedSize = r.read<std::uint64_t>();
+
+      files.push_back(file);
+    }
+
+    f(parent, name, files);
+  }
+}
+
+void ArchiveIndex::open(const uchar* begin, const uchar* end,
+                        const std::wstring& archivePath, std::uint64_t size,
+                        std::uint64_t time)
+{
+  Reader r(begin, end);
+
+  if (r.read<std::uint32_t>() != IndexMagic) {
+    throw IndexError("bad magic");
+  }
+
+  if (r.read<std::uint32_t>() != Version) {
+    throw IndexError("different version");
+  }
+
+  if (r.read<std::uint64_t>() != size || r.read<std::uint64_t>() != time) {
+    throw IndexError("archive has changed");
+  }
+
+  if (!CaseInsensitiveEqual(std::wstring(r.readString()), archivePath)) {
+    throw IndexError("different archive");
+  }
+
+  m_FolderCount = r.read<std::uint32_t>();
+  m_FileCount   = r.read<std::uint32_t>();
+  m_Begin       = r.pos();
+  m_End         = end;
+
+  // walks everything once so forEachFolder() can't fail halfway through adding
+  // files to the structure
+  std::uint32_t folders = 0;
+
+  forEachFolder([&](std::uint32_t parent, auto&&, auto&&) {
+    // the root comes first, other folders come after their parent
+    const bool valid = (folders == 0 ? parent == NoParent : parent < folders);
+
+    if (!valid) {
+      throw IndexError("bad folder parent");
+    }
+
+    ++folders;
+  });
+}
+
+ArchiveIndexCache::ArchiveIndexCache() : m_Mapped(0), m_Built(0) {}
+
+void ArchiveIndexCache::setDirectory(std::wstring dir)
+{
+  std::scoped_lock lock(m_Mutex);
+
+  if (!dir.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+
+    if (ec) {
+      log::warn("can't create archive index directory '{}', {}", dir, ec.message());
+      dir.clear();
+    }
+  }
+
+  m_Directory = std::move(dir);
+}
+
+std::unique_ptr<ArchiveIndex> ArchiveIndexCache::get(const std::wstring& archivePath,
+                                                     std::uint64_t& time)
+{
+  WIN32_FILE_ATTRIBUTE_DATA data = {};
+
+  if (!::GetFileAttributesExW(archivePath.c_str(), GetFileExInfoStandard, &data)) {
+    const auto e = ::GetLastError();
+    log::error("can't get attributes of '{}', {}", archivePath,
+               formatSystemMessage(e));
+    return {};
+  }
+
+  const auto size =
+      (static_cast<std::uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+
+  time = toUInt64(data.ftLastWriteTime);
+
+  const auto path = indexPath(archivePath);
+
+  if (!path.empty()) {
+    if (auto index = ArchiveIndex::map(path, archivePath, size, time)) {
+      ++m_Mapped;
+      return index;
+    }
+  }
+
+  auto index = ArchiveIndex::fromArchive(archivePath, size, time);
+
+  if (index) {
+    ++m_Built;
+
+    if (!path.empty()) {
+      index->save(path);
+    }
+  }
+
+  return index;
+}
+
+void ArchiveIndexCache::prune()
+{
+  std::wstring dir;
+
+  {
+    std::scoped_lock lock(m_Mutex);
+    dir = m_Directory;
+  }
+
+  if (dir.empty()) {
+    return;
+  }
+
+  std::error_code ec;
+  std::size_t removed = 0;
+
+  for (auto&& e : std::filesystem::directory_iterator(dir, ec)) {
+    if (e.path().extension() != L".idx") {
+      continue;
+    }
+
+    const auto archive = ArchiveIndex::archivePathOf(e.path().native());
+
+    if (archive.empty() || !std::filesystem::exists(archive, ec)) {
+      std::filesystem::remove(e.path(), ec);
+      ++removed;
+    }
+  }
+
+  if (removed > 0) {
+    log::debug("removed {} stale archive indices", removed);
+  }
+}
+
+std::pair<std::size_t, std::size_t> ArchiveIndexCache::takeCounts()
+{
+  return {m_Mapped.exchange(0), m_Built.exchange(0)};
+}
+
+std::wstring ArchiveIndexCache::indexPath(const std::wstring& archivePath) const
+{
+  std::scoped_lock lock(m_Mutex);
+
+  if (m_Directory.empty()) {
+    return {};
+  }
+
+  const auto hash = std::hash<std::wstring>()(ToLowerCopy(archivePath));
+  const auto name = QString("%1.idx").arg(static_cast<qulonglong>(hash), 16, 16,
+                                           QChar('0'));
+
+  return m_Directory + L"\\" + name.toStdWString();
+}
+
+}  // namespace MOShared
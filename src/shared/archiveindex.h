@@ -0,0 +1,151 @@
+#ifndef MO_REGISTER_ARCHIVEINDEX_INCLUDED
+#define MO_REGISTER_ARCHIVEINDEX_INCLUDED
+
+#include <QByteArray>
+#include <QFile>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace MOShared
+{
+
+// flattened folder and file tables of a bsa/ba2 archive
+//
+// parsing an archive with BSA::Archive reads and decodes all of its tables,
+// which is slow for the hundreds of archives of a large setup; an index is
+// built once from the archive, written to the cache directory and memory-mapped
+// on later refreshes as long as the archive keeps the same size and time
+//
+// folders are stored parents first, so each folder can be created from the
+// entry of its parent; names are stored as they'll be used in the structure,
+// views given by forEachFolder() point directly into the index
+//
+class ArchiveIndex
+{
+public:
+  // bumped every time the on-disk format changes, indices with a different
+  // version are built again
+  static constexpr std::uint32_t Version = 1;
+
+  // parent of the root folder
+  static constexpr std::uint32_t NoParent = 0xffffffff;
+
+  struct File
+  {
+    std::wstring_view name;
+    std::uint64_t size;
+
+    // 0 if the file is not compressed
+    std::uint64_t uncompressedSize;
+  };
+
+  // reads the tables of the given archive, returns null and logs if the
+  // archive is invalid
+  //
+  static std::unique_ptr<ArchiveIndex> fromArchive(const std::wstring& archivePath,
+                                                   std::uint64_t size,
+                                                   std::uint64_t time);
+
+  // maps an index written by save(), returns null if the file doesn't exist, is
+  // invalid or is not for the given archive at this size and time
+  //
+  static std::unique_ptr<ArchiveIndex> map(const std::wstring& indexPath,
+                                           const std::wstring& archivePath,
+                                           std::uint64_t size, std::uint64_t time);
+
+  // returns the archive path stored in the given index file, empty if the file
+  // is not a valid index; used to clean up the cache
+  //
+  static std::wstring archivePathOf(const std::wstring& indexPath);
+
+  ArchiveIndex();
+  ~ArchiveIndex();
+
+  // noncopyable
+  ArchiveIndex(const ArchiveIndex&)            = delete;
+  ArchiveIndex& operator=(const ArchiveIndex&) = delete;
+
+  // writes this index to the given file
+  //
+  bool save(const std::wstring& indexPath) const;
+
+  // calls `f` for every folder, parents first, with the index of the parent
+  // folder in this order, or NoParent for the root, the name of the folder
+  // relative to its parent, and its files
+  //
+  using FolderCallback = std::function<void(
+      std::uint32_t parent, std::wstring_view name, const std::vector<File>& files)>;
+
+  void forEachFolder(const FolderCallback& f) const;
+
+  // total number of files, for logging
+  //
+  std::size_t fileCount() const { return m_FileCount; }
+
+private:
+  QByteArray m_Data;
+  QFile m_File;
+  uchar* m_Map;
+
+  // either in m_Data or in m_Map, starting after the header
+  const uchar* m_Begin;
+  const uchar* m_End;
+
+  std::size_t m_FolderCount;
+  std::size_t m_FileCount;
+
+  // reads the header and checks that the rest is valid, throws on error
+  void open(const uchar* begin, const uchar* end, const std::wstring& archivePath,
+            std::uint64_t size, std::uint64_t time);
+};
+
+// directory of archive indices, see ArchiveIndex
+//
+// get() is thread-safe and may be called for different archives concurrently
+//
+class ArchiveIndexCache
+{
+public:
+  ArchiveIndexCache();
+
+  // sets the directory where indices are stored; if empty, archives are
+  // parsed every time and nothing is written
+  //
+  void setDirectory(std::wstring dir);
+
+  // returns the index of the given archive, mapping it from the cache if it's
+  // still valid or reading the archive and updating the cache otherwise;
+  // returns null if the archive can't be read
+  //
+  // `time` receives the last write time of the archive
+  //
+  std::unique_ptr<ArchiveIndex> get(const std::wstring& archivePath,
+                                    std::uint64_t& time);
+
+  // deletes the indices of archives that don't exist anymore
+  //
+  void prune();
+
+  // number of indices mapped from the cache and built from archives since the
+  // last call, for logging
+  //
+  std::pair<std::size_t, std::size_t> takeCounts();
+
+private:
+  mutable std::mutex m_Mutex;
+  std::wstring m_Directory;
+  std::atomic<std::size_t> m_Mapped;
+  std::atomic<std::size_t> m_Built;
+
+  std::wstring indexPath(const std::wstring& archivePath) const;
+};
+
+}  // namespace MOShared
+
+#endif  // MO_REGISTER_ARCHIVEINDEX_INCLUDED
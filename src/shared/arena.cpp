@@ -0,0 +1,181 @@
+#include "arena.h"
+#include <algorithm>
+#include <new>
+#include <thread>
+
+namespace MOShared
+{
+
+Arena::Arena() = default;
+
+void* Arena::allocate(std::size_t size, std::size_t align)
+{
+  if (!pooled(size, align)) {
+    return ::operator new(size, std::align_val_t(align));
+  }
+
+  const auto c     = sizeClass(size);
+  const auto bytes = (c + 1) * Granularity;
+
+  Lane& l = lane();
+  std::scoped_lock lock(l.mutex);
+
+  if (void* p = l.free[c]) {
+    l.free[c] = *static_cast<void**>(p);
+    return p;
+  }
+
+  // padding needed to align the current pointer
+  auto padding = [&] {
+    const auto p = reinterpret_cast<std::uintptr_t>(l.current);
+    return static_cast<std::size_t>((Granularity - (p % Granularity)) % Granularity);
+  };
+
+  if (!l.current || (padding() + bytes) > l.left) {
+    // not value-initialized, there's no need to zero the block
+    l.blocks.emplace_back(new std::byte[BlockSize]);
+    l.current = l.blocks.back().get();
+    l.left    = BlockSize;
+    l.total += BlockSize;
+  }
+
+  const auto pad = padding();
+  void* p        = l.current + pad;
+
+  l.current += pad + bytes;
+  l.left -= pad + bytes;
+
+  return p;
+}
+
+void Arena::deallocate(void* p, std::size_t size, std::size_t align)
+{
+  if (!p) {
+    return;
+  }
+
+  if (!pooled(size, align)) {
+    ::operator delete(p, std::align_val_t(align));
+    return;
+  }
+
+  // any lane will do, the chunk is reused by the next thread allocating this
+  // class on it
+  Lane& l = lane();
+  std::scoped_lock lock(l.mutex);
+
+  const auto c             = sizeClass(size);
+  *static_cast<void**>(p) = l.free[c];
+  l.free[c]               = p;
+}
+
+std::size_t Arena::capacity() const
+{
+  std::size_t n = 0;
+
+  for (auto&& l : m_Lanes) {
+    std::scoped_lock lock(l.mutex);
+    n += l.total;
+  }
+
+  return n;
+}
+
+Arena::Lane& Arena::lane()
+{
+  thread_local const std::size_t hash =
+      std::hash<std::thread::id>()(std::this_thread::get_id());
+
+  return m_Lanes[hash % LaneCount];
+}
+
+bool Arena::pooled(std::size_t size, std::size_t align)
+{
+  return (size <= MaxPooledSize && align <= Granularity);
+}
+
+std::size_t Arena::sizeClass(std::size_t size)
+{
+  // a chunk must be able to hold the free list pointer
+  return (std::max<std::size_t>(size, sizeof(void*)) + Granularity - 1) / Granularity -
+         1;
+}
+
+StringPool::StringPool(std::shared_ptr<Arena> arena) : m_Arena(std::move(arena))
+{
+  for (std::size_t i = 0; i < ShardCount; ++i) {
+    m_Shards.push_back(std::make_unique<Shard>(m_Arena));
+  }
+}
+
+std::wstring_view StringPool::intern(std::wstring_view s)
+{
+  Shard& sh = shard(s);
+  std::scoped_lock lock(sh.mutex);
+
+  auto itor = sh.strings.find(s);
+  if (itor != sh.strings.end()) {
+    ++header(*itor)->refs;
+    return *itor;
+  }
+
+  auto* h = static_cast<Header*>(m_Arena->allocate(byteSize(s), alignof(Header)));
+  h->refs = 1;
+
+  auto* p = reinterpret_cast<wchar_t*>(h + 1);
+  std::copy(s.begin(), s.end(), p);
+  p[s.size()] = L'\0';
+
+  const std::wstring_view pooled(p, s.size());
+  sh.strings.insert(pooled);
+
+  return pooled;
+}
+
+void StringPool::release(std::wstring_view s)
+{
+  Shard& sh = shard(s);
+  std::scoped_lock lock(sh.mutex);
+
+  auto* h = header(s);
+  if (--h->refs > 0) {
+    return;
+  }
+
+  // `s` points into the string, it's only freed once it's out of the set
+  const auto bytes = byteSize(s);
+  sh.strings.erase(s);
+  m_Arena->deallocate(h, bytes, alignof(Header));
+}
+
+StringPool::Shard& StringPool::shard(std::wstring_view s)
+{
+  // the shard is picked from the high bits because the set uses the low ones
+  // for its buckets
+  const auto hash = std::hash<std::wstring_view>()(s);
+  return *m_Shards[(hash >> 28) % ShardCount];
+}
+
+StringPool::Header* StringPool::header(std::wstring_view s)
+{
+  return reinterpret_cast<Header*>(const_cast<wchar_t*>(s.data())) - 1;
+}
+
+std::size_t StringPool::byteSize(std::wstring_view s)
+{
+  return sizeof(Header) + (s.size() + 1) * sizeof(wchar_t);
+}
+
+std::size_t StringPool::size() const
+{
+  std::size_t n = 0;
+
+  for (auto&& shard : m_Shards) {
+    std::scoped_lock lock(shard->mutex);
+    n += shard->strings.size();
+  }
+
+  return n;
+}
+
+}  // namespace MOShared
@@ -0,0 +1,191 @@
+#ifndef MO_REGISTER_ARENA_INCLUDED
+#define MO_REGISTER_ARENA_INCLUDED
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace MOShared
+{
+
+// bump allocator handing out memory from large blocks that are only released
+// when the arena is destroyed
+//
+// this is used for the millions of small objects created by a refresh: instead
+// of one heap allocation per file entry, name and map node, the register
+// allocates a few large blocks and tearing down the tree frees them all at
+// once
+//
+// the tree is also modified in place between refreshes, so small allocations
+// are rounded up to a few size classes and deallocate() puts them on a free
+// list for their class, where the next allocation of that class picks them up;
+// larger or over-aligned allocations go to the heap and are really freed
+//
+// allocate() and deallocate() are thread-safe, threads are spread over a few
+// lanes that each have their own current block and free lists to keep
+// contention low
+//
+class Arena
+{
+public:
+  static constexpr std::size_t BlockSize = 1024 * 1024;
+
+  // allocations up to this size are served from the blocks, in multiples of
+  // Granularity
+  static constexpr std::size_t Granularity   = 16;
+  static constexpr std::size_t MaxPooledSize = 512;
+
+  Arena();
+
+  // noncopyable
+  Arena(const Arena&)            = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // returns `size` bytes aligned to `align`, never fails except by throwing
+  // std::bad_alloc
+  //
+  void* allocate(std::size_t size, std::size_t align);
+
+  // gives back memory returned by allocate() with the same size and alignment
+  //
+  void deallocate(void* p, std::size_t size, std::size_t align);
+
+  // total size of all the blocks, for logging
+  //
+  std::size_t capacity() const;
+
+private:
+  static constexpr std::size_t LaneCount  = 8;
+  static constexpr std::size_t ClassCount = MaxPooledSize / Granularity;
+
+  struct Lane
+  {
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<std::byte[]>> blocks;
+    std::byte* current = nullptr;
+    std::size_t left   = 0;
+    std::size_t total  = 0;
+
+    // heads of the free lists by size class, each free chunk starts with a
+    // pointer to the next one
+    std::array<void*, ClassCount> free = {};
+  };
+
+  std::array<Lane, LaneCount> m_Lanes;
+
+  Lane& lane();
+
+  static bool pooled(std::size_t size, std::size_t align);
+  static std::size_t sizeClass(std::size_t size);
+};
+
+// standard allocator over an Arena, used for FileEntry objects and the maps in
+// DirectoryEntry; the blocks are released when the last allocator referencing
+// the arena is gone
+//
+template <class T>
+class ArenaAllocator
+{
+public:
+  using value_type = T;
+
+  ArenaAllocator(std::shared_ptr<Arena> arena) : m_Arena(std::move(arena)) {}
+
+  template <class U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : m_Arena(other.arena())
+  {}
+
+  T* allocate(std::size_t n)
+  {
+    return static_cast<T*>(m_Arena->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n)
+  {
+    m_Arena->deallocate(p, n * sizeof(T), alignof(T));
+  }
+
+  const std::shared_ptr<Arena>& arena() const { return m_Arena; }
+
+  template <class U>
+  bool operator==(const ArenaAllocator<U>& other) const
+  {
+    return (m_Arena == other.arena());
+  }
+
+  template <class U>
+  bool operator!=(const ArenaAllocator<U>& other) const
+  {
+    return (m_Arena != other.arena());
+  }
+
+private:
+  std::shared_ptr<Arena> m_Arena;
+};
+
+// set of reference-counted strings stored in an Arena; interning the same
+// string twice returns the same view and adds a reference to it, the string is
+// freed once release() has been called as many times as intern()
+//
+// intern() and release() are thread-safe, strings are spread over shards by
+// hash
+//
+class StringPool
+{
+public:
+  StringPool(std::shared_ptr<Arena> arena);
+
+  // noncopyable
+  StringPool(const StringPool&)            = delete;
+  StringPool& operator=(const StringPool&) = delete;
+
+  // returns the pooled copy of `s`, adding it if needed; the view is
+  // null-terminated
+  //
+  std::wstring_view intern(std::wstring_view s);
+
+  // drops a reference to a string returned by intern()
+  //
+  void release(std::wstring_view s);
+
+  // number of distinct strings, for logging
+  //
+  std::size_t size() const;
+
+private:
+  static constexpr std::size_t ShardCount = 16;
+
+  // stored right before the characters of every string
+  struct Header
+  {
+    std::size_t refs;
+  };
+
+  using Set = std::unordered_set<std::wstring_view, std::hash<std::wstring_view>,
+                                 std::equal_to<std::wstring_view>,
+                                 ArenaAllocator<std::wstring_view>>;
+
+  struct Shard
+  {
+    mutable std::mutex mutex;
+    Set strings;
+
+    Shard(const std::shared_ptr<Arena>& arena)
+        : strings(ArenaAllocator<std::wstring_view>(arena))
+    {}
+  };
+
+  std::shared_ptr<Arena> m_Arena;
+  std::vector<std::unique_ptr<Shard>> m_Shards;
+
+  Shard& shard(std::wstring_view s);
+  static Header* header(std::wstring_view s);
+  static std::size_t byteSize(std::wstring_view s);
+};
+
+}  // namespace MOShared
+
+#endif  // MO_REGISTER_ARENA_INCLUDED
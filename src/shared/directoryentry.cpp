@@ -19,6 +19,8 @@ along with Mod Organizer.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "directoryentry.h"
 #include "../envfs.h"
+#include "archiveindex.h"
+#include "../thread_utils.h"
 #include "fileentry.h"
 #include "filesorigin.h"
 #include "originconnection.h"
@@ -33,23 +35,21 @@ namespace MOShared
 using namespace MOBase;
 const int MAXPATH_UNICODE = 32767;
 
+// adds the time taken by `f` to `out` if the refresh is being profiled; when
+// it isn't, this only costs a relaxed load
+//
 template <class F>
-void elapsedImpl(std::chrono::nanoseconds& out, F&& f)
+void elapsed(std::chrono::nanoseconds& out, F&& f)
 {
-  if constexpr (DirectoryStats::EnableInstrumentation) {
-    const auto start = std::chrono::high_resolution_clock::now();
-    f();
-    const auto end = std::chrono::high_resolution_clock::now();
-    out += (end - start);
-  } else {
+  if (!DirectoryStats::enabled()) {
     f();
+    return;
   }
-}
 
-// elapsed() is not optimized out when EnableInstrumentation is false even
-// though it's equivalent that this macro
-#define elapsed(OUT, F) (F)();
-// #define elapsed(OUT, F) elapsedImpl(OUT, F);
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  out += (std::chrono::steady_clock::now() - start);
+}
 
 static bool SupportOptimizedFind()
 {
@@ -76,33 +76,57 @@ bool DirCompareByName::operator()(const DirectoryEntry* lhs,
 }
 
 DirectoryEntry::DirectoryEntry(std::wstring name, DirectoryEntry* parent, int originID)
-    : m_OriginConnection(new OriginConnection), m_Name(std::move(name)),
-      m_Parent(parent), m_Populated(false), m_TopLevel(true)
+    : m_OriginConnection(new OriginConnection),
+      m_FileRegister(new FileRegister(m_OriginConnection)), m_Name(std::move(name)),
+      m_Files(m_FileRegister->arena()), m_FilesLookup(m_FileRegister->arena()),
+      m_SubDirectoriesLookup(m_FileRegister->arena()), m_Parent(parent),
+      m_Populated(false), m_TopLevel(true)
 {
-  m_FileRegister.reset(new FileRegister(m_OriginConnection));
   m_Origins.insert(originID);
 }
 
 DirectoryEntry::DirectoryEntry(std::wstring name, DirectoryEntry* parent, int originID,
                                boost::shared_ptr<FileRegister> fileRegister,
                                boost::shared_ptr<OriginConnection> originConnection)
-    : m_FileRegister(fileRegister), m_OriginConnection(originConnection),
-      m_Name(std::move(name)), m_Parent(parent), m_Populated(false), m_TopLevel(false)
+    : m_OriginConnection(originConnection), m_FileRegister(fileRegister),
+      m_Name(std::move(name)), m_Files(m_FileRegister->arena()),
+      m_FilesLookup(m_FileRegister->arena()),
+      m_SubDirectoriesLookup(m_FileRegister->arena()), m_Parent(parent),
+      m_Populated(false), m_TopLevel(false)
 {
   m_Origins.insert(originID);
 }
 
 DirectoryEntry::~DirectoryEntry()
 {
-  clear();
+  // the names don't need to be released when the whole tree goes away, the
+  // pool goes with the register
+  clearEntries(!m_TopLevel);
 }
 
 void DirectoryEntry::clear()
+{
+  clearEntries(true);
+}
+
+void DirectoryEntry::clearEntries(bool releaseNames)
 {
   for (auto itor = m_SubDirectories.rbegin(); itor != m_SubDirectories.rend(); ++itor) {
+    (*itor)->clearEntries(releaseNames);
     delete *itor;
   }
 
+  if (releaseNames) {
+    // both file maps share the same key
+    for (auto&& p : m_Files) {
+      m_FileRegister->releaseName(p.first);
+    }
+
+    for (auto&& p : m_SubDirectoriesLookup) {
+      m_FileRegister->releaseName(p.first);
+    }
+  }
+
   m_Files.clear();
   m_FilesLookup.clear();
   m_SubDirectories.clear();
@@ -135,8 +159,6 @@ void DirectoryEntry::addFromList(const std::wstring& originName,
                                  const std::wstring& directory, env::Directory& root,
                                  int priority, DirectoryStats& stats)
 {
-  stats = {};
-
   FilesOrigin& origin = createOrigin(originName, directory, priority, stats);
   addDir(origin, root, stats);
 }
@@ -153,7 +175,7 @@ void DirectoryEntry::addDir(FilesOrigin& origin, env::Directory& d,
 
   elapsed(stats.fileTimes, [&] {
     for (auto& f : d.files) {
-      insert(f, origin, L"", -1, stats);
+      insert(f, origin, {}, stats);
     }
   });
 
@@ -165,7 +187,7 @@ void DirectoryEntry::addFromAllBSAs(const std::wstring& originName,
                                     const std::vector<std::wstring>& archives,
                                     const std::set<std::wstring>& enabledArchives,
                                     const std::vector<std::wstring>& loadOrder,
-                                    DirectoryStats& stats)
+                                    DirectoryStats& stats, ArchiveIndexCache* indexes)
 {
   for (const auto& archive : archives) {
     const std::filesystem::path archivePath(archive);
@@ -192,14 +214,16 @@ void DirectoryEntry::addFromAllBSAs(const std::wstring& originName,
       }
     }
 
-    addFromBSA(originName, directory, archivePath.native(), priority, order, stats);
+    addFromBSA(originName, directory, archivePath.native(), priority, order, stats,
+               indexes);
   }
 }
 
 void DirectoryEntry::addFromBSA(const std::wstring& originName,
                                 const std::wstring& directory,
                                 const std::wstring& archivePath, int priority,
-                                int order, DirectoryStats& stats)
+                                int order, DirectoryStats& stats,
+                                ArchiveIndexCache* indexes)
 {
   FilesOrigin& origin    = createOrigin(originName, directory, priority, stats);
   const auto archiveName = std::filesystem::path(archivePath).filename().native();
@@ -208,39 +232,213 @@ void DirectoryEntry::addFromBSA(const std::wstring& originName,
     return;
   }
 
-  BSA::Archive archive;
-  BSA::EErrorCode res = BSA::ERROR_NONE;
+  // without a cache directory, the archive is always read
+  ArchiveIndexCache uncached;
+  if (!indexes) {
+    indexes = &uncached;
+  }
+
+  std::uint64_t time = 0;
+  auto index         = indexes->get(archivePath, time);
 
-  try {
-    // read() can return an error, but it can also throw if the file is not a
-    // valid bsa
-    res = archive.read(ToString(archivePath, false).c_str(), false);
-  } catch (std::exception& e) {
-    log::error("invalid bsa '{}', error {}", archivePath, e.what());
+  if (!index) {
+    // already logged
     return;
   }
 
-  if ((res != BSA::ERROR_NONE) && (res != BSA::ERROR_INVALIDHASHES)) {
-    log::error("invalid bsa '{}', error {}", archivePath, res);
-    return;
+  FILETIME ft;
+  ft.dwLowDateTime  = static_cast<DWORD>(time & 0xffffffff);
+  ft.dwHighDateTime = static_cast<DWORD>(time >> 32);
+
+  addFiles(origin, *index, ft, archiveName, order, stats);
+
+  m_Populated = true;
+}
+
+// files inserted by one thread in addFromLists()
+//
+struct DirectoryEntry::MergeShard
+{
+  struct Work
+  {
+    DirectoryEntry* dir;
+    FilesOrigin* origin;
+    env::Directory* source;
+  };
+
+  // files to add to the directories owned by this shard, in the order of the
+  // origins
+  std::vector<Work> work;
+
+  // files created by this shard, not in the register yet; entries are in index
+  // order, starting at `first`
+  std::vector<FileEntryPtr> created;
+
+  // indices reserved for this shard, exactly as many as there are new files so
+  // the register doesn't get holes, see countNew()
+  FileIndex first    = 0;
+  std::size_t needed = 0;
+
+  // indices added to each origin, given to the origin in one call at the end
+  std::vector<std::pair<FilesOrigin*, std::vector<FileIndex>>> originFiles;
+
+  DirectoryStats stats;
+
+  // counts the files that are not in their directory yet, a file found in
+  // multiple origins is only counted once; this is exactly the number of files
+  // the shard will create, the directories are not changed in between
+  //
+  void countNew()
+  {
+    std::unordered_map<const DirectoryEntry*, std::unordered_set<std::wstring_view>>
+        added;
+
+    needed = 0;
+
+    for (auto& w : work) {
+      for (auto& f : w.source->files) {
+        if (w.dir->m_FilesLookup.find(f.lcname) != w.dir->m_FilesLookup.end()) {
+          continue;
+        }
+
+        if (added[w.dir].insert(f.lcname).second) {
+          ++needed;
+        }
+      }
+    }
+  }
+
+  FileIndex newIndex()
+  {
+    return first + static_cast<FileIndex>(created.size());
   }
 
-  std::error_code ec;
-  const auto lwt = std::filesystem::last_write_time(archivePath, ec);
-  FILETIME ft    = {};
+  // file created by this shard, or null if it was created before
+  //
+  FileEntryPtr findCreated(FileIndex index) const
+  {
+    if (index < first || index - first >= created.size()) {
+      return {};
+    }
 
-  if (ec) {
-    log::warn("failed to get last modified date for '{}', {}", archivePath,
-              ec.message());
-  } else {
-    ft = ToFILETIME(lwt);
+    return created[index - first];
+  }
+
+  void addToOrigin(FilesOrigin& origin, FileIndex index)
+  {
+    if (originFiles.empty() || originFiles.back().first != &origin) {
+      originFiles.push_back({&origin, {}});
+    }
+
+    originFiles.back().second.push_back(index);
+  }
+};
+
+void DirectoryEntry::addFromLists(std::vector<OriginList>& lists,
+                                  std::size_t threadCount, DirectoryStats& stats)
+{
+  threadCount = std::max<std::size_t>(threadCount, 1);
+
+  // more shards than threads, large directories would otherwise leave threads
+  // idle at the end
+  std::vector<MergeShard> shards(threadCount * 4);
+
+  for (auto& list : lists) {
+    FilesOrigin& origin =
+        createOrigin(list.originName, list.directory, list.priority, stats);
+
+    propagateOrigin(origin.getID());
+    addDirForMerge(origin, *list.root, shards, stats);
+  }
+
+  parallelMap(
+      shards.begin(), shards.end(),
+      [](MergeShard& shard) {
+        shard.countNew();
+      },
+      threadCount);
+
+  for (auto& shard : shards) {
+    shard.first = m_FileRegister->reserveIndices(shard.needed);
   }
 
-  addFiles(origin, archive.getRoot(), ft, archiveName, order, stats);
+  parallelMap(
+      shards.begin(), shards.end(),
+      [](MergeShard& shard) {
+        for (auto& w : shard.work) {
+          for (auto& f : w.source->files) {
+            w.dir->insertForMerge(f, *w.origin, shard);
+          }
+        }
+
+        for (auto& [origin, indices] : shard.originFiles) {
+          origin->addFiles(indices);
+        }
+      },
+      threadCount);
+
+  for (auto& shard : shards) {
+    m_FileRegister->addFiles(std::move(shard.created));
+    stats += shard.stats;
+  }
 
   m_Populated = true;
 }
 
+void DirectoryEntry::addDirForMerge(FilesOrigin& origin, env::Directory& d,
+                                    std::vector<MergeShard>& shards,
+                                    DirectoryStats& stats)
+{
+  // the origin is added to every directory here instead of being propagated
+  // for every file
+  {
+    std::scoped_lock lock(m_OriginsMutex);
+    m_Origins.insert(origin.getID());
+  }
+
+  if (!d.files.empty()) {
+    const auto shard = std::hash<const DirectoryEntry*>()(this) % shards.size();
+    shards[shard].work.push_back({this, &origin, &d});
+  }
+
+  for (auto& sd : d.dirs) {
+    auto* sdirEntry = getSubDirectory(sd, true, stats, origin.getID());
+    sdirEntry->addDirForMerge(origin, sd, shards, stats);
+  }
+
+  m_Populated = true;
+}
+
+void DirectoryEntry::insertForMerge(env::File& file, FilesOrigin& origin,
+                                    MergeShard& shard)
+{
+  // this directory is only used by the thread owning the shard, no locking
+  FileEntryPtr fe;
+
+  auto itor = m_FilesLookup.find(file.lcname);
+
+  if (itor != m_FilesLookup.end()) {
+    ++shard.stats.fileExists;
+
+    fe = shard.findCreated(itor->second);
+    if (!fe) {
+      fe = m_FileRegister->getFile(itor->second);
+    }
+  } else {
+    ++shard.stats.fileCreate;
+
+    const auto index = shard.newIndex();
+    fe               = m_FileRegister->makeFile(index, std::move(file.name), this);
+    // file.name has been moved from this point
+
+    shard.created.push_back(fe);
+    addFileToList(m_FileRegister->internName(file.lcname), index);
+  }
+
+  fe->addOrigin(origin.getID(), file.lastModified, {}, false);
+  shard.addToOrigin(origin, fe->getIndex());
+}
+
 void DirectoryEntry::propagateOrigin(int origin)
 {
   {
@@ -296,6 +494,12 @@ int DirectoryEntry::anyOrigin() const
   return *(m_Origins.begin());
 }
 
+std::set<OriginID> DirectoryEntry::getOrigins() const
+{
+  std::scoped_lock lock(m_OriginsMutex);
+  return m_Origins;
+}
+
 std::vector<FileEntryPtr> DirectoryEntry::getFiles() const
 {
   std::vector<FileEntryPtr> result;
@@ -337,9 +541,9 @@ const FileEntryPtr DirectoryEntry::findFile(const std::wstring& name,
   FilesLookup::const_iterator iter;
 
   if (alreadyLowerCase) {
-    iter = m_FilesLookup.find(DirectoryEntryFileKey(name));
+    iter = m_FilesLookup.find(name);
   } else {
-    iter = m_FilesLookup.find(DirectoryEntryFileKey(ToLowerCopy(name)));
+    iter = m_FilesLookup.find(ToLowerCopy(name));
   }
 
   if (iter != m_FilesLookup.end()) {
@@ -351,7 +555,7 @@ const FileEntryPtr DirectoryEntry::findFile(const std::wstring& name,
 
 const FileEntryPtr DirectoryEntry::findFile(const DirectoryEntryFileKey& key) const
 {
-  auto iter = m_FilesLookup.find(key);
+  auto iter = m_FilesLookup.find(key.value);
 
   if (iter != m_FilesLookup.end()) {
     return m_FileRegister->getFile(iter->second);
@@ -527,22 +731,119 @@ void DirectoryEntry::removeFiles(const std::set<FileIndex>& indices)
   removeFilesFromList(indices);
 }
 
+// whether the given origin provides the file as a loose file, either as the
+// primary origin or as one of the alternatives
+//
+static bool isLooseFrom(const FileEntry& file, OriginID originID)
+{
+  if (file.getOrigin() == originID) {
+    return !file.getArchive().isValid();
+  }
+
+  for (auto&& alt : file.getAlternatives()) {
+    if (alt.originID() == originID) {
+      return !alt.isFromArchive();
+    }
+  }
+
+  return false;
+}
+
+void DirectoryEntry::updateFromOrigin(FilesOrigin& origin, const std::wstring& path,
+                                      std::set<FileIndex>& touched,
+                                      DirectoryStats& stats)
+{
+  const std::filesystem::path relative(path);
+  const std::wstring dirPath = relative.parent_path().native();
+  const std::wstring name    = relative.filename().native();
+
+  const std::wstring fullPath =
+      path.empty() ? origin.getPath() : origin.getPath() + L"\\" + path;
+
+  WIN32_FILE_ATTRIBUTE_DATA data = {};
+  const bool exists =
+      ::GetFileAttributesExW(fullPath.c_str(), GetFileExInfoStandard, &data);
+
+  const bool isDir = exists && (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY);
+
+  // loose files the origin had at this path, they're removed before walking
+  // the path again since it may have changed from a directory to a file or the
+  // other way around
+  std::set<FileIndex> removed;
+
+  if (path.empty()) {
+    getOriginFilesRecursive(origin.getID(), removed);
+  } else if (auto* parent = getSubDirectoryRecursive(dirPath, false, stats)) {
+    if (auto file = parent->findFile(name)) {
+      if (isLooseFrom(*file, origin.getID())) {
+        if (exists && !isDir) {
+          // file was modified, it keeps its index
+          if (file->getOrigin() == origin.getID()) {
+            file->setFileTime(data.ftLastWriteTime);
+          }
+
+          touched.insert(file->getIndex());
+          return;
+        }
+
+        removed.insert(file->getIndex());
+      }
+    }
+
+    if (auto* d = parent->findSubDirectory(name)) {
+      d->getOriginFilesRecursive(origin.getID(), removed);
+    }
+  }
+
+  if (!removed.empty()) {
+    for (const auto index : removed) {
+      origin.removeFile(index);
+    }
+
+    touched.insert(removed.begin(), removed.end());
+    m_FileRegister->removeOriginMulti(removed, origin.getID());
+  }
+
+  if (!exists) {
+    return;
+  }
+
+  if (path.empty()) {
+    env::Directory dir = env::getFilesAndDirsWithFind(fullPath);
+
+    addDir(origin, dir, stats);
+    getOriginFilesRecursive(origin.getID(), touched);
+    return;
+  }
+
+  auto* parent = getSubDirectoryRecursive(dirPath, true, stats, origin.getID());
+
+  if (isDir) {
+    env::Directory dir = env::getFilesAndDirsWithFind(fullPath);
+
+    auto* d = parent->getSubDirectory(name, true, stats, origin.getID());
+    d->addDir(origin, dir, stats);
+    d->getOriginFilesRecursive(origin.getID(), touched);
+  } else {
+    auto file = parent->insert(name, origin, data.ftLastWriteTime, {}, stats);
+    touched.insert(file->getIndex());
+  }
+}
+
 FileEntryPtr DirectoryEntry::insert(std::wstring_view fileName, FilesOrigin& origin,
-                                    FILETIME fileTime, std::wstring_view archive,
-                                    int order, DirectoryStats& stats)
+                                    FILETIME fileTime, const DataArchiveOrigin& archive,
+                                    DirectoryStats& stats)
 {
-  std::wstring fileNameLower = ToLowerCopy(fileName);
+  const std::wstring fileNameLower = ToLowerCopy(fileName);
   FileEntryPtr fe;
 
-  DirectoryEntryFileKey key(std::move(fileNameLower));
-
   {
     std::unique_lock lock(m_FilesMutex);
 
     FilesLookup::iterator itor;
 
     elapsed(stats.filesLookupTimes, [&] {
-      itor = m_FilesLookup.find(key);
+      itor = m_FilesLookup.find(fileNameLower);
     });
 
     if (itor != m_FilesLookup.end()) {
@@ -555,15 +856,13 @@ FileEntryPtr DirectoryEntry::insert(std::wstring_view fileName, FilesOrigin& ori
                                       this, stats);
 
       elapsed(stats.addFileTimes, [&] {
-        addFileToList(std::move(key.value), fe->getIndex());
+        addFileToList(m_FileRegister->internName(fileNameLower), fe->getIndex());
       });
-
-      // fileNameLower has moved from this point
     }
   }
 
   elapsed(stats.addOriginToFileTimes, [&] {
-    fe->addOrigin(origin.getID(), fileTime, archive, order);
+    fe->addOrigin(origin.getID(), fileTime, archive);
   });
 
   elapsed(stats.addFileToOriginTimes, [&] {
@@ -574,7 +873,7 @@ FileEntryPtr DirectoryEntry::insert(std::wstring_view fileName, FilesOrigin& ori
 }
 
 FileEntryPtr DirectoryEntry::insert(env::File& file, FilesOrigin& origin,
-                                    std::wstring_view archive, int order,
+                                    const DataArchiveOrigin& archive,
                                     DirectoryStats& stats)
 {
   FileEntryPtr fe;
@@ -598,15 +897,13 @@ FileEntryPtr DirectoryEntry::insert(env::File& file, FilesOrigin& origin,
       // file.name has been moved from this point
 
       elapsed(stats.addFileTimes, [&] {
-        addFileToList(std::move(file.lcname), fe->getIndex());
+        addFileToList(m_FileRegister->internName(file.lcname), fe->getIndex());
       });
-
-      // file.lcname has been moved from this point
     }
   }
 
   elapsed(stats.addOriginToFileTimes, [&] {
-    fe->addOrigin(origin.getID(), file.lastModified, archive, order);
+    fe->addOrigin(origin.getID(), file.lastModified, archive);
   });
 
   elapsed(stats.addFileToOriginTimes, [&] {
@@ -664,47 +961,49 @@ void DirectoryEntry::onDirectoryEnd(Context* cx, std::wstring_view path)
 void DirectoryEntry::onFile(Context* cx, std::wstring_view path, FILETIME ft)
 {
   elapsed(cx->stats.fileTimes, [&] {
-    cx->current.top()->insert(path, cx->origin, ft, L"", -1, cx->stats);
+    cx->current.top()->insert(path, cx->origin, ft, {}, cx->stats);
   });
 }
 
-void DirectoryEntry::addFiles(FilesOrigin& origin, const BSA::Folder::Ptr archiveFolder,
+void DirectoryEntry::addFiles(FilesOrigin& origin, const ArchiveIndex& index,
                               FILETIME fileTime, const std::wstring& archiveName,
                               int order, DirectoryStats& stats)
 {
-  // add files
-  const auto fileCount = archiveFolder->getNumFiles();
-  for (unsigned int i = 0; i < fileCount; ++i) {
-    const BSA::File::Ptr file = archiveFolder->getFile(i);
+  const DataArchiveOrigin archive(m_FileRegister->internArchiveName(archiveName),
+                                  order);
 
-    auto f = insert(ToWString(file->getName(), true), origin, fileTime, archiveName,
-                    order, stats);
+  // entries of the folders seen so far, in the order of the index
+  std::vector<DirectoryEntry*> entries;
 
-    if (f) {
-      if (file->getUncompressedFileSize() > 0) {
-        f->setFileSize(file->getFileSize(), file->getUncompressedFileSize());
-      } else {
-        f->setFileSize(file->getFileSize(), FileEntry::NoFileSize);
-      }
+  index.forEachFolder([&](std::uint32_t parent, std::wstring_view name,
+                          const std::vector<ArchiveIndex::File>& files) {
+    DirectoryEntry* entry = this;
+
+    if (parent != ArchiveIndex::NoParent) {
+      entry = entries[parent]->getSubDirectoryRecursive(std::wstring(name), true,
+                                                        stats, origin.getID());
     }
-  }
 
-  // recurse into subdirectories
-  const auto dirCount = archiveFolder->getNumSubFolders();
-  for (unsigned int i = 0; i < dirCount; ++i) {
-    const BSA::Folder::Ptr folder = archiveFolder->getSubFolder(i);
+    entries.push_back(entry);
 
-    DirectoryEntry* folderEntry = getSubDirectoryRecursive(
-        ToWString(folder->getName(), true), true, stats, origin.getID());
+    for (auto&& file : files) {
+      auto f = entry->insert(file.name, origin, fileTime, archive, stats);
 
-    folderEntry->addFiles(origin, folder, fileTime, archiveName, order, stats);
-  }
+      if (f) {
+        if (file.uncompressedSize > 0) {
+          f->setFileSize(file.size, file.uncompressedSize);
+        } else {
+          f->setFileSize(file.size, FileEntry::NoFileSize);
+        }
+      }
+    }
+  });
 }
 
 DirectoryEntry* DirectoryEntry::getSubDirectory(std::wstring_view name, bool create,
                                                 DirectoryStats& stats, int originID)
 {
-  std::wstring nameLc = ToLowerCopy(name);
+  const std::wstring nameLc = ToLowerCopy(name);
 
   std::scoped_lock lock(m_SubDirMutex);
 
@@ -725,8 +1024,7 @@ DirectoryEntry* DirectoryEntry::getSubDirectory(std::wstring_view name, bool cre
                                      originID, m_FileRegister, m_OriginConnection);
 
     elapsed(stats.addDirectoryTimes, [&] {
-      addDirectoryToList(entry, std::move(nameLc));
-      // nameLc is moved from this point
+      addDirectoryToList(entry, m_FileRegister->internName(nameLc));
     });
 
     return entry;
@@ -759,11 +1057,9 @@ DirectoryEntry* DirectoryEntry::getSubDirectory(env::Directory& dir, bool create
     // dir.name is moved from this point
 
     elapsed(stats.addDirectoryTimes, [&] {
-      addDirectoryToList(entry, std::move(dir.lcname));
+      addDirectoryToList(entry, m_FileRegister->internName(dir.lcname));
     });
 
-    // dir.lcname is moved from this point
-
     return entry;
   } else {
     return nullptr;
@@ -810,14 +1106,37 @@ void DirectoryEntry::removeDirRecursive()
     delete entry;
   }
 
+  for (auto&& p : m_SubDirectoriesLookup) {
+    m_FileRegister->releaseName(p.first);
+  }
+
   m_SubDirectories.clear();
   m_SubDirectoriesLookup.clear();
 }
 
-void DirectoryEntry::addDirectoryToList(DirectoryEntry* e, std::wstring nameLc)
+void DirectoryEntry::getOriginFilesRecursive(OriginID originID,
+                                             std::set<FileIndex>& out) const
+{
+  for (auto&& p : m_Files) {
+    auto file = m_FileRegister->getFile(p.second);
+    if (!file) {
+      continue;
+    }
+
+    if (isLooseFrom(*file, originID)) {
+      out.insert(p.second);
+    }
+  }
+
+  for (const auto* d : m_SubDirectories) {
+    d->getOriginFilesRecursive(originID, out);
+  }
+}
+
+void DirectoryEntry::addDirectoryToList(DirectoryEntry* e, std::wstring_view nameLc)
 {
   m_SubDirectories.insert(e);
-  m_SubDirectoriesLookup.emplace(std::move(nameLc), e);
+  m_SubDirectoriesLookup.emplace(nameLc, e);
 }
 
 void DirectoryEntry::removeDirectoryFromList(SubDirectories::iterator itor)
@@ -833,7 +1152,9 @@ void DirectoryEntry::removeDirectoryFromList(SubDirectories::iterator itor)
     if (itor2 == m_SubDirectoriesLookup.end()) {
       log::error("entry {} not in sub directories map", entry->getName());
     } else {
+      const auto name = itor2->first;
       m_SubDirectoriesLookup.erase(itor2);
+      m_FileRegister->releaseName(name);
     }
   }
 
@@ -842,7 +1163,8 @@ void DirectoryEntry::removeDirectoryFromList(SubDirectories::iterator itor)
 
 void DirectoryEntry::removeFileFromList(FileIndex index)
 {
-  auto removeFrom = [&](auto& list) {
+  // returns the key that was removed, if any
+  auto removeFrom = [&](auto& list) -> std::optional<std::wstring_view> {
     auto iter = std::find_if(list.begin(), list.end(), [&index](auto&& pair) {
       return (pair.second == index);
     });
@@ -858,19 +1180,31 @@ void DirectoryEntry::removeFileFromList(FileIndex index)
                    "not in register",
                    index, getName());
       }
+
+      return {};
     } else {
+      const auto name = iter->first;
       list.erase(iter);
+      return name;
     }
   };
 
   removeFrom(m_FilesLookup);
-  removeFrom(m_Files);
+
+  // both maps share the same key, it's only released once
+  if (auto name = removeFrom(m_Files)) {
+    m_FileRegister->releaseName(*name);
+  }
 }
 
 void DirectoryEntry::removeFilesFromList(const std::set<FileIndex>& indices)
 {
+  // keys are released once both maps are done with them
+  std::vector<std::wstring_view> names;
+
   for (auto iter = m_Files.begin(); iter != m_Files.end();) {
     if (indices.find(iter->second) != indices.end()) {
+      names.push_back(iter->first);
       iter = m_Files.erase(iter);
     } else {
       ++iter;
@@ -884,13 +1218,16 @@ void DirectoryEntry::removeFilesFromList(const std::set<FileIndex>& indices)
       ++iter;
     }
   }
+
+  for (auto&& name : names) {
+    m_FileRegister->releaseName(name);
+  }
 }
 
-void DirectoryEntry::addFileToList(std::wstring fileNameLower, FileIndex index)
+void DirectoryEntry::addFileToList(std::wstring_view fileNameLower, FileIndex index)
 {
   m_FilesLookup.emplace(fileNameLower, index);
-  m_Files.emplace(std::move(fileNameLower), index);
-  // fileNameLower has been moved from this point
+  m_Files.emplace(fileNameLower, index);
 }
 
 struct DumpFailed : public std::runtime_error
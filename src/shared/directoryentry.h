@@ -67,6 +67,9 @@ public:
   DirectoryEntry(const DirectoryEntry&)            = delete;
   DirectoryEntry& operator=(const DirectoryEntry&) = delete;
 
+  // removes all the files and directories without touching the register,
+  // releases their names
+  //
   void clear();
 
   bool isPopulated() const { return m_Populated; }
@@ -88,19 +91,50 @@ public:
                      const std::wstring& directory, int priority,
                      DirectoryStats& stats);
 
+  // archives are read through `indexes` if given, see ArchiveIndexCache
+  //
   void addFromAllBSAs(const std::wstring& originName, const std::wstring& directory,
                       int priority, const std::vector<std::wstring>& archives,
                       const std::set<std::wstring>& enabledArchives,
                       const std::vector<std::wstring>& loadOrder,
-                      DirectoryStats& stats);
+                      DirectoryStats& stats, ArchiveIndexCache* indexes = nullptr);
 
   void addFromBSA(const std::wstring& originName, const std::wstring& directory,
                   const std::wstring& archivePath, int priority, int order,
-                  DirectoryStats& stats);
+                  DirectoryStats& stats, ArchiveIndexCache* indexes = nullptr);
 
   void addFromList(const std::wstring& originName, const std::wstring& directory,
                    env::Directory& root, int priority, DirectoryStats& stats);
 
+  // loose files of an origin that were listed from disk, see addFromLists()
+  //
+  struct OriginList
+  {
+    std::wstring originName;
+    std::wstring directory;
+    int priority;
+    env::Directory* root;
+  };
+
+  // adds the files of multiple origins at once, origins are created in the
+  // given order
+  //
+  // all the directories are created first on the calling thread; the files
+  // are then inserted by `threadCount` threads, each one owning a shard of the
+  // directories so that the directories, their files and the register don't
+  // need locking for every file
+  //
+  // indices are reserved for exactly the number of new files, the register
+  // doesn't get holes
+  //
+  // nothing else may use this structure while it runs; the live structure is
+  // only updated from the main thread, which is the only one reading it, and
+  // never while a refresh is running, see
+  // OrganizerCore::updateModsInDirectoryStructure()
+  //
+  void addFromLists(std::vector<OriginList>& lists, std::size_t threadCount,
+                    DirectoryStats& stats);
+
   void propagateOrigin(OriginID origin);
 
   const std::wstring& getName() const { return m_Name; }
@@ -114,6 +148,11 @@ public:
 
   OriginID anyOrigin() const;
 
+  // origins that have this directory, including the ones that only have it
+  // empty or in an archive
+  //
+  std::set<OriginID> getOrigins() const;
+
   std::vector<FileEntryPtr> getFiles() const;
 
   const SubDirectories& getSubDirectories() const { return m_SubDirectories; }
@@ -202,15 +241,38 @@ public:
 
   void removeFiles(const std::set<FileIndex>& indices);
 
+  // brings a file or directory of the given origin up to date after it has
+  // changed on disk; `path` is relative to the origin, an empty path rescans
+  // all of its loose files
+  //
+  // a file that still exists is added or has its time updated, a directory is
+  // walked again and a path that doesn't exist anymore is removed from the
+  // origin along with everything under it; the indices of all the files that
+  // gained or lost the origin are added to `touched`
+  //
+  void updateFromOrigin(FilesOrigin& origin, const std::wstring& path,
+                        std::set<FileIndex>& touched, DirectoryStats& stats);
+
   void dump(const std::wstring& file) const;
 
 private:
-  using FilesMap             = std::map<std::wstring, FileIndex>;
-  using FilesLookup          = std::unordered_map<DirectoryEntryFileKey, FileIndex>;
-  using SubDirectoriesLookup = std::unordered_map<std::wstring, DirectoryEntry*>;
+  // keys are lowercase names interned in the file register and nodes are
+  // allocated from its arena, see FileRegister::arena()
+  template <class T>
+  using NameMap =
+      std::unordered_map<std::wstring_view, T, std::hash<std::wstring_view>,
+                         std::equal_to<std::wstring_view>,
+                         ArenaAllocator<std::pair<const std::wstring_view, T>>>;
+
+  using FilesMap =
+      std::map<std::wstring_view, FileIndex, std::less<>,
+               ArenaAllocator<std::pair<const std::wstring_view, FileIndex>>>;
+
+  using FilesLookup          = NameMap<FileIndex>;
+  using SubDirectoriesLookup = NameMap<DirectoryEntry*>;
 
-  boost::shared_ptr<FileRegister> m_FileRegister;
   boost::shared_ptr<OriginConnection> m_OriginConnection;
+  boost::shared_ptr<FileRegister> m_FileRegister;
 
   std::wstring m_Name;
   FilesMap m_Files;
@@ -227,20 +289,25 @@ private:
   mutable std::mutex m_OriginsMutex;
 
   FileEntryPtr insert(std::wstring_view fileName, FilesOrigin& origin,
-                      FILETIME fileTime, std::wstring_view archive, int order,
+                      FILETIME fileTime, const DataArchiveOrigin& archive,
                       DirectoryStats& stats);
 
-  FileEntryPtr insert(env::File& file, FilesOrigin& origin, std::wstring_view archive,
-                      int order, DirectoryStats& stats);
+  FileEntryPtr insert(env::File& file, FilesOrigin& origin,
+                      const DataArchiveOrigin& archive, DirectoryStats& stats);
 
   void addFiles(env::DirectoryWalker& walker, FilesOrigin& origin,
                 const std::wstring& path, DirectoryStats& stats);
 
-  void addFiles(FilesOrigin& origin, BSA::Folder::Ptr archiveFolder, FILETIME fileTime,
+  void addFiles(FilesOrigin& origin, const ArchiveIndex& index, FILETIME fileTime,
                 const std::wstring& archiveName, int order, DirectoryStats& stats);
 
   void addDir(FilesOrigin& origin, env::Directory& d, DirectoryStats& stats);
 
+  struct MergeShard;
+  void addDirForMerge(FilesOrigin& origin, env::Directory& d,
+                      std::vector<MergeShard>& shards, DirectoryStats& stats);
+  void insertForMerge(env::File& file, FilesOrigin& origin, MergeShard& shard);
+
   DirectoryEntry* getSubDirectory(std::wstring_view name, bool create,
                                   DirectoryStats& stats,
                                   OriginID originID = InvalidOriginID);
@@ -255,10 +322,19 @@ private:
 
   void removeDirRecursive();
 
-  void addDirectoryToList(DirectoryEntry* e, std::wstring nameLc);
+  // deletes the subdirectories and empties the maps, names are only released
+  // if `releaseNames` is true
+  //
+  void clearEntries(bool releaseNames);
+
+  // adds the indices of the files in this directory and all subdirectories
+  // that are provided by the given origin as loose files
+  void getOriginFilesRecursive(OriginID originID, std::set<FileIndex>& out) const;
+
+  void addDirectoryToList(DirectoryEntry* e, std::wstring_view nameLc);
   void removeDirectoryFromList(SubDirectories::iterator itor);
 
-  void addFileToList(std::wstring fileNameLower, FileIndex index);
+  void addFileToList(std::wstring_view fileNameLower, FileIndex index);
   void removeFileFromList(FileIndex index);
   void removeFilesFromList(const std::set<FileIndex>& indices);
 
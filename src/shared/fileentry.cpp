@@ -5,22 +5,25 @@
 namespace MOShared
 {
 
+// mutexes shared by all file entries, see FileEntry::originsMutex()
+static std::array<std::mutex, 64> g_originsMutexes;
+
 FileEntry::FileEntry()
     : m_Index(InvalidFileIndex), m_Name(), m_Origin(-1), m_Parent(nullptr),
       m_FileSize(NoFileSize), m_CompressedFileSize(NoFileSize)
 {}
 
 FileEntry::FileEntry(FileIndex index, std::wstring name, DirectoryEntry* parent)
-    : m_Index(index), m_Name(std::move(name)), m_Origin(-1), m_Archive(L"", -1),
-      m_Parent(parent), m_FileSize(NoFileSize), m_CompressedFileSize(NoFileSize)
+    : m_Index(index), m_Name(std::move(name)), m_Origin(-1), m_Parent(parent),
+      m_FileSize(NoFileSize), m_CompressedFileSize(NoFileSize)
 {}
 
-void FileEntry::addOrigin(OriginID origin, FILETIME fileTime, std::wstring_view archive,
-                          int order)
+void FileEntry::addOrigin(OriginID origin, FILETIME fileTime,
+                          const DataArchiveOrigin& archive, bool propagate)
 {
-  std::scoped_lock lock(m_OriginsMutex);
+  std::scoped_lock lock(originsMutex());
 
-  if (m_Parent != nullptr) {
+  if (propagate && m_Parent != nullptr) {
     m_Parent->propagateOrigin(origin);
   }
 
@@ -29,11 +32,11 @@ void FileEntry::addOrigin(OriginID origin, FILETIME fileTime, std::wstring_view
     // alternatives
     m_Origin   = origin;
     m_FileTime = fileTime;
-    m_Archive  = DataArchiveOrigin(std::wstring(archive.begin(), archive.end()), order);
+    m_Archive  = archive;
   } else if ((m_Parent != nullptr) &&
              ((m_Parent->getOriginByID(origin).getPriority() >
                m_Parent->getOriginByID(m_Origin).getPriority()) ||
-              (archive.size() == 0 && m_Archive.isValid()))) {
+              (!archive.isValid() && m_Archive.isValid()))) {
     // If this mod has a higher priority than the origin mod OR
     // this mod has a loose file and the origin mod has an archived file,
     // this mod is now the origin and the previous origin is the first alternative
@@ -49,7 +52,7 @@ void FileEntry::addOrigin(OriginID origin, FILETIME fileTime, std::wstring_view
 
     m_Origin   = origin;
     m_FileTime = fileTime;
-    m_Archive  = DataArchiveOrigin(std::wstring(archive.begin(), archive.end()), order);
+    m_Archive  = archive;
   } else {
     // This mod is just an alternative
     bool found = false;
@@ -68,23 +71,21 @@ void FileEntry::addOrigin(OriginID origin, FILETIME fileTime, std::wstring_view
       if ((m_Parent != nullptr) &&
           (m_Parent->getOriginByID(iter->originID()).getPriority() <
            m_Parent->getOriginByID(origin).getPriority())) {
-        m_Alternatives.insert(
-            iter, {origin, {std::wstring(archive.begin(), archive.end()), order}});
+        m_Alternatives.insert(iter, {origin, archive});
         found = true;
         break;
       }
     }
 
     if (!found) {
-      m_Alternatives.push_back(
-          {origin, {std::wstring(archive.begin(), archive.end()), order}});
+      m_Alternatives.push_back({origin, archive});
     }
   }
 }
 
 bool FileEntry::removeOrigin(OriginID origin)
 {
-  std::scoped_lock lock(m_OriginsMutex);
+  std::scoped_lock lock(originsMutex());
 
   if (m_Origin == origin) {
     if (!m_Alternatives.empty()) {
@@ -122,7 +123,7 @@ bool FileEntry::removeOrigin(OriginID origin)
       m_Origin = currentID;
     } else {
       m_Origin  = -1;
-      m_Archive = DataArchiveOrigin(L"", -1);
+      m_Archive = DataArchiveOrigin();
       return true;
     }
   } else {
@@ -140,7 +141,7 @@ bool FileEntry::removeOrigin(OriginID origin)
 
 void FileEntry::sortOrigins()
 {
-  std::scoped_lock lock(m_OriginsMutex);
+  std::scoped_lock lock(originsMutex());
 
   m_Alternatives.push_back({m_Origin, m_Archive});
 
@@ -186,7 +187,7 @@ void FileEntry::sortOrigins()
 
 bool FileEntry::isFromArchive(std::wstring archiveName) const
 {
-  std::scoped_lock lock(m_OriginsMutex);
+  std::scoped_lock lock(originsMutex());
 
   if (archiveName.length() == 0) {
     return m_Archive.isValid();
@@ -207,7 +208,7 @@ bool FileEntry::isFromArchive(std::wstring archiveName) const
 
 std::wstring FileEntry::getFullPath(OriginID originID) const
 {
-  std::scoped_lock lock(m_OriginsMutex);
+  std::scoped_lock lock(originsMutex());
 
   if (originID == InvalidOriginID) {
     bool ignore = false;
@@ -238,6 +239,11 @@ std::wstring FileEntry::getRelativePath() const
   return result + L"\\" + m_Name;
 }
 
+std::mutex& FileEntry::originsMutex() const
+{
+  return g_originsMutexes[m_Index % g_originsMutexes.size()];
+}
+
 bool FileEntry::recurseParents(std::wstring& path, const DirectoryEntry* parent) const
 {
   if (parent == nullptr) {
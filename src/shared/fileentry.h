@@ -20,8 +20,12 @@ public:
 
   FileIndex getIndex() const { return m_Index; }
 
-  void addOrigin(OriginID origin, FILETIME fileTime, std::wstring_view archive,
-                 int order);
+  // adds the given origin to this file; if `propagate` is false, the parent
+  // directories are not told about the origin, which is used when the caller
+  // already did it for the whole directory
+  //
+  void addOrigin(OriginID origin, FILETIME fileTime, const DataArchiveOrigin& archive,
+                 bool propagate = true);
 
   // remove the specified origin from the list of origins that contain this
   // file. if no origin is left, the file is effectively deleted and true is
@@ -81,7 +85,10 @@ private:
   DirectoryEntry* m_Parent;
   mutable FILETIME m_FileTime;
   uint64_t m_FileSize, m_CompressedFileSize;
-  mutable std::mutex m_OriginsMutex;
+
+  // a std::mutex per entry is too large for millions of files, entries share
+  // a fixed set of mutexes picked by index instead
+  std::mutex& originsMutex() const;
 
   bool recurseParents(std::wstring& path, const DirectoryEntry* parent) const;
 };
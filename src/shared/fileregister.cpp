@@ -3,6 +3,7 @@
 #include "fileentry.h"
 #include "filesorigin.h"
 #include "originconnection.h"
+#include <boost/make_shared.hpp>
 #include <log.h>
 
 namespace MOShared
@@ -11,7 +12,8 @@ namespace MOShared
 using namespace MOBase;
 
 FileRegister::FileRegister(boost::shared_ptr<OriginConnection> originConnection)
-    : m_OriginConnection(originConnection), m_NextIndex(0)
+    : m_Arena(std::make_shared<Arena>()), m_Names(m_Arena),
+      m_OriginConnection(originConnection), m_NextIndex(0)
 {}
 
 bool FileRegister::indexValid(FileIndex index) const
@@ -29,7 +31,7 @@ FileEntryPtr FileRegister::createFile(std::wstring name, DirectoryEntry* parent,
                                       DirectoryStats& stats)
 {
   const auto index = generateIndex();
-  auto p           = FileEntryPtr(new FileEntry(index, std::move(name), parent));
+  auto p           = makeFile(index, std::move(name), parent);
 
   {
     std::scoped_lock lock(m_Mutex);
@@ -44,6 +46,61 @@ FileEntryPtr FileRegister::createFile(std::wstring name, DirectoryEntry* parent,
   return p;
 }
 
+std::shared_ptr<const std::wstring>
+FileRegister::internArchiveName(std::wstring_view name)
+{
+  if (name.empty()) {
+    return {};
+  }
+
+  std::scoped_lock lock(m_ArchiveNamesMutex);
+
+  auto itor = m_ArchiveNames.find(name);
+  if (itor == m_ArchiveNames.end()) {
+    std::wstring s(name);
+    auto p = std::make_shared<const std::wstring>(s);
+    itor   = m_ArchiveNames.emplace(std::move(s), std::move(p)).first;
+  }
+
+  return itor->second;
+}
+
+FileIndex FileRegister::reserveIndices(std::size_t n)
+{
+  return m_NextIndex.fetch_add(static_cast<FileIndex>(n));
+}
+
+FileEntryPtr FileRegister::makeFile(FileIndex index, std::wstring name,
+                                    DirectoryEntry* parent)
+{
+  // the entry and its control block are a single allocation in the arena
+  return boost::allocate_shared<FileEntry>(ArenaAllocator<FileEntry>(m_Arena), index,
+                                           std::move(name), parent);
+}
+
+void FileRegister::addFiles(std::vector<FileEntryPtr> files)
+{
+  if (files.empty()) {
+    return;
+  }
+
+  FileIndex highest = 0;
+  for (auto&& f : files) {
+    highest = std::max(highest, f->getIndex());
+  }
+
+  std::scoped_lock lock(m_Mutex);
+
+  if (highest >= m_Files.size()) {
+    m_Files.resize(highest + 1);
+  }
+
+  for (auto&& f : files) {
+    const auto index = f->getIndex();
+    m_Files[index]   = std::move(f);
+  }
+}
+
 FileIndex FileRegister::generateIndex()
 {
   return m_NextIndex++;
@@ -60,6 +117,23 @@ FileEntryPtr FileRegister::getFile(FileIndex index) const
   }
 }
 
+std::vector<FileEntryPtr> FileRegister::getFiles(FileIndex begin, FileIndex end) const
+{
+  std::vector<FileEntryPtr> files;
+
+  std::scoped_lock lock(m_Mutex);
+
+  end = std::min(end, static_cast<FileIndex>(m_Files.size()));
+
+  for (FileIndex i = begin; i < end; ++i) {
+    if (m_Files[i]) {
+      files.push_back(m_Files[i]);
+    }
+  }
+
+  return files;
+}
+
 bool FileRegister::removeFile(FileIndex index)
 {
   std::scoped_lock lock(m_Mutex);
@@ -162,6 +236,42 @@ void FileRegister::sortOrigins()
   }
 }
 
+void FileRegister::sortOrigins(const std::set<FileIndex>& indices)
+{
+  std::scoped_lock lock(m_Mutex);
+
+  for (const auto index : indices) {
+    if (index < m_Files.size()) {
+      if (const auto& p = m_Files[index]) {
+        p->sortOrigins();
+      }
+    }
+  }
+}
+
+std::set<OriginID> FileRegister::getOrigins(const std::set<FileIndex>& indices) const
+{
+  std::set<OriginID> origins;
+
+  std::scoped_lock lock(m_Mutex);
+
+  for (const auto index : indices) {
+    if (index >= m_Files.size()) {
+      continue;
+    }
+
+    if (const auto& p = m_Files[index]) {
+      origins.insert(p->getOrigin());
+
+      for (const auto& alt : p->getAlternatives()) {
+        origins.insert(alt.originID());
+      }
+    }
+  }
+
+  return origins;
+}
+
 void FileRegister::unregisterFile(FileEntryPtr file)
 {
   bool ignore;
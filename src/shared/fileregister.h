@@ -1,6 +1,7 @@
 #ifndef MO_REGISTER_FILESREGISTER_INCLUDED
 #define MO_REGISTER_FILESREGISTER_INCLUDED
 
+#include "arena.h"
 #include "fileregisterfwd.h"
 #include <boost/shared_ptr.hpp>
 #include <mutex>
@@ -24,6 +25,26 @@ public:
 
   FileEntryPtr getFile(FileIndex index) const;
 
+  // files with an index in [begin, end), removed files are skipped
+  //
+  std::vector<FileEntryPtr> getFiles(FileIndex begin, FileIndex end) const;
+
+  // reserves `n` consecutive indices for makeFile() and returns the first one;
+  // this is used by threads that create many files at once so they don't go
+  // through the mutex for every file
+  //
+  FileIndex reserveIndices(std::size_t n);
+
+  // creates a file with an index from reserveIndices() without adding it to
+  // the register, see addFiles()
+  //
+  FileEntryPtr makeFile(FileIndex index, std::wstring name, DirectoryEntry* parent);
+
+  // adds files created by makeFile() to the register, indices that were
+  // reserved but never used stay empty
+  //
+  void addFiles(std::vector<FileEntryPtr> files);
+
   size_t highestCount() const
   {
     std::scoped_lock lock(m_Mutex);
@@ -36,10 +57,49 @@ public:
 
   void sortOrigins();
 
+  // only sorts the origins of the given files, used when a few origins were
+  // added or moved and all the other files are still sorted
+  void sortOrigins(const std::set<FileIndex>& indices);
+
+  // all the origins providing at least one of the given files, including
+  // alternatives; indices that have been removed are ignored
+  std::set<OriginID> getOrigins(const std::set<FileIndex>& indices) const;
+
+  // arena used for the file entries and for the maps of the directory entries
+  // sharing this register, released when the whole tree is gone
+  //
+  const std::shared_ptr<Arena>& arena() const { return m_Arena; }
+
+  // lowercase file and directory names used as keys by the directory entries,
+  // each distinct name is stored once for the whole tree
+  //
+  std::wstring_view internName(std::wstring_view lcname)
+  {
+    return m_Names.intern(lcname);
+  }
+
+  // drops a reference to a name returned by internName(), called when a key
+  // is removed from a directory entry
+  //
+  void releaseName(std::wstring_view lcname) { m_Names.release(lcname); }
+
+  std::size_t nameCount() const { return m_Names.size(); }
+
+  // archive names referenced by DataArchiveOrigin, each distinct name is
+  // stored once and shared by all the origins using it; this is called once per
+  // archive, not per file
+  //
+  std::shared_ptr<const std::wstring> internArchiveName(std::wstring_view name);
+
 private:
   using FileMap = std::deque<FileEntryPtr>;
 
   mutable std::mutex m_Mutex;
+  std::shared_ptr<Arena> m_Arena;
+  StringPool m_Names;
+  std::mutex m_ArchiveNamesMutex;
+  std::map<std::wstring, std::shared_ptr<const std::wstring>, std::less<>>
+      m_ArchiveNames;
   FileMap m_Files;
   boost::shared_ptr<OriginConnection> m_OriginConnection;
   std::atomic<FileIndex> m_NextIndex;
@@ -1,6 +1,9 @@
 #ifndef MO_REGISTER_FILEREGISTERFWD_INCLUDED
 #define MO_REGISTER_FILEREGISTERFWD_INCLUDED
 
+#include <atomic>
+#include <memory>
+
 class DirectoryRefreshProgress;
 
 namespace MOShared
@@ -27,6 +30,8 @@ class FileRegister;
 class FilesOrigin;
 class FileEntry;
 struct DirectoryStats;
+class ArchiveIndex;
+class ArchiveIndexCache;
 
 using FileEntryPtr = boost::shared_ptr<FileEntry>;
 using FileIndex    = unsigned int;
@@ -39,18 +44,25 @@ constexpr OriginID InvalidOriginID   = -1;
 // is the order of the associated plugin in the plugins list
 // is a file is not in an archive, archiveName is empty and order is usually
 // -1
+//
+// archive names are shared: there are only a few of them but every file
+// coming from an archive references one, sometimes several times through its
+// alternatives, see FileRegister::internArchiveName(); the origin keeps its
+// name alive, so it stays valid even if the file outlives the register
 class DataArchiveOrigin
 {
-  std::wstring name_ = L"";
-  int order_         = -1;
+  static inline const std::wstring s_noName;
+
+  std::shared_ptr<const std::wstring> name_;
+  int order_ = -1;
 
 public:
   int order() const { return order_; }
-  const std::wstring& name() const { return name_; }
+  const std::wstring& name() const { return name_ ? *name_ : s_noName; }
 
-  bool isValid() const { return name_.size() > 0; }
+  bool isValid() const { return name_ && !name_->empty(); }
 
-  DataArchiveOrigin(std::wstring name, int order)
+  DataArchiveOrigin(std::shared_ptr<const std::wstring> name, int order)
       : name_(std::move(name)), order_(order)
   {}
 
@@ -79,7 +91,11 @@ using AlternativesVector = std::vector<FileAlternative>;
 
 struct DirectoryStats
 {
-  static constexpr bool EnableInstrumentation = false;
+  // timers and counters are only updated while this is true, which is the
+  // case when the refresh is being profiled, see RefreshProfiler
+  //
+  static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+  static void setEnabled(bool b) { s_enabled = b; }
 
   std::string mod;
 
@@ -114,6 +130,9 @@ struct DirectoryStats
 
   static std::string csvHeader();
   std::string toCsv() const;
+
+private:
+  static inline std::atomic<bool> s_enabled = false;
 };
 
 }  // namespace MOShared
@@ -34,6 +34,7 @@ public:
   const std::wstring& getPath() const { return m_Path; }
 
   std::vector<FileEntryPtr> getFiles() const;
+  std::set<FileIndex> getFileIndices() const;
   FileEntryPtr findFile(FileIndex index) const;
 
   void enable(bool enabled, DirectoryStats& stats);
@@ -47,6 +48,12 @@ public:
     m_Files.insert(index);
   }
 
+  void addFiles(const std::vector<FileIndex>& indices)
+  {
+    std::scoped_lock lock(m_Mutex);
+    m_Files.insert(indices.begin(), indices.end());
+  }
+
   void removeFile(FileIndex index);
 
   bool containsArchive(std::wstring archiveName);
@@ -0,0 +1,199 @@
+#include "taskpool.h"
+#include "thread_utils.h"
+#include <log.h>
+#include <utility.h>
+
+using namespace MOBase;
+
+namespace MOShared
+{
+
+// pool and queue of the worker running on this thread, if any
+static thread_local TaskPool* t_pool     = nullptr;
+static thread_local std::size_t t_worker = 0;
+
+TaskPool::TaskPool(std::size_t threadCount)
+    : m_queued(0), m_pending(0), m_nextWorker(0), m_stop(false)
+{
+  start(threadCount);
+}
+
+TaskPool::~TaskPool()
+{
+  waitForAll();
+  stop();
+}
+
+void TaskPool::setThreadCount(std::size_t n)
+{
+  if (n == m_workers.size()) {
+    return;
+  }
+
+  waitForAll();
+  stop();
+  start(n);
+}
+
+std::size_t TaskPool::threadCount() const
+{
+  return m_workers.size();
+}
+
+void TaskPool::submit(Task t)
+{
+  if (m_workers.empty()) {
+    // no threads, run inline
+    execute(t);
+    return;
+  }
+
+  // must be counted before it can possibly finish
+  ++m_pending;
+
+  std::size_t index;
+
+  if (t_pool == this) {
+    index = t_worker;
+  } else {
+    index = (m_nextWorker++) % m_workers.size();
+  }
+
+  {
+    auto& w = *m_workers[index];
+    std::scoped_lock lock(w.mutex);
+    w.tasks.push_back(std::move(t));
+  }
+
+  {
+    std::scoped_lock lock(m_mutex);
+    ++m_queued;
+  }
+
+  m_workAvailable.notify_one();
+}
+
+void TaskPool::waitForAll()
+{
+  std::unique_lock lock(m_mutex);
+
+  m_allDone.wait(lock, [&] {
+    return (m_pending == 0);
+  });
+}
+
+void TaskPool::start(std::size_t n)
+{
+  m_stop = false;
+
+  for (std::size_t i = 0; i < n; ++i) {
+    m_workers.push_back(std::make_unique<Worker>());
+  }
+
+  for (std::size_t i = 0; i < n; ++i) {
+    m_workers[i]->thread = startSafeThread([this, i] {
+      run(i);
+    });
+  }
+}
+
+void TaskPool::stop()
+{
+  {
+    std::scoped_lock lock(m_mutex);
+    m_stop = true;
+  }
+
+  m_workAvailable.notify_all();
+
+  for (auto& w : m_workers) {
+    if (w->thread.joinable()) {
+      w->thread.join();
+    }
+  }
+
+  m_workers.clear();
+}
+
+void TaskPool::run(std::size_t index)
+{
+  t_pool   = this;
+  t_worker = index;
+
+  for (;;) {
+    Task t;
+
+    if (take(index, t)) {
+      execute(t);
+      continue;
+    }
+
+    std::unique_lock lock(m_mutex);
+
+    m_workAvailable.wait(lock, [&] {
+      return m_stop || (m_queued > 0);
+    });
+
+    if (m_stop) {
+      break;
+    }
+  }
+
+  t_pool = nullptr;
+}
+
+bool TaskPool::take(std::size_t index, Task& t)
+{
+  // newest task from this worker's queue
+  {
+    auto& w = *m_workers[index];
+    std::scoped_lock lock(w.mutex);
+
+    if (!w.tasks.empty()) {
+      t = std::move(w.tasks.back());
+      w.tasks.pop_back();
+      --m_queued;
+      return true;
+    }
+  }
+
+  // oldest task from any other queue
+  for (std::size_t i = 1; i < m_workers.size(); ++i) {
+    auto& w = *m_workers[(index + i) % m_workers.size()];
+    std::scoped_lock lock(w.mutex);
+
+    if (!w.tasks.empty()) {
+      t = std::move(w.tasks.front());
+      w.tasks.pop_front();
+      --m_queued;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void TaskPool::execute(Task& t)
+{
+  // the task is finished even if it throws, or waitForAll() would never return
+  Guard g([&] {
+    if (m_workers.empty()) {
+      return;
+    }
+
+    if (--m_pending == 0) {
+      std::scoped_lock lock(m_mutex);
+      m_allDone.notify_all();
+    }
+  });
+
+  try {
+    t();
+  } catch (std::exception& e) {
+    log::error("unhandled exception in task: {}", e.what());
+  } catch (...) {
+    log::error("unhandled unknown exception in task");
+  }
+}
+
+}  // namespace MOShared
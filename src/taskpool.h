@@ -0,0 +1,91 @@
+#ifndef MO2_TASKPOOL_H
+#define MO2_TASKPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace MOShared
+{
+
+// fixed set of worker threads executing tasks
+//
+// each worker has its own queue: tasks submitted from a worker thread are
+// pushed on that worker's queue and popped in LIFO order, which keeps
+// recursive work (such as walking a directory tree) local to a thread; tasks
+// submitted from other threads are spread over the queues
+//
+// a worker that runs out of tasks steals the oldest task from another queue
+// and sleeps only when all queues are empty
+//
+class TaskPool
+{
+public:
+  using Task = std::function<void()>;
+
+  TaskPool(std::size_t threadCount = 1);
+  ~TaskPool();
+
+  // noncopyable
+  TaskPool(const TaskPool&)            = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  // waits for all tasks and restarts the pool with the given number of
+  // threads; does nothing if the count doesn't change
+  //
+  void setThreadCount(std::size_t n);
+  std::size_t threadCount() const;
+
+  // queues a task, can be called from any thread, including from within a
+  // task
+  //
+  void submit(Task t);
+
+  // blocks until all submitted tasks have finished, including the tasks that
+  // were submitted by other tasks in the meantime; must not be called from a
+  // task
+  //
+  void waitForAll();
+
+private:
+  struct Worker
+  {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+    std::thread thread;
+  };
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+
+  // protects sleeping and waking up, both for workers waiting for tasks and
+  // for waitForAll()
+  std::mutex m_mutex;
+  std::condition_variable m_workAvailable;
+  std::condition_variable m_allDone;
+
+  // tasks sitting in a queue; can briefly go negative when a task is stolen
+  // before its submitter had time to count it
+  std::atomic<std::ptrdiff_t> m_queued;
+
+  // tasks submitted but not finished yet
+  std::atomic<std::size_t> m_pending;
+
+  std::atomic<std::size_t> m_nextWorker;
+  bool m_stop;
+
+  void start(std::size_t n);
+  void stop();
+
+  void run(std::size_t index);
+  bool take(std::size_t index, Task& t);
+  void execute(Task& t);
+};
+
+}  // namespace MOShared
+
+#endif  // MO2_TASKPOOL_H
@@ -0,0 +1,433 @@
+#include "thumbnailloader.h"
+#include "settings.h"
+#include "thread_utils.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QSaveFile>
+#include <algorithm>
+#include <log.h>
+
+using namespace MOBase;
+
+namespace
+{
+
+// sizes of the generated thumbnails, larger requests use the last one
+constexpr int ThumbnailSizes[] = {128, 256, 512, 1024, 2048};
+
+// stored in the cached files
+const char* OriginalSizeKey = "mo-original-size";
+
+// size of the image fitting in a `size` by `size` square, never larger than
+// the original
+//
+QSize fitIn(const QSize& original, int size)
+{
+  if (original.width() <= size && original.height() <= size) {
+    return original;
+  }
+
+  return original.scaled(size, size, Qt::KeepAspectRatio);
+}
+
+}  // namespace
+
+ThumbnailLoader::ThumbnailLoader(std::size_t threadCount, QObject* parent)
+    : QObject(parent), m_Generation(0), m_Stop(false)
+{
+  m_CacheDir = Settings::instance().paths().cache() + "/thumbnails";
+
+  if (!QDir().mkpath(m_CacheDir)) {
+    log::warn("can't create thumbnail cache directory '{}'", m_CacheDir);
+    m_CacheDir.clear();
+  }
+
+  if (threadCount == 0) {
+    // decoding is mostly cpu bound, but leave some room for the ui
+    const std::size_t cores = std::thread::hardware_concurrency();
+    threadCount             = std::clamp<std::size_t>(cores / 2, 1, 4);
+  }
+
+  for (std::size_t i = 0; i < threadCount; ++i) {
+    m_Threads.push_back(MOShared::startSafeThread([this, i] {
+      threadFun(i);
+    }));
+  }
+}
+
+ThumbnailLoader::~ThumbnailLoader()
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    m_Stop = true;
+    m_Queue.clear();
+    m_Original.reset();
+
+    for (auto& job : m_Running) {
+      *job.cancelled = true;
+    }
+  }
+
+  m_WorkAvailable.notify_all();
+
+  for (auto& t : m_Threads) {
+    t.join();
+  }
+}
+
+int ThumbnailLoader::thumbnailSize(int size)
+{
+  for (const int s : ThumbnailSizes) {
+    if (size <= s) {
+      return s;
+    }
+  }
+
+  return ThumbnailSizes[std::size(ThumbnailSizes) - 1];
+}
+
+void ThumbnailLoader::load(const std::vector<Request>& requests)
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    auto requested = [&](const Job& job) {
+      return std::any_of(requests.begin(), requests.end(), [&](auto&& r) {
+        return (r.path == job.path && thumbnailSize(r.size) == job.size);
+      });
+    };
+
+    // running jobs that scrolled away are cancelled, the others are not
+    // queued again
+    for (auto& job : m_Running) {
+      if (!job.original && !requested(job)) {
+        *job.cancelled = true;
+      }
+    }
+
+    m_Queue.clear();
+
+    for (const auto& r : requests) {
+      Job job;
+      job.id         = r.id;
+      job.path       = r.path;
+      job.size       = thumbnailSize(r.size);
+      job.generation = m_Generation;
+
+      const bool running =
+          std::any_of(m_Running.begin(), m_Running.end(), [&](auto&& rj) {
+            return (!rj.original && !*rj.cancelled && rj.path == job.path &&
+                    rj.size == job.size);
+          });
+
+      if (!running) {
+        job.cancelled = std::make_shared<std::atomic<bool>>(false);
+        m_Queue.push_back(std::move(job));
+      }
+    }
+  }
+
+  m_WorkAvailable.notify_all();
+}
+
+void ThumbnailLoader::loadOriginal(std::size_t id, const QString& path)
+{
+  {
+    std::scoped_lock lock(m_Mutex);
+
+    // the previous original is not needed anymore
+    for (auto& job : m_Running) {
+      if (job.original) {
+        *job.cancelled = true;
+      }
+    }
+
+    Job job;
+    job.id         = id;
+    job.path       = path;
+    job.original   = true;
+    job.generation = m_Generation;
+    job.cancelled  = std::make_shared<std::atomic<bool>>(false);
+
+    m_Original = std::move(job);
+  }
+
+  m_WorkAvailable.notify_one();
+}
+
+void ThumbnailLoader::cancel()
+{
+  std::scoped_lock lock(m_Mutex);
+
+  ++m_Generation;
+  m_Queue.clear();
+  m_Original.reset();
+
+  for (auto& job : m_Running) {
+    *job.cancelled = true;
+  }
+}
+
+void ThumbnailLoader::threadFun(std::size_t index)
+{
+  if (index == 0) {
+    pruneCache();
+  }
+
+  for (;;) {
+    Job job;
+
+    {
+      std::unique_lock lock(m_Mutex);
+
+      m_WorkAvailable.wait(lock, [&] {
+        return (m_Stop || m_Original || !m_Queue.empty());
+      });
+
+      if (m_Stop) {
+        return;
+      }
+
+      if (m_Original) {
+        job = std::move(*m_Original);
+        m_Original.reset();
+      } else {
+        job = std::move(m_Queue.front());
+        m_Queue.pop_front();
+      }
+
+      m_Running.push_back(job);
+    }
+
+    if (job.original) {
+      runOriginal(job);
+    } else {
+      runThumbnail(job);
+    }
+
+    {
+      std::scoped_lock lock(m_Mutex);
+
+      auto itor = std::find_if(m_Running.begin(), m_Running.end(), [&](auto&& j) {
+        return (j.cancelled == job.cancelled);
+      });
+
+      if (itor != m_Running.end()) {
+        m_Running.erase(itor);
+      }
+    }
+  }
+}
+
+void ThumbnailLoader::runThumbnail(const Job& job)
+{
+  if (*job.cancelled) {
+    return;
+  }
+
+  const auto cached = cachePath(job.path, job.size);
+
+  QImage image;
+  QSize originalSize;
+
+  if (cached.isEmpty() || !readCache(cached, image, originalSize)) {
+    QImageReader reader(job.path);
+    originalSize = reader.size();
+
+    // some formats like jpeg can decode directly at a smaller size, which is
+    // much faster than decoding the whole image
+    if (originalSize.isValid() &&
+        reader.supportsOption(QImageIOHandler::ScaledSize)) {
+      reader.setScaledSize(fitIn(originalSize, job.size));
+    }
+
+    if (!reader.read(&image)) {
+      log::error("failed to load '{}'\n{} (error {})", job.path, reader.errorString(),
+                 static_cast<int>(reader.error()));
+
+      image = {};
+    } else {
+      if (!originalSize.isValid()) {
+        originalSize = image.size();
+      }
+
+      const auto scaledSize = fitIn(image.size(), job.size);
+      if (scaledSize != image.size()) {
+        image =
+            image.scaled(scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+      }
+
+      // the decoding is done, so the thumbnail is cached even if the job was
+      // cancelled in the meantime
+      if (!cached.isEmpty()) {
+        writeCache(cached, image, originalSize);
+      }
+    }
+  }
+
+  if (*job.cancelled) {
+    return;
+  }
+
+  QMetaObject::invokeMethod(
+      this,
+      [this, job, image, originalSize] {
+        if (current(job)) {
+          emit thumbnailLoaded(job.id, job.path, job.size, image, originalSize);
+        }
+      },
+      Qt::QueuedConnection);
+}
+
+void ThumbnailLoader::runOriginal(const Job& job)
+{
+  if (*job.cancelled) {
+    return;
+  }
+
+  QImageReader reader(job.path);
+  QImage image;
+
+  if (!reader.read(&image)) {
+    log::error("failed to load '{}'\n{} (error {})", job.path, reader.errorString(),
+               static_cast<int>(reader.error()));
+
+    image = {};
+  }
+
+  if (*job.cancelled) {
+    return;
+  }
+
+  QMetaObject::invokeMethod(
+      this,
+      [this, job, image] {
+        if (current(job)) {
+          emit originalLoaded(job.id, job.path, image);
+        }
+      },
+      Qt::QueuedConnection);
+}
+
+bool ThumbnailLoader::current(const Job& job)
+{
+  std::scoped_lock lock(m_Mutex);
+  return (job.generation == m_Generation && !*job.cancelled);
+}
+
+QString ThumbnailLoader::cachePath(const QString& path, int size) const
+{
+  if (m_CacheDir.isEmpty()) {
+    return {};
+  }
+
+  const QFileInfo fi(path);
+  if (!fi.exists()) {
+    return {};
+  }
+
+  const auto key = QString("%1|%2|%3|%4")
+                       .arg(QDir::fromNativeSeparators(path).toLower())
+                       .arg(fi.size())
+                       .arg(fi.lastModified().toMSecsSinceEpoch())
+                       .arg(size);
+
+  const auto hash =
+      QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5).toHex();
+
+  return m_CacheDir + "/" + QString::fromLatin1(hash) + ".png";
+}
+
+bool ThumbnailLoader::readCache(const QString& cachePath, QImage& image,
+                                QSize& originalSize) const
+{
+  if (!QFileInfo::exists(cachePath)) {
+    return false;
+  }
+
+  QImageReader reader(cachePath, "png");
+
+  const auto parts = reader.text(OriginalSizeKey).split('x');
+  if (parts.size() != 2) {
+    return false;
+  }
+
+  const QSize size(parts[0].toInt(), parts[1].toInt());
+  if (!size.isValid()) {
+    return false;
+  }
+
+  QImage cached;
+  if (!reader.read(&cached)) {
+    log::debug("failed to read cached thumbnail '{}', {}", cachePath,
+               reader.errorString());
+    return false;
+  }
+
+  image        = std::move(cached);
+  originalSize = size;
+
+  // pruneCache() removes the files that were used the longest time ago
+  QFile file(cachePath);
+  if (file.open(QIODevice::Append)) {
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+  }
+
+  return true;
+}
+
+void ThumbnailLoader::writeCache(const QString& cachePath, QImage image,
+                                 QSize originalSize) const
+{
+  image.setText(OriginalSizeKey, QString("%1x%2")
+                                     .arg(originalSize.width())
+                                     .arg(originalSize.height()));
+
+  // other threads never see a partial file
+  QSaveFile file(cachePath);
+
+  if (!file.open(QIODevice::WriteOnly)) {
+    log::debug("can't write thumbnail '{}', {}", cachePath, file.errorString());
+    return;
+  }
+
+  QImageWriter writer(&file, "png");
+
+  if (!writer.write(image)) {
+    log::debug("can't write thumbnail '{}', {}", cachePath, writer.errorString());
+    file.cancelWriting();
+    return;
+  }
+
+  if (!file.commit()) {
+    log::debug("can't write thumbnail '{}', {}", cachePath, file.errorString());
+  }
+}
+
+void ThumbnailLoader::pruneCache() const
+{
+  if (m_CacheDir.isEmpty()) {
+    return;
+  }
+
+  const auto files = QDir(m_CacheDir).entryInfoList(
+      {"*.png"}, QDir::Files, QDir::Time | QDir::Reversed);
+
+  if (files.size() <= MaxCachedFiles) {
+    return;
+  }
+
+  // least recently used first, readCache() updates the time
+  const auto remove = files.size() - MaxCachedFiles;
+
+  for (int i = 0; i < remove; ++i) {
+    QFile::remove(files[i].absoluteFilePath());
+  }
+
+  log::debug("removed {} old thumbnails from '{}'", remove, m_CacheDir);
+}
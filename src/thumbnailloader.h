@@ -0,0 +1,131 @@
+#ifndef MODORGANIZER_THUMBNAILLOADER_INCLUDED
+#define MODORGANIZER_THUMBNAILLOADER_INCLUDED
+
+#include <QImage>
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// decodes and scales images on worker threads for the images tab, and keeps
+// the thumbnails in a cache on disk so they don't have to be decoded again
+//
+// thumbnails are requested by the ui for what's currently visible; each call
+// to load() replaces everything that was still queued, so thumbnails that
+// were scrolled away before a thread got to them are never decoded
+//
+// thumbnails are generated for a few fixed sizes, see thumbnailSize(), so
+// resizing the dialog doesn't invalidate them
+//
+class ThumbnailLoader : public QObject
+{
+  Q_OBJECT
+
+public:
+  struct Request
+  {
+    // given back in signals
+    std::size_t id;
+
+    QString path;
+
+    // largest dimension of the thumbnail, rounded up by thumbnailSize()
+    int size;
+  };
+
+  // maximum number of files in the cache, the least recently used ones are
+  // removed when the loader starts
+  static constexpr int MaxCachedFiles = 20000;
+
+  // uses a few threads if `threadCount` is 0
+  //
+  explicit ThumbnailLoader(std::size_t threadCount = 0, QObject* parent = nullptr);
+
+  // cancels everything and waits for the running jobs
+  ~ThumbnailLoader();
+
+  // size of the thumbnails generated for the given size
+  //
+  static int thumbnailSize(int size);
+
+  // replaces the queued thumbnails by the given ones, in order of priority;
+  // running jobs that are not in the list are cancelled
+  //
+  void load(const std::vector<Request>& requests);
+
+  // decodes the full image, this is done before any queued thumbnail; replaces
+  // the previous one if it hasn't started yet
+  //
+  void loadOriginal(std::size_t id, const QString& path);
+
+  // drops everything, including results of running jobs
+  //
+  void cancel();
+
+signals:
+  // `image` is null if the file couldn't be read; `originalSize` is the size
+  // of the full image
+  //
+  void thumbnailLoaded(std::size_t id, QString path, int size, QImage image,
+                       QSize originalSize);
+
+  // `image` is null if the file couldn't be read
+  //
+  void originalLoaded(std::size_t id, QString path, QImage image);
+
+private:
+  struct Job
+  {
+    QString path;
+    std::size_t id           = 0;
+    int size                 = 0;
+    bool original            = false;
+    std::uint64_t generation = 0;
+    std::shared_ptr<std::atomic<bool>> cancelled;
+  };
+
+  std::vector<std::thread> m_Threads;
+  QString m_CacheDir;
+
+  std::mutex m_Mutex;
+  std::condition_variable m_WorkAvailable;
+  std::deque<Job> m_Queue;
+  std::optional<Job> m_Original;
+  std::vector<Job> m_Running;
+
+  // incremented by cancel(), results of older jobs are discarded
+  std::uint64_t m_Generation;
+
+  bool m_Stop;
+
+  void threadFun(std::size_t index);
+  void runThumbnail(const Job& job);
+  void runOriginal(const Job& job);
+
+  // whether the result of the job can still be reported, must be called on
+  // the thread of the loader
+  //
+  bool current(const Job& job);
+
+  // path of the cached thumbnail for the given file and size, based on its
+  // path, size and last modification time
+  //
+  QString cachePath(const QString& path, int size) const;
+
+  bool readCache(const QString& cachePath, QImage& image, QSize& originalSize) const;
+  void writeCache(const QString& cachePath, QImage image, QSize originalSize) const;
+
+  // removes the least recently used thumbnails when there are too many
+  //
+  void pruneCache() const;
+};
+
+#endif  // MODORGANIZER_THUMBNAILLOADER_INCLUDED
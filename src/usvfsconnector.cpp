@@ -182,10 +182,12 @@ void UsvfsConnector::updateMapping(const MappingType& mapping)
 {
   const auto start = std::chrono::high_resolution_clock::now();
 
+  // only shown if linking takes a while, which is rare now that most files
+  // are linked through their directory
   QProgressDialog progress(qApp->activeWindow());
   progress.setLabelText(tr("Preparing vfs"));
   progress.setMaximum(static_cast<int>(mapping.size()));
-  progress.show();
+  progress.setMinimumDuration(500);
 
   int value = 0;
   int files = 0;
@@ -200,8 +202,8 @@ void UsvfsConnector::updateMapping(const MappingType& mapping)
       ClearVirtualMappings();
       throw UsvfsConnectorException("VFS mapping canceled by user");
     }
-    progress.setValue(value++);
-    if (value % 10 == 0) {
+    if (++value % 100 == 0) {
+      progress.setValue(value);
       QCoreApplication::processEvents();
     }
 
@@ -0,0 +1,311 @@
+#include "vfsmappingplanner.h"
+#include "shared/directoryentry.h"
+#include "shared/fileentry.h"
+#include "shared/filesorigin.h"
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <log.h>
+#include <unordered_map>
+
+using namespace MOBase;
+using namespace MOShared;
+
+namespace
+{
+
+// owner of a file or directory that has files from more than one origin, the
+// other possible owners are an origin or InvalidOriginID for nothing loose
+constexpr OriginID MixedOrigins = -2;
+
+QString cleanPath(const std::wstring& path)
+{
+  auto s = QDir::toNativeSeparators(QString::fromStdWString(path));
+
+  while (s.endsWith('\\')) {
+    s.chop(1);
+  }
+
+  return s;
+}
+
+class Planner
+{
+public:
+  Planner(const DirectoryEntry& root, const QString& dataPath, MappingType& out,
+          VfsMappingPlanner::Stats& stats)
+      : m_Root(root), m_DataPath(cleanPath(dataPath.toStdWString())), m_Out(out),
+        m_Stats(stats)
+  {}
+
+  void run()
+  {
+    const auto o = owner(m_Root);
+
+    if (o == MixedOrigins) {
+      addDirectory(m_Root, {});
+    } else if (o != InvalidOriginID) {
+      addLink(o, {}, true);
+    }
+  }
+
+private:
+  const DirectoryEntry& m_Root;
+  const QString m_DataPath;
+  MappingType& m_Out;
+  VfsMappingPlanner::Stats& m_Stats;
+
+  // filled by owner()
+  std::unordered_map<const DirectoryEntry*, OriginID> m_Owners;
+
+  // path of each origin, empty for origins that are in the data directory
+  std::unordered_map<OriginID, QString> m_Paths;
+
+  // the origin all the loose files of this directory come from, computed for
+  // the whole tree before anything is added
+  //
+  OriginID owner(const DirectoryEntry& d)
+  {
+    OriginID o = InvalidOriginID;
+
+    auto merge = [&](OriginID other) {
+      if (other == InvalidOriginID || other == o) {
+        return;
+      }
+
+      o = (o == InvalidOriginID ? other : MixedOrigins);
+    };
+
+    d.forEachFile([&](const FileEntry& f) {
+      merge(fileOwner(f));
+      return true;
+    });
+
+    // all subdirectories are needed by addDirectory(), even when this one is
+    // already mixed
+    d.forEachDirectory([&](const DirectoryEntry& sub) {
+      merge(owner(sub));
+      return true;
+    });
+
+    m_Owners[&d] = o;
+    return o;
+  }
+
+  OriginID fileOwner(const FileEntry& f) const
+  {
+    bool archive      = false;
+    const auto origin = f.getOrigin(archive);
+
+    OriginID o = (archive ? InvalidOriginID : origin);
+
+    for (const auto& alt : f.getAlternatives()) {
+      if (alt.isFromArchive()) {
+        continue;
+      }
+
+      if (o != InvalidOriginID && o != alt.originID()) {
+        return MixedOrigins;
+      }
+
+      o = alt.originID();
+    }
+
+    return o;
+  }
+
+  // origin of the loose file that wins, InvalidOriginID if there are none
+  //
+  OriginID winner(const FileEntry& f) const
+  {
+    bool archive      = false;
+    const auto origin = f.getOrigin(archive);
+
+    if (!archive) {
+      return origin;
+    }
+
+    OriginID best    = InvalidOriginID;
+    int bestPriority = 0;
+
+    for (const auto& alt : f.getAlternatives()) {
+      if (alt.isFromArchive()) {
+        continue;
+      }
+
+      const auto* o = m_Root.findOriginByID(alt.originID());
+      if (!o) {
+        continue;
+      }
+
+      if (best == InvalidOriginID || o->getPriority() > bestPriority) {
+        best         = alt.originID();
+        bestPriority = o->getPriority();
+      }
+    }
+
+    return best;
+  }
+
+  // adds the links for a directory that has files from several origins,
+  // `relPath` is empty or ends with a separator
+  //
+  void addDirectory(const DirectoryEntry& d, const QString& relPath)
+  {
+    d.forEachFile([&](const FileEntry& f) {
+      const auto o = winner(f);
+
+      if (o != InvalidOriginID) {
+        addLink(o, relPath + QString::fromStdWString(f.getName()), false);
+      }
+
+      return true;
+    });
+
+    d.forEachDirectory([&](const DirectoryEntry& sub) {
+      const auto o    = m_Owners[&sub];
+      const auto path = relPath + QString::fromStdWString(sub.getName());
+
+      if (o == MixedOrigins) {
+        addDirectory(sub, path + "\\");
+      } else if (o != InvalidOriginID) {
+        addLink(o, path, true);
+      } else {
+        addEmptyDirectory(sub, path);
+      }
+
+      return true;
+    });
+  }
+
+  // adds a link for a directory without loose files, such as an empty
+  // directory or one that only has files from archives, so it's visible like
+  // when whole mod folders are linked; the origin with the highest priority
+  // that has it on disk is linked, archives have no directories on disk
+  //
+  void addEmptyDirectory(const DirectoryEntry& d, const QString& relPath)
+  {
+    std::vector<std::pair<int, OriginID>> origins;
+
+    for (const auto id : d.getOrigins()) {
+      if (const auto* o = m_Root.findOriginByID(id)) {
+        origins.push_back({o->getPriority(), id});
+      }
+    }
+
+    std::sort(origins.begin(), origins.end(), std::greater<>());
+
+    for (const auto& [priority, id] : origins) {
+      const auto& originPath = path(id);
+
+      if (originPath.isEmpty()) {
+        // in the data directory, already visible
+        if (QFileInfo(m_DataPath + "\\" + relPath).isDir()) {
+          return;
+        }
+
+        continue;
+      }
+
+      if (QFileInfo(originPath + "\\" + relPath).isDir()) {
+        addLink(id, relPath, true);
+        return;
+      }
+    }
+  }
+
+  void addLink(OriginID origin, const QString& relPath, bool directory)
+  {
+    const auto& originPath = path(origin);
+    if (originPath.isEmpty()) {
+      return;
+    }
+
+    QString source = originPath, target = m_DataPath;
+
+    if (!relPath.isEmpty()) {
+      source += "\\" + relPath;
+      target += "\\" + relPath;
+    }
+
+    m_Out.push_back({source, target, directory, false});
+
+    if (directory) {
+      ++m_Stats.directories;
+    } else {
+      ++m_Stats.files;
+    }
+  }
+
+  const QString& path(OriginID origin)
+  {
+    auto itor = m_Paths.find(origin);
+
+    if (itor == m_Paths.end()) {
+      QString p;
+
+      if (const auto* o = m_Root.findOriginByID(origin)) {
+        p = cleanPath(o->getPath());
+
+        if (p.compare(m_DataPath, Qt::CaseInsensitive) == 0) {
+          p.clear();
+        }
+      } else {
+        log::error("vfs plan: origin {} not found", origin);
+      }
+
+      itor = m_Paths.emplace(origin, std::move(p)).first;
+    }
+
+    return itor->second;
+  }
+};
+
+}  // namespace
+
+MappingType VfsMappingPlanner::plan(const DirectoryEntry& root, const QString& dataPath,
+                                    Stats* stats)
+{
+  MappingType out;
+  Stats s;
+
+  Planner(root, dataPath, out, s).run();
+
+  if (stats) {
+    *stats = s;
+  }
+
+  return out;
+}
+
+const MappingType& VfsMappingPlanner::mappings(const DirectoryEntry& root,
+                                               const QString& key,
+                                               const QString& dataPath)
+{
+  if (m_Plan && m_Key == key && m_DataPath == dataPath) {
+    log::debug("vfs plan: reusing {} links for '{}'", m_Plan->size(), key);
+    return *m_Plan;
+  }
+
+  const auto start = std::chrono::high_resolution_clock::now();
+
+  Stats stats;
+  m_Plan     = plan(root, dataPath, &stats);
+  m_Key      = key;
+  m_DataPath = dataPath;
+
+  const auto end  = std::chrono::high_resolution_clock::now();
+  const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+  log::debug("vfs plan: {} directories and {} files for '{}' in {}ms",
+             stats.directories, stats.files, key, time.count());
+
+  return *m_Plan;
+}
+
+void VfsMappingPlanner::invalidate()
+{
+  m_Plan.reset();
+}
@@ -0,0 +1,63 @@
+#ifndef MODORGANIZER_VFSMAPPINGPLANNER_INCLUDED
+#define MODORGANIZER_VFSMAPPINGPLANNER_INCLUDED
+
+#include "shared/fileregisterfwd.h"
+#include <QString>
+#include <filemapping.h>
+#include <optional>
+
+// builds the links given to usvfs from the directory structure
+//
+// linking every mod folder recursively makes usvfs walk all of them and
+// resolve the conflicts again, but the structure already knows which origin
+// provides each file; the plan only has:
+//   - one recursive link for each directory where all the files come from a
+//     single origin, without looking into it,
+//   - one link per file in the other directories, from the origin that wins
+//     the file,
+//   - one recursive link for each directory without loose files that exists
+//     on disk in a mod, such as empty directories, so they're still visible
+//
+// files that are only in archives are not linked, and neither are origins
+// that are in the data directory itself, like the data origin or some dlcs
+//
+// the planner only needs a DirectoryEntry, so it can be used on a structure
+// built by hand
+//
+class VfsMappingPlanner
+{
+public:
+  struct Stats
+  {
+    std::size_t directories = 0;
+    std::size_t files       = 0;
+  };
+
+  // builds the links for the given structure to the given data directory,
+  // nothing is cached; the links don't create anything, the caller must
+  // add a link for the write target after them
+  //
+  // files that are not in the structure are not linked, the caller must make
+  // sure it's up to date, see OrganizerCore::fileMapping()
+  //
+  static MappingType plan(const MOShared::DirectoryEntry& root, const QString& dataPath,
+                          Stats* stats = nullptr);
+
+  // returns the same as plan(), but reuses the last plan if `key` and
+  // `dataPath` are the same as last time and invalidate() hasn't been called
+  // since; `key` is typically the profile name
+  //
+  const MappingType& mappings(const MOShared::DirectoryEntry& root, const QString& key,
+                              const QString& dataPath);
+
+  // forgets the last plan, must be called when the structure changes
+  //
+  void invalidate();
+
+private:
+  QString m_Key;
+  QString m_DataPath;
+  std::optional<MappingType> m_Plan;
+};
+
+#endif  // MODORGANIZER_VFSMAPPINGPLANNER_INCLUDED